@@ -0,0 +1,177 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "basic_test.h"
+#include "test_init.h"
+
+// Std
+#include <string>
+#include <mutex>
+#include <unordered_map>
+
+// hermes
+#include "hermes_shm/thread/lock.h"
+#include <hermes_shm/data_structures/ipc/unordered_map.h>
+#include <hermes_shm/data_structures/ipc/concurrent_unordered_map.h>
+
+/**
+ * Thread-scaling tests for maps shared by many threads. Maps without
+ * internal synchronization are wrapped in a single lock.
+ * OUTPUT:
+ * [test_name] [map_type] [nthreads] [time_ms] [ops_per_usec]
+ * */
+template<typename MapT,
+  typename MapTPtr=SHM_X_OR_Y(MapT, hipc::mptr<MapT>, MapT*)>
+class ConcurrentMapTest {
+ public:
+  std::string map_type_;
+  MapT *map_;
+  MapTPtr map_ptr_;
+  hshm::Mutex lock_;
+  void *ptr_;
+
+  /**====================================
+   * Test Runner
+   * ===================================*/
+
+  /** Test case constructor */
+  ConcurrentMapTest() {
+    if constexpr(std::is_same_v<std::unordered_map<size_t, size_t>, MapT>) {
+      map_type_ = "std::unordered_map+lock";
+    } else if constexpr(std::is_same_v<hipc::unordered_map<size_t, size_t>,
+                                       MapT>) {
+      map_type_ = "hipc::unordered_map+lock";
+    } else if constexpr(std::is_same_v<
+      hipc::concurrent_unordered_map<size_t, size_t>, MapT>) {
+      map_type_ = "hipc::concurrent_unordered_map";
+    } else {
+      HELOG(kFatal, "none of the map tests matched")
+    }
+    lock_.Init();
+  }
+
+  /** Run the tests */
+  void Test(size_t count_per_rank = 100000, int nthreads = 1) {
+    Allocate();
+    EmplaceTest(count_per_rank, nthreads);
+    GetTest(count_per_rank, nthreads);
+    Destroy();
+  }
+
+  /**====================================
+   * Tests
+   * ===================================*/
+
+  /** Each thread emplaces a disjoint set of keys */
+  void EmplaceTest(size_t count_per_rank, int nthreads) {
+    Timer t;
+    size_t count = count_per_rank * nthreads;
+    t.Resume();
+    omp_set_dynamic(0);
+#pragma omp parallel num_threads(nthreads)
+    {
+      size_t rank = omp_get_thread_num();
+      for (size_t i = 0; i < count_per_rank; ++i) {
+        Emplace(i * nthreads + rank);
+      }
+    }
+    t.Pause();
+    TestOutput("Emplace", t, count, nthreads);
+  }
+
+  /** Each thread looks up every key emplaced by all threads */
+  void GetTest(size_t count_per_rank, int nthreads) {
+    Timer t;
+    size_t count = count_per_rank * nthreads;
+    t.Resume();
+    omp_set_dynamic(0);
+#pragma omp parallel num_threads(nthreads)
+    {
+      size_t rank = omp_get_thread_num();
+      for (size_t i = 0; i < count_per_rank; ++i) {
+        Get((i * nthreads + rank * count_per_rank) % count);
+      }
+    }
+    t.Pause();
+    TestOutput("Get", t, count, nthreads);
+  }
+
+ private:
+  /**====================================
+   * Helpers
+   * ===================================*/
+
+  /** Output as CSV */
+  void TestOutput(const std::string &test_name, Timer &t,
+                  size_t count, int nthreads) {
+    HIPRINT("{},{},{},{},{}\n",
+            test_name, map_type_, nthreads, t.GetMsec(),
+            (float)count / t.GetUsec())
+  }
+
+  /** Emplace a key */
+  void Emplace(size_t key) {
+    if constexpr(std::is_same_v<MapT,
+      hipc::concurrent_unordered_map<size_t, size_t>>) {
+      map_->emplace(key, key);
+    } else {
+      hshm::ScopedMutex lock(lock_, 0);
+      map_->emplace(key, key);
+    }
+  }
+
+  /** Look up a key */
+  void Get(size_t key) {
+    size_t val = 0;
+    if constexpr(std::is_same_v<MapT,
+      hipc::concurrent_unordered_map<size_t, size_t>>) {
+      map_->find(key, val);
+    } else {
+      hshm::ScopedMutex lock(lock_, 0);
+      val = (*map_)[key];
+    }
+    USE(val);
+  }
+
+  /** Allocate the map */
+  void Allocate() {
+    if constexpr(std::is_same_v<MapT, std::unordered_map<size_t, size_t>>) {
+      map_ptr_ = new MapT();
+      map_ = map_ptr_;
+    } else {
+      map_ptr_ = hipc::make_mptr<MapT>(5000);
+      map_ = map_ptr_.get();
+    }
+  }
+
+  /** Destroy the map */
+  void Destroy() {
+    if constexpr(std::is_same_v<MapT, std::unordered_map<size_t, size_t>>) {
+      delete map_ptr_;
+    } else {
+      map_ptr_.shm_destroy();
+    }
+  }
+};
+
+TEST_CASE("ConcurrentUnorderedMapBenchmark") {
+  size_t count_per_rank = 100000;
+  for (int nthreads : {1, 2, 4, 8, 16}) {
+    ConcurrentMapTest<std::unordered_map<size_t, size_t>>().Test(
+      count_per_rank, nthreads);
+    ConcurrentMapTest<hipc::unordered_map<size_t, size_t>>().Test(
+      count_per_rank, nthreads);
+    ConcurrentMapTest<hipc::concurrent_unordered_map<size_t, size_t>>().Test(
+      count_per_rank, nthreads);
+  }
+}
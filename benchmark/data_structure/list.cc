@@ -24,6 +24,7 @@
 #include "hermes_shm/data_structures/ipc/string.h"
 #include <hermes_shm/data_structures/ipc/list.h>
 #include <hermes_shm/data_structures/ipc/slist.h>
+#include <hermes_shm/data_structures/ipc/unrolled_list.h>
 
 template<typename T>
 using bipc_list = bipc::list<T, typename BoostAllocator<T>::alloc_t>;
@@ -42,6 +43,9 @@ class ListTest {
   ListT *lp_;
   ListTPtr list_ptr_;
   void *ptr_;
+  static constexpr bool HAS_NODE_POOL =
+    std::is_same_v<ListT, hipc::list<T>> ||
+    std::is_same_v<ListT, hipc::slist<T>>;
 
   /**====================================
    * Test Runner
@@ -57,6 +61,8 @@ class ListTest {
       list_type_ = "bipc_list";
     } else if constexpr(std::is_same_v<hipc::slist<T>, ListT>) {
       list_type_ = "hipc::slist";
+    } else if constexpr(std::is_same_v<hipc::unrolled_list<T>, ListT>) {
+      list_type_ = "hipc::unrolled_list";
     } else {
       HELOG(kFatal, "none of the list tests matched")
     }
@@ -69,6 +75,11 @@ class ListTest {
     AllocateTest(count);
     EmplaceTest(count);
     ForwardIteratorTest(count);
+    QueueTest(count * 10, 64, false);
+    if constexpr(HAS_NODE_POOL) {
+      QueueTest(count * 10, 64, true);
+      ChunkedForwardIteratorTest(count, 64);
+    }
     CopyTest(count);
     MoveTest(count);
   }
@@ -124,6 +135,47 @@ class ListTest {
     Destroy();
   }
 
+  /** Use the list as a FIFO of fixed depth */
+  void QueueTest(size_t count, size_t depth, bool pooled) {
+    Timer t;
+    StringOrInt<T> var(124);
+
+    Allocate();
+    if constexpr(HAS_NODE_POOL) {
+      if (pooled) {
+        lp_->enable_node_pool(depth);
+      }
+    }
+    Emplace(depth);
+    t.Resume();
+    for (size_t i = 0; i < count; ++i) {
+      lp_->emplace_back(var.Get());
+      lp_->erase(lp_->begin());
+    }
+    t.Pause();
+
+    TestOutput(pooled ? "PooledQueue" : "Queue", t);
+    Destroy();
+  }
+
+  /** Iterator performance when nodes are carved from chunks */
+  void ChunkedForwardIteratorTest(size_t count, size_t chunk_nodes) {
+    Timer t;
+
+    Allocate();
+    lp_->enable_node_pool(0, chunk_nodes);
+    Emplace(count);
+
+    t.Resume();
+    for (auto &x : *lp_) {
+      USE(x);
+    }
+    t.Pause();
+
+    TestOutput("ChunkedForwardIterator", t);
+    Destroy();
+  }
+
   /** Copy performance */
   void CopyTest(size_t count) {
     Timer t;
@@ -207,6 +259,8 @@ class ListTest {
         lp_->emplace_back(var.Get());
       } else if constexpr(std::is_same_v<ListT, hipc::slist<T>>) {
         lp_->emplace_back(var.Get());
+      } else if constexpr(std::is_same_v<ListT, hipc::unrolled_list<T>>) {
+        lp_->emplace_back(var.Get());
       }
     }
   }
@@ -219,6 +273,9 @@ class ListTest {
     } if constexpr(std::is_same_v<ListT, hipc::slist<T>>) {
       list_ptr_ = hipc::make_mptr<ListT>();
       lp_ = list_ptr_.get();
+    } else if constexpr(std::is_same_v<ListT, hipc::unrolled_list<T>>) {
+      list_ptr_ = hipc::make_mptr<ListT>();
+      lp_ = list_ptr_.get();
     } else if constexpr (std::is_same_v<ListT, bipc_list<T>>) {
       list_ptr_ = BOOST_SEGMENT->construct<ListT>("BoostList")(
         BOOST_ALLOCATOR((std::pair<int, T>)));
@@ -235,6 +292,8 @@ class ListTest {
       list_ptr_.shm_destroy();
     } else if constexpr(std::is_same_v<ListT, hipc::slist<T>>) {
       list_ptr_.shm_destroy();
+    } else if constexpr(std::is_same_v<ListT, hipc::unrolled_list<T>>) {
+      list_ptr_.shm_destroy();
     } else if constexpr(std::is_same_v<ListT, std::list<T>>) {
       delete list_ptr_;
     } else if constexpr (std::is_same_v<ListT, bipc_list<T>>) {
@@ -262,6 +321,11 @@ void FullListTest() {
   ListTest<size_t, hipc::slist<size_t>>().Test();
   ListTest<std::string, hipc::slist<std::string>>().Test();
   ListTest<hipc::string, hipc::slist<hipc::string>>().Test();
+
+  // hipc::unrolled_list tests
+  ListTest<size_t, hipc::unrolled_list<size_t>>().Test();
+  ListTest<std::string, hipc::unrolled_list<std::string>>().Test();
+  ListTest<hipc::string, hipc::unrolled_list<hipc::string>>().Test();
 }
 
 TEST_CASE("ListBenchmark") {
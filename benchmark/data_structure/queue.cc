@@ -14,6 +14,9 @@
 #include "test_init.h"
 
 // Std
+#include <pthread.h>
+#include <sched.h>
+#include <sys/sysinfo.h>
 #include <string>
 #include <queue>
 
@@ -22,8 +25,10 @@
 #include "hermes_shm/data_structures/ipc/split_ticket_queue.h"
 #include "hermes_shm/data_structures/ipc/mpsc_ptr_queue.h"
 #include <hermes_shm/data_structures/ipc/mpsc_queue.h>
+#include <hermes_shm/data_structures/ipc/mpmc_queue.h>
 #include <hermes_shm/data_structures/ipc/spsc_queue.h>
 #include <hermes_shm/data_structures/ipc/ticket_queue.h>
+#include <hermes_shm/data_structures/ipc/byte_ring.h>
 
 /**
  * A series of performance tests for vectors
@@ -42,13 +47,14 @@ class QueueTest {
   hipc::uptr<T> x_;
   std::mutex lock_;
   int cpu_;
+  bool affine_;
 
   /**====================================
    * Test Runner
    * ===================================*/
 
   /** Test case constructor */
-  QueueTest() {
+  explicit QueueTest(bool affine = false) : affine_(affine) {
     if constexpr(std::is_same_v<std::queue<T>, QueueT>) {
       queue_type_ = "std::queue";
     } else if constexpr(std::is_same_v<hipc::mpsc_queue<T>, QueueT>) {
@@ -60,7 +66,10 @@ class QueueTest {
     } else if constexpr(std::is_same_v<hipc::ticket_queue<T>, QueueT>) {
       queue_type_ = "hipc::ticket_queue";
     } else if constexpr(std::is_same_v<hipc::split_ticket_queue<T>, QueueT>) {
-      queue_type_ = "hipc::split_ticket_queue";
+      queue_type_ = affine_ ? "hipc::split_ticket_queue(affine)" :
+                    "hipc::split_ticket_queue";
+    } else if constexpr(std::is_same_v<hipc::mpmc_queue<T>, QueueT>) {
+      queue_type_ = "hipc::mpmc_queue";
     } else {
       HELOG(kFatal, "none of the queue tests matched")
     }
@@ -75,6 +84,12 @@ class QueueTest {
     DequeueTest(count_per_rank, nthreads);
   }
 
+  /** Run the tests with emplace_n and pop_n */
+  void BatchTest(size_t count, size_t batch) {
+    EmplaceBatchTest(count, batch);
+    DequeueBatchTest(count, batch);
+  }
+
   /**====================================
    * Tests
    * ===================================*/
@@ -123,6 +138,40 @@ class QueueTest {
     Destroy();
   }
 
+  /** Emplace in batches of \a batch elements */
+  void EmplaceBatchTest(size_t count, size_t batch) {
+    Timer t;
+    std::vector<T> vals(batch, StringOrInt<T>(124).Get());
+
+    Allocate(count, count, 1);
+    t.Resume();
+    for (size_t i = 0; i < count; i += batch) {
+      queue_->emplace_n(vals.data(), batch);
+    }
+    t.Pause();
+
+    TestOutput("EnqueueBatch" + std::to_string(batch), t, count, 1);
+    Destroy();
+  }
+
+  /** Dequeue in batches of \a batch elements */
+  void DequeueBatchTest(size_t count, size_t batch) {
+    Timer t;
+    std::vector<T> vals(batch);
+
+    Allocate(count, count, 1);
+    Emplace(count, 1);
+    t.Resume();
+    for (size_t i = 0; i < count; i += batch) {
+      queue_->pop_n(vals.data(), batch);
+      USE(vals[0]);
+    }
+    t.Pause();
+
+    TestOutput("DequeueBatch" + std::to_string(batch), t, count, 1);
+    Destroy();
+  }
+
  private:
   /**====================================
    * Helpers
@@ -158,6 +207,8 @@ class QueueTest {
         } else if constexpr(
           std::is_same_v<QueueT, hipc::split_ticket_queue<T>>) {
           queue_->emplace(var.Get());
+        } else if constexpr(std::is_same_v<QueueT, hipc::mpmc_queue<T>>) {
+          queue_->emplace(var.Get());
         }
       }
     }
@@ -189,6 +240,8 @@ class QueueTest {
         } else if constexpr(
           std::is_same_v<QueueT, hipc::split_ticket_queue<T>>) {
           while (queue_->pop(*x_).IsNull());
+        } else if constexpr(std::is_same_v<QueueT, hipc::mpmc_queue<T>>) {
+          while (queue_->pop(*x_).IsNull());
         }
       }
     }
@@ -213,7 +266,11 @@ class QueueTest {
       queue_ptr_ = hipc::make_mptr<QueueT>(count);
       queue_ = queue_ptr_.get();
     } else if constexpr(std::is_same_v<QueueT, hipc::split_ticket_queue<T>>) {
-      queue_ptr_ = hipc::make_mptr<QueueT>(count_per_rank, nthreads);
+      queue_ptr_ = hipc::make_mptr<QueueT>(count_per_rank, nthreads,
+                                           affine_);
+      queue_ = queue_ptr_.get();
+    } else if constexpr(std::is_same_v<QueueT, hipc::mpmc_queue<T>>) {
+      queue_ptr_ = hipc::make_mptr<QueueT>(count);
       queue_ = queue_ptr_.get();
     }
   }
@@ -232,6 +289,8 @@ class QueueTest {
       queue_ptr_.shm_destroy();
     } else if constexpr(std::is_same_v<QueueT, hipc::split_ticket_queue<T>>) {
       queue_ptr_.shm_destroy();
+    } else if constexpr(std::is_same_v<QueueT, hipc::mpmc_queue<T>>) {
+      queue_ptr_.shm_destroy();
     }
   }
 };
@@ -244,18 +303,19 @@ void FullQueueTest() {
 //  QueueTest<size_t, std::queue<size_t>>().Test(count_per_rank, 8);
 //  QueueTest<size_t, std::queue<size_t>>().Test(count_per_rank, 16);
 //  QueueTest<std::string, std::queue<std::string>>().Test();
-//
-//  // hipc::ticket_queue tests
-//  QueueTest<size_t, hipc::ticket_queue<size_t>>().Test(count_per_rank, 1);
-//  QueueTest<size_t, hipc::ticket_queue<size_t>>().Test(count_per_rank, 4);
-//  QueueTest<size_t, hipc::ticket_queue<size_t>>().Test(count_per_rank, 8);
-//  QueueTest<size_t, hipc::ticket_queue<size_t>>().Test(count_per_rank, 16);
-//
-//  // hipc::ticket_queue tests
-//  QueueTest<size_t, hipc::split_ticket_queue<size_t>>().Test(count_per_rank, 1);
-//  QueueTest<size_t, hipc::split_ticket_queue<size_t>>().Test(count_per_rank, 4);
-//  QueueTest<size_t, hipc::split_ticket_queue<size_t>>().Test(count_per_rank, 8);
-//  QueueTest<size_t, hipc::split_ticket_queue<size_t>>().Test(count_per_rank, 16);
+
+  // MPMC queues: a fixed total count split across 1 to 64 threads
+  for (int nthreads = 1; nthreads <= 64; nthreads *= 2) {
+    size_t per_rank = count_per_rank / nthreads;
+    QueueTest<size_t, hipc::ticket_queue<size_t>>().Test(
+      per_rank, nthreads);
+    QueueTest<size_t, hipc::split_ticket_queue<size_t>>().Test(
+      per_rank, nthreads);
+    QueueTest<size_t, hipc::split_ticket_queue<size_t>>(true).Test(
+      per_rank, nthreads);
+    QueueTest<size_t, hipc::mpmc_queue<size_t>>().Test(
+      per_rank, nthreads);
+  }
 
   // hipc::mpsc_queue tests
   QueueTest<size_t, hipc::mpsc_queue<size_t>>().Test(count_per_rank, 1);
@@ -265,6 +325,16 @@ void FullQueueTest() {
   // hipc::mpsc_ptr_queue tests
   QueueTest<size_t, hipc::mpsc_ptr_queue<size_t>>().Test(count_per_rank, 1);
 
+  // Batched emplace_n / pop_n
+  for (size_t batch = 4; batch <= 64; batch *= 4) {
+    QueueTest<size_t, hipc::mpsc_queue<size_t>>().BatchTest(
+      count_per_rank, batch);
+    QueueTest<size_t, hipc::mpsc_ptr_queue<size_t>>().BatchTest(
+      count_per_rank, batch);
+    QueueTest<size_t, hipc::spsc_queue<size_t>>().BatchTest(
+      count_per_rank, batch);
+  }
+
   // hipc::spsc_queue tests
   QueueTest<size_t, hipc::spsc_queue<size_t>>().Test(count_per_rank, 1);
   QueueTest<std::string, hipc::spsc_queue<std::string>>().Test();
@@ -275,3 +345,114 @@ void FullQueueTest() {
 TEST_CASE("QueueBenchmark") {
   FullQueueTest();
 }
+
+/**
+ * Bounce a message between two threads on different CPUs through a pair
+ * of queues and report the round-trip latency. With a single message in
+ * flight, the cost is dominated by cache lines moving between the cores.
+ * */
+template<typename QueueT, typename ...Args>
+void PingPongTest(const std::string &queue_type, size_t count,
+                  Args&& ...args) {
+  auto ping = hipc::make_uptr<QueueT>(64, args...);
+  auto pong = hipc::make_uptr<QueueT>(64, args...);
+  int ncpu = get_nprocs();
+  Timer t;
+
+  omp_set_dynamic(0);
+#pragma omp parallel shared(ping, pong, t) num_threads(2)
+  {  // NOLINT
+    int rank = omp_get_thread_num();
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(rank % ncpu, &cpus);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    size_t msg;
+#pragma omp barrier
+    if (rank == 0) {
+      t.Resume();
+      for (size_t i = 0; i < count; ++i) {
+        ping->emplace(i);
+        while (pong->pop(msg).IsNull()) {}
+      }
+      t.Pause();
+    } else {
+      for (size_t i = 0; i < count; ++i) {
+        while (ping->pop(msg).IsNull()) {}
+        pong->emplace(msg);
+      }
+    }
+  }
+
+  HIPRINT("PingPong,{},{},{},{}\n",
+          queue_type, count, t.GetMsec(), t.GetNsec() / count)
+}
+
+TEST_CASE("QueuePingPongBenchmark") {
+  const size_t count = (1 << 16);
+  PingPongTest<hipc::mpsc_queue<size_t>>("hipc::mpsc_queue", count);
+  PingPongTest<hipc::mpsc_queue<size_t>>(
+    "hipc::mpsc_queue(padded slots)", count, true);
+  PingPongTest<hipc::spsc_queue<size_t>>("hipc::spsc_queue", count);
+  PingPongTest<hipc::mpsc_ptr_queue<size_t>>("hipc::mpsc_ptr_queue", count);
+  PingPongTest<hipc::mpmc_queue<size_t>>("hipc::mpmc_queue", count);
+}
+
+/**
+ * Pass \a count variable-length messages of up to \a max_size bytes
+ * through a queue, 32 at a time. hipc::byte_ring writes each message in
+ * place, while hipc::mpsc_queue<hipc::string> allocates a string for it.
+ * */
+template<typename QueueT>
+void MessageTest(const std::string &queue_type, size_t count,
+                 size_t max_size) {
+  const size_t batch = 32;
+  std::vector<char> msg(max_size, 1);
+  Timer t;
+
+  if constexpr(std::is_same_v<QueueT, hipc::byte_ring>) {
+    auto ring = hipc::make_uptr<QueueT>(batch * 2 * (max_size + 16));
+    t.Resume();
+    for (size_t i = 0; i < count; i += batch) {
+      for (size_t j = 0; j < batch; ++j) {
+        size_t len = 1 + (i + j) * 37 % max_size;
+        char *data = ring->reserve(len);
+        memcpy(data, msg.data(), len);
+        ring->commit(data);
+      }
+      for (size_t j = 0; j < batch; ++j) {
+        size_t len;
+        ring->peek(len);
+        ring->release();
+      }
+    }
+    t.Pause();
+  } else {
+    auto queue = hipc::make_uptr<QueueT>(batch);
+    auto val = hipc::make_uptr<hipc::string>(0);
+    t.Resume();
+    for (size_t i = 0; i < count; i += batch) {
+      for (size_t j = 0; j < batch; ++j) {
+        size_t len = 1 + (i + j) * 37 % max_size;
+        queue->emplace(msg.data(), len);
+      }
+      for (size_t j = 0; j < batch; ++j) {
+        queue->pop(*val);
+      }
+    }
+    t.Pause();
+  }
+
+  HIPRINT("Message,{},{},{},{},{}\n",
+          queue_type, max_size, count, t.GetMsec(),
+          (float)count / t.GetUsec())
+}
+
+TEST_CASE("QueueMessageBenchmark") {
+  const size_t count = (1 << 20);
+  for (size_t max_size = 64; max_size <= 4096; max_size *= 4) {
+    MessageTest<hipc::byte_ring>("hipc::byte_ring", count, max_size);
+    MessageTest<hipc::mpsc_queue<hipc::string>>(
+      "hipc::mpsc_queue<hipc::string>", count, max_size);
+  }
+}
@@ -0,0 +1,176 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "basic_test.h"
+#include "test_init.h"
+
+// Std
+#include <string>
+#include <map>
+
+// hermes
+#include "hermes_shm/thread/lock.h"
+#include <hermes_shm/data_structures/ipc/skiplist_map.h>
+
+/**
+ * Thread-scaling tests for ordered maps shared by many threads.
+ * std::map is wrapped in a single lock.
+ * OUTPUT:
+ * [test_name] [map_type] [nthreads] [time_ms] [ops_per_usec]
+ * */
+template<typename MapT,
+  typename MapTPtr=SHM_X_OR_Y(MapT, hipc::mptr<MapT>, MapT*)>
+class OrderedMapTest {
+ public:
+  std::string map_type_;
+  MapT *map_;
+  MapTPtr map_ptr_;
+  hshm::Mutex lock_;
+  void *ptr_;
+
+  /**====================================
+   * Test Runner
+   * ===================================*/
+
+  /** Test case constructor */
+  OrderedMapTest() {
+    if constexpr(std::is_same_v<std::map<size_t, size_t>, MapT>) {
+      map_type_ = "std::map+lock";
+    } else if constexpr(std::is_same_v<hipc::skiplist_map<size_t, size_t>,
+                                       MapT>) {
+      map_type_ = "hipc::skiplist_map";
+    } else {
+      HELOG(kFatal, "none of the map tests matched")
+    }
+    lock_.Init();
+  }
+
+  /** Run the tests */
+  void Test(size_t count_per_rank = 100000, int nthreads = 1) {
+    Allocate();
+    EmplaceTest(count_per_rank, nthreads);
+    ScanTest(count_per_rank, nthreads);
+    Destroy();
+  }
+
+  /**====================================
+   * Tests
+   * ===================================*/
+
+  /** Each thread emplaces a disjoint, interleaved set of keys */
+  void EmplaceTest(size_t count_per_rank, int nthreads) {
+    Timer t;
+    size_t count = count_per_rank * nthreads;
+    t.Resume();
+    omp_set_dynamic(0);
+#pragma omp parallel num_threads(nthreads)
+    {
+      size_t rank = omp_get_thread_num();
+      for (size_t i = 0; i < count_per_rank; ++i) {
+        Emplace(i * nthreads + rank);
+      }
+    }
+    t.Pause();
+    TestOutput("Emplace", t, count, nthreads);
+  }
+
+  /** Each thread scans ranges of 16 keys */
+  void ScanTest(size_t count_per_rank, int nthreads) {
+    Timer t;
+    size_t count = count_per_rank * nthreads;
+    size_t nscans = count_per_rank / 16;
+    t.Resume();
+    omp_set_dynamic(0);
+#pragma omp parallel num_threads(nthreads)
+    {
+      size_t rank = omp_get_thread_num();
+      for (size_t i = 0; i < nscans; ++i) {
+        Scan(((i * nthreads + rank) * 16) % count, 16);
+      }
+    }
+    t.Pause();
+    TestOutput("Scan16", t, nscans * nthreads * 16, nthreads);
+  }
+
+ private:
+  /**====================================
+   * Helpers
+   * ===================================*/
+
+  /** Output as CSV */
+  void TestOutput(const std::string &test_name, Timer &t,
+                  size_t count, int nthreads) {
+    HIPRINT("{},{},{},{},{}\n",
+            test_name, map_type_, nthreads, t.GetMsec(),
+            (float)count / t.GetUsec())
+  }
+
+  /** Emplace a key */
+  void Emplace(size_t key) {
+    if constexpr(std::is_same_v<MapT, std::map<size_t, size_t>>) {
+      hshm::ScopedMutex lock(lock_, 0);
+      map_->emplace(key, key);
+    } else {
+      map_->emplace(key, key);
+    }
+  }
+
+  /** Sum the values of \a len keys starting at \a lo */
+  void Scan(size_t lo, size_t len) {
+    size_t sum = 0;
+    if constexpr(std::is_same_v<MapT, std::map<size_t, size_t>>) {
+      hshm::ScopedMutex lock(lock_, 0);
+      auto iter = map_->lower_bound(lo);
+      for (size_t i = 0; i < len && iter != map_->end(); ++i, ++iter) {
+        sum += iter->second;
+      }
+    } else {
+      size_t keys[16], vals[16];
+      size_t n = map_->scan(lo, lo + len, keys, vals, len);
+      for (size_t i = 0; i < n; ++i) {
+        sum += vals[i];
+      }
+    }
+    USE(sum);
+  }
+
+  /** Allocate the map */
+  void Allocate() {
+    if constexpr(std::is_same_v<MapT, std::map<size_t, size_t>>) {
+      map_ptr_ = new MapT();
+      map_ = map_ptr_;
+    } else {
+      map_ptr_ = hipc::make_mptr<MapT>();
+      map_ = map_ptr_.get();
+    }
+  }
+
+  /** Destroy the map */
+  void Destroy() {
+    if constexpr(std::is_same_v<MapT, std::map<size_t, size_t>>) {
+      delete map_ptr_;
+    } else {
+      map_ptr_.shm_destroy();
+    }
+  }
+};
+
+TEST_CASE("SkiplistMapBenchmark") {
+  size_t count_per_rank = 100000;
+  for (int nthreads : {1, 2, 4, 8, 16}) {
+    OrderedMapTest<std::map<size_t, size_t>>().Test(
+      count_per_rank, nthreads);
+    OrderedMapTest<hipc::skiplist_map<size_t, size_t>>().Test(
+      count_per_rank, nthreads);
+  }
+}
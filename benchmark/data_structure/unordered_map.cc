@@ -17,12 +17,16 @@
 #include <boost/unordered_map.hpp>
 
 // Std
+#include <algorithm>
+#include <random>
 #include <string>
 #include <unordered_map>
 
 // hermes
 #include "hermes_shm/data_structures/ipc/string.h"
 #include <hermes_shm/data_structures/ipc/unordered_map.h>
+#include <hermes_shm/data_structures/ipc/flat_hash_map.h>
+#include <hermes_shm/data_structures/ipc/dense_unordered_map.h>
 
 template<typename Key, typename T>
 using bipc_unordered_map = boost::unordered_map<
@@ -57,6 +61,11 @@ class UnorderedMapTest {
       map_type_ = "hipc::unordered_map";
     } else if constexpr(std::is_same_v<bipc_unordered_map<size_t, T>, MapT>) {
       map_type_ = "bipc::unordered_map";
+    } else if constexpr(std::is_same_v<hipc::flat_hash_map<size_t, T>, MapT>) {
+      map_type_ = "hipc::flat_hash_map";
+    } else if constexpr(std::is_same_v<hipc::dense_unordered_map<size_t, T>,
+                                       MapT>) {
+      map_type_ = "hipc::dense_unordered_map";
     } else {
       std::cout << "INVALID: none of the unordered_map tests matched"
       << std::endl;
@@ -72,6 +81,15 @@ class UnorderedMapTest {
     EmplaceTest(count);
     GetTest(count);
     ForwardIteratorTest(count);
+    if constexpr(std::is_same_v<MapT, hipc::unordered_map<size_t, T>> ||
+                 std::is_same_v<MapT, hipc::dense_unordered_map<size_t, T>>) {
+      SparseIteratorTest(count / 10, 100 * count);
+    }
+    GrowthTest(10 * count, false);
+    if constexpr(std::is_same_v<MapT, hipc::unordered_map<size_t, T>>) {
+      GrowthTest(10 * count, true);
+      BatchGetTest(10 * count, 32);
+    }
     // CopyTest(count);
     // MoveTest(count);
   }
@@ -142,6 +160,93 @@ class UnorderedMapTest {
     Destroy();
   }
 
+  /** Iterator performance of a map with many more buckets than entries */
+  void SparseIteratorTest(size_t count, int num_buckets) {
+    Timer t;
+    Allocate(num_buckets);
+    Emplace(count);
+
+    t.Resume();
+    for (auto &x : *map_) {
+      USE(x);
+    }
+    t.Pause();
+
+    TestOutput("SparseForwardIterator", t);
+    Destroy();
+  }
+
+  /**
+   * Emplace and get performance of a map which starts with few buckets.
+   * Also reports the slowest single emplace, which is dominated by
+   * rehashing unless the map grows incrementally.
+   * */
+  void GrowthTest(size_t count, bool incremental) {
+    Timer t, slowest;
+    StringOrInt<T> var(124);
+    std::string suffix = incremental ? "Incremental" : "";
+
+    Allocate(20, incremental);
+    t.Resume();
+    for (size_t i = 0; i < count; ++i) {
+      Timer op;
+      op.Resume();
+      EmplaceOne(i, var);
+      op.Pause();
+      if (op.GetNsec() > slowest.GetNsec()) {
+        slowest = op;
+      }
+    }
+    t.Pause();
+    TestOutput("GrowEmplace" + suffix, t);
+    TestOutput("GrowEmplaceMaxOp" + suffix, slowest);
+
+    t.Reset();
+    t.Resume();
+    for (size_t i = 0; i < count; ++i) {
+      Get(i);
+    }
+    t.Pause();
+    TestOutput("GrowGet" + suffix, t);
+    Destroy();
+  }
+
+  /**
+   * Lookups of random keys in a large table, one at a time and in batches
+   * of \a batch_size keys
+   * */
+  void BatchGetTest(size_t count, size_t batch_size) {
+    Timer t;
+    std::vector<size_t> keys(count);
+    for (size_t i = 0; i < count; ++i) {
+      keys[i] = i;
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(0));
+
+    Allocate();
+    Emplace(count);
+
+    t.Resume();
+    for (size_t i = 0; i < count; ++i) {
+      auto iter = map_->find(keys[i]);
+      USE(*iter);
+    }
+    t.Pause();
+    TestOutput("RandomGet", t);
+
+    std::vector<typename MapT::iterator_t> out(batch_size);
+    t.Reset();
+    t.Resume();
+    for (size_t i = 0; i < count; i += batch_size) {
+      size_t n = std::min(batch_size, count - i);
+      map_->find_batch(keys.data() + i, n, out.data());
+      USE(out[0]);
+    }
+    t.Pause();
+    TestOutput("RandomGetBatch", t);
+    Destroy();
+  }
+
   /** Copy performance */
   void CopyTest(size_t count) {
     Timer t;
@@ -205,6 +310,11 @@ class UnorderedMapTest {
     } else if constexpr(std::is_same_v<MapT, hipc::unordered_map<size_t, T>>) {
       T &x = (*map_)[i];
       USE(x);
+    } else if constexpr(std::is_same_v<MapT, hipc::flat_hash_map<size_t, T>> ||
+                        std::is_same_v<MapT,
+                                       hipc::dense_unordered_map<size_t, T>>) {
+      T &x = (*map_)[i];
+      USE(x);
     }
   }
 
@@ -212,20 +322,36 @@ class UnorderedMapTest {
   void Emplace(size_t count) {
     StringOrInt<T> var(124);
     for (size_t i = 0; i < count; ++i) {
-      if constexpr(std::is_same_v<MapT, std::unordered_map<size_t, T>>) {
-        map_->emplace(i, var.Get());
-      } else if constexpr(std::is_same_v<MapT, bipc_unordered_map<size_t, T>>) {
-        map_->emplace(i, var.Get());
-      } else if constexpr(std::is_same_v<MapT, hipc::unordered_map<size_t, T>>) {
-        map_->emplace(i, var.Get());
-      }
+      EmplaceOne(i, var);
+    }
+  }
+
+  /** Emplace the element at position i */
+  void EmplaceOne(size_t i, StringOrInt<T> &var) {
+    if constexpr(std::is_same_v<MapT, std::unordered_map<size_t, T>>) {
+      map_->emplace(i, var.Get());
+    } else if constexpr(std::is_same_v<MapT, bipc_unordered_map<size_t, T>>) {
+      map_->emplace(i, var.Get());
+    } else if constexpr(std::is_same_v<MapT, hipc::unordered_map<size_t, T>>) {
+      map_->emplace(i, var.Get());
+    } else if constexpr(std::is_same_v<MapT, hipc::flat_hash_map<size_t, T>> ||
+                        std::is_same_v<MapT,
+                                       hipc::dense_unordered_map<size_t, T>>) {
+      map_->emplace(i, var.Get());
     }
   }
 
   /** Allocate an arbitrary unordered_map for the test cases */
-  void Allocate() {
+  void Allocate(int num_buckets = 5000, bool incremental = false) {
     if constexpr(std::is_same_v<MapT, hipc::unordered_map<size_t, T>>) {
-      map_ptr_ = hipc::make_mptr<MapT>(5000);
+      map_ptr_ = hipc::make_mptr<MapT>(
+        num_buckets, hshm::RealNumber(4, 5), hshm::RealNumber(5, 4),
+        incremental);
+      map_ = map_ptr_.get();
+    } else if constexpr(std::is_same_v<MapT, hipc::flat_hash_map<size_t, T>> ||
+                        std::is_same_v<MapT,
+                                       hipc::dense_unordered_map<size_t, T>>) {
+      map_ptr_ = hipc::make_mptr<MapT>(num_buckets);
       map_ = map_ptr_.get();
     } else if constexpr(std::is_same_v<MapT, std::unordered_map<size_t, T>>) {
       map_ptr_ = new std::unordered_map<size_t, T>();
@@ -239,7 +365,9 @@ class UnorderedMapTest {
 
   /** Destroy the unordered_map */
   void Destroy() {
-    if constexpr(std::is_same_v<MapT, hipc::unordered_map<size_t, T>>) {
+    if constexpr(std::is_same_v<MapT, hipc::unordered_map<size_t, T>> ||
+                 std::is_same_v<MapT, hipc::flat_hash_map<size_t, T>> ||
+                 std::is_same_v<MapT, hipc::dense_unordered_map<size_t, T>>) {
       map_ptr_.shm_destroy();
     } else if constexpr(std::is_same_v<MapT, std::unordered_map<size_t, T>>) {
       delete map_ptr_;
@@ -263,6 +391,14 @@ void FullUnorderedMapTest() {
   UnorderedMapTest<size_t, hipc::unordered_map<size_t, size_t>>().Test();
   UnorderedMapTest<std::string, hipc::unordered_map<size_t, std::string>>().Test();
   UnorderedMapTest<hipc::string, hipc::unordered_map<size_t, hipc::string>>().Test();
+
+  // hipc::flat_hash_map tests
+  UnorderedMapTest<size_t, hipc::flat_hash_map<size_t, size_t>>().Test();
+
+  // hipc::dense_unordered_map tests
+  UnorderedMapTest<size_t, hipc::dense_unordered_map<size_t, size_t>>().Test();
+  UnorderedMapTest<hipc::string,
+                   hipc::dense_unordered_map<size_t, hipc::string>>().Test();
 }
 
 TEST_CASE("UnorderedMapBenchmark") {
@@ -71,6 +71,9 @@ class VectorTest {
     BeginIteratorTest(count);
     EndIteratorTest(count);
     ForwardIteratorTest(count);
+    GrowEmplaceTest(count);
+    EraseFrontTest(count / 100, count / 1000);
+    BulkAppendTest(count, 1000);
     // CopyTest(count);
     // MoveTest(count);
   }
@@ -121,6 +124,50 @@ class VectorTest {
     Destroy();
   }
 
+  /** Emplace without reserving, so the vector grows repeatedly */
+  void GrowEmplaceTest(size_t count) {
+    Timer t;
+    Allocate();
+    t.Resume();
+    Emplace(count);
+    t.Pause();
+
+    TestOutput("GrowEmplace", t);
+    Destroy();
+  }
+
+  /** Erase the front of a vector, shifting every other element left */
+  void EraseFrontTest(size_t count, size_t erase_count) {
+    Timer t;
+    Allocate();
+    Emplace(count);
+    t.Resume();
+    for (size_t i = 0; i < erase_count; ++i) {
+      vec_->erase(vec_->begin());
+    }
+    t.Pause();
+
+    TestOutput("EraseFront", t);
+    Destroy();
+  }
+
+  /** Append batches of elements copied from a C-style array */
+  void BulkAppendTest(size_t count, size_t batch) {
+    if constexpr(std::is_arithmetic_v<T>) {
+      Timer t;
+      std::vector<T> src(batch, 124);
+      Allocate();
+      t.Resume();
+      for (size_t i = 0; i < count; i += batch) {
+        vec_->insert(vec_->end(), src.data(), src.data() + batch);
+      }
+      t.Pause();
+
+      TestOutput("BulkAppend", t);
+      Destroy();
+    }
+  }
+
   /** Get performance */
   void GetTest(size_t count) {
     Timer t;
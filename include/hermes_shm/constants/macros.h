@@ -64,6 +64,11 @@
 #define HSHM_ALWAYS_INLINE \
   inline __attribute__((always_inline))
 
+/** The size of a cache line in bytes */
+#ifndef HSHM_CACHE_LINE_SIZE
+#define HSHM_CACHE_LINE_SIZE 64
+#endif
+
 #define MARK_FIRST_BIT_MASK(T) ((T)1 << (sizeof(T) * 8 - 1))
 #define MARK_FIRST_BIT(T, X) ((X) | MARK_FIRST_BIT_MASK(T))
 #define IS_FIRST_BIT_MARKED(T, X) ((X) & MARK_FIRST_BIT_MASK(T))
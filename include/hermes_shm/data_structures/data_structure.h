@@ -27,11 +27,20 @@
 #include "ipc/list.h"
 #include "ipc/vector.h"
 #include "ipc/mpsc_queue.h"
+#include "ipc/mpmc_queue.h"
+#include "ipc/byte_ring.h"
 #include "ipc/slist.h"
+#include "ipc/unrolled_list.h"
 #include "ipc/split_ticket_queue.h"
 #include "ipc/spsc_queue.h"
 #include "ipc/ticket_queue.h"
 #include "ipc/unordered_map.h"
+#include "ipc/dense_unordered_map.h"
+#include "ipc/concurrent_unordered_map.h"
+#include "ipc/flat_hash_map.h"
+#include "ipc/btree_map.h"
+#include "ipc/skiplist_map.h"
+#include "ipc/lru_cache.h"
 #include "ipc/pod_array.h"
 
 #include "serialization/serialize_common.h"
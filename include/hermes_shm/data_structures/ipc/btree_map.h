@@ -0,0 +1,1092 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+* Distributed under BSD 3-Clause license.                                   *
+* Copyright by The HDF Group.                                               *
+* Copyright by the Illinois Institute of Technology.                        *
+* All rights reserved.                                                      *
+*                                                                           *
+* This file is part of Hermes. The full Hermes copyright notice, including  *
+* terms governing use, modification, and redistribution, is contained in    *
+* the COPYING file, which can be found at the top directory. If you do not  *
+* have access to the file, you may request a copy from help@hdfgroup.org.   *
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HERMES_DATA_STRUCTURES_BTREE_MAP_H_
+#define HERMES_DATA_STRUCTURES_BTREE_MAP_H_
+
+#include <atomic>
+#include <vector>
+#include <type_traits>
+#include "hermes_shm/data_structures/ipc/internal/shm_internal.h"
+#include "hermes_shm/thread/lock.h"
+
+namespace hshm::ipc {
+
+/** forward pointer for btree_map */
+template<typename Key, typename T, size_t NODE_SIZE = 256>
+class btree_map;
+
+/** A (key, value) entry stored in a btree_map leaf */
+template<typename Key, typename T>
+struct btree_map_entry {
+  Key key_;
+  T val_;
+
+  /** Get the key */
+  HSHM_ALWAYS_INLINE Key& GetKey() { return key_; }
+  /** Get the key (const) */
+  HSHM_ALWAYS_INLINE const Key& GetKey() const { return key_; }
+  /** Get the value */
+  HSHM_ALWAYS_INLINE T& GetVal() { return val_; }
+  /** Get the value (const) */
+  HSHM_ALWAYS_INLINE const T& GetVal() const { return val_; }
+};
+
+/**
+ * The header of every btree_map node. The version is a sequence lock:
+ * it is odd while a writer modifies the node, and changes whenever the
+ * node is modified. Readers use it to validate what they read.
+ * */
+struct btree_node_header {
+  std::atomic<uint64_t> version_;
+  uint32_t count_;  /**< Entries in a leaf, or keys in an inner node */
+  uint32_t is_leaf_;  /**< Whether the node is a leaf. Never changes. */
+
+  /** Initialize an unlinked node */
+  HSHM_ALWAYS_INLINE void Init(bool is_leaf) {
+    version_.store(0, std::memory_order_relaxed);
+    count_ = 0;
+    is_leaf_ = is_leaf;
+  }
+
+  /** Wait until no writer modifies the node and get its version */
+  HSHM_ALWAYS_INLINE uint64_t ReadLock() const {
+    uint64_t version;
+    while ((version = version_.load(std::memory_order_acquire)) & 1) {
+      HERMES_THREAD_MODEL->Yield();
+    }
+    return version;
+  }
+
+  /** Whether the node is unmodified since ReadLock returned \a version */
+  HSHM_ALWAYS_INLINE bool ReadValidate(uint64_t version) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version_.load(std::memory_order_relaxed) == version;
+  }
+
+  /** Mark the node as being modified. Only the writer may call this. */
+  HSHM_ALWAYS_INLINE void WriteLock() {
+    uint64_t version = version_.load(std::memory_order_relaxed);
+    version_.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  /** Publish the modifications of the writer */
+  HSHM_ALWAYS_INLINE void WriteUnlock() {
+    uint64_t version = version_.load(std::memory_order_relaxed);
+    version_.store(version + 1, std::memory_order_release);
+  }
+};
+
+/** A btree_map leaf: sorted entries and a pointer to the next leaf */
+template<typename Key, typename T, size_t CAP>
+struct btree_leaf : public btree_node_header {
+  OffsetPointer next_ptr_;
+  btree_map_entry<Key, T> entries_[CAP];
+};
+
+/**
+ * A btree_map inner node. Child i holds the keys in
+ * [keys_[i-1], keys_[i]).
+ * */
+template<typename Key, size_t CAP>
+struct btree_inner : public btree_node_header {
+  Key keys_[CAP];
+  OffsetPointer children_[CAP + 1];
+};
+
+/**
+ * The btree_map iterator. Visits entries in key order.
+ * Not safe to use while another thread modifies the map.
+ * */
+template<typename Key, typename T, size_t LEAF_CAP>
+struct btree_map_iterator {
+  typedef btree_leaf<Key, T, LEAF_CAP> LEAF_T;
+  Allocator *alloc_;
+  LEAF_T *leaf_;
+  uint32_t idx_;
+
+  /** Construct an iterator and advance to a valid entry */
+  HSHM_ALWAYS_INLINE btree_map_iterator(Allocator *alloc, LEAF_T *leaf,
+                                        uint32_t idx)
+  : alloc_(alloc), leaf_(leaf), idx_(idx) {
+    make_correct();
+  }
+
+  /** Get the pointed entry */
+  HSHM_ALWAYS_INLINE btree_map_entry<Key, T>& operator*() const {
+    return leaf_->entries_[idx_];
+  }
+
+  /** Get the pointed entry */
+  HSHM_ALWAYS_INLINE btree_map_entry<Key, T>* operator->() const {
+    return &leaf_->entries_[idx_];
+  }
+
+  /** Go to the next entry */
+  HSHM_ALWAYS_INLINE btree_map_iterator& operator++() {
+    ++idx_;
+    make_correct();
+    return *this;
+  }
+
+  /** Skip past the ends of leaves (and empty leaves) */
+  HSHM_ALWAYS_INLINE void make_correct() {
+    while (leaf_ && idx_ >= leaf_->count_) {
+      if (leaf_->next_ptr_.IsNull()) {
+        leaf_ = nullptr;
+      } else {
+        leaf_ = alloc_->template Convert<LEAF_T>(leaf_->next_ptr_);
+      }
+      idx_ = 0;
+    }
+  }
+
+  /** Check if two iterators are equal */
+  HSHM_ALWAYS_INLINE friend bool operator==(const btree_map_iterator &a,
+                                            const btree_map_iterator &b) {
+    return a.leaf_ == b.leaf_ && (a.leaf_ == nullptr || a.idx_ == b.idx_);
+  }
+
+  /** Check if two iterators are inequal */
+  HSHM_ALWAYS_INLINE friend bool operator!=(const btree_map_iterator &a,
+                                            const btree_map_iterator &b) {
+    return !(a == b);
+  }
+
+  /** Determine whether this iterator is the end iterator */
+  HSHM_ALWAYS_INLINE bool is_end() const {
+    return leaf_ == nullptr;
+  }
+};
+
+/**
+ * MACROS used to simplify the btree_map namespace
+ * Used as inputs to the SHM_CONTAINER_TEMPLATE
+ * */
+#define CLASS_NAME btree_map
+#define TYPED_CLASS btree_map<Key, T, NODE_SIZE>
+#define TYPED_HEADER ShmHeader<btree_map<Key, T, NODE_SIZE>>
+
+/**
+ * An ordered map implemented as a B+tree in shared memory. Nodes are
+ * about NODE_SIZE bytes (a few cache lines), so a lookup touches few
+ * lines per level. Leaves are linked in key order, which serves range
+ * scans and ordered iteration.
+ *
+ * Writers (emplace, erase, bulk_load) serialize on an internal mutex.
+ * lookup and scan are optimistic: they take no lock and validate each
+ * node against its version, restarting if a writer changed it. A leaf
+ * emptied by erase is unlinked from the tree and the leaf chain, along
+ * with any inner node left without children. Unlinked nodes are kept on
+ * free lists and reused by later splits, but never returned to the
+ * allocator, so a concurrent reader never follows a pointer to freed
+ * memory. Only bulk_load, clear() and the destructor free nodes, and
+ * those must not race with readers.
+ *
+ * Iterators, find, lower_bound and upper_bound do not validate and must
+ * not race with writers.
+ *
+ * Keys must be trivially copyable and ordered by operator<. Values must
+ * be trivially copyable.
+ * */
+template<typename Key, typename T, size_t NODE_SIZE>
+class btree_map : public ShmContainer {
+ public:
+  SHM_CONTAINER_TEMPLATE((CLASS_NAME), (TYPED_CLASS))
+  static_assert(std::is_trivially_copyable_v<Key> &&
+                std::is_trivially_copyable_v<T>,
+                "btree_map requires trivially copyable keys and values");
+
+  /**====================================
+   * Node capacities
+   * ===================================*/
+  /** The number of entries per leaf */
+  static const size_t leaf_cap_ =
+    (NODE_SIZE - sizeof(btree_node_header) - sizeof(OffsetPointer)) /
+    sizeof(btree_map_entry<Key, T>) < 4 ? 4 :
+    (NODE_SIZE - sizeof(btree_node_header) - sizeof(OffsetPointer)) /
+    sizeof(btree_map_entry<Key, T>);
+  /** The number of keys per inner node */
+  static const size_t inner_cap_ =
+    (NODE_SIZE - sizeof(btree_node_header) - sizeof(OffsetPointer)) /
+    (sizeof(Key) + sizeof(OffsetPointer)) < 4 ? 4 :
+    (NODE_SIZE - sizeof(btree_node_header) - sizeof(OffsetPointer)) /
+    (sizeof(Key) + sizeof(OffsetPointer));
+  /** The maximum height of a tree */
+  static const size_t max_height_ = 32;
+
+  /**====================================
+   * Typedefs
+   * ===================================*/
+  typedef btree_map_entry<Key, T> ENTRY_T;
+  typedef btree_leaf<Key, T, leaf_cap_> LEAF_T;
+  typedef btree_inner<Key, inner_cap_> INNER_T;
+  typedef btree_map_iterator<Key, T, leaf_cap_> iterator_t;
+
+  /**====================================
+   * Variables
+   * ===================================*/
+  AtomicOffsetPointer root_ptr_;
+  size_t height_;  /**< The number of levels, including the leaves */
+  std::atomic<size_t> length_;
+  Mutex lock_;  /**< Serializes writers */
+  OffsetPointer free_leaf_ptr_;  /**< Unlinked leaves, chained by next_ptr_ */
+  OffsetPointer free_inner_ptr_;  /**< Unlinked inner nodes, by children_[0] */
+
+ public:
+  /**====================================
+   * Default Constructor
+   * ===================================*/
+
+  /** SHM constructor. Default. */
+  explicit btree_map(Allocator *alloc) {
+    shm_init_container(alloc);
+    lock_.Init();
+    SetNull();
+  }
+
+  /**====================================
+   * Copy Constructors
+   * ===================================*/
+
+  /** SHM copy constructor */
+  explicit btree_map(Allocator *alloc, const btree_map &other) {
+    shm_init_container(alloc);
+    lock_.Init();
+    SetNull();
+    shm_strong_copy_construct_and_op(other);
+  }
+
+  /** SHM copy assignment operator */
+  btree_map& operator=(const btree_map &other) {
+    if (this != &other) {
+      shm_destroy();
+      shm_strong_copy_construct_and_op(other);
+    }
+    return *this;
+  }
+
+  /** SHM copy constructor + operator main */
+  void shm_strong_copy_construct_and_op(const btree_map &other) {
+    std::vector<Key> keys;
+    std::vector<T> vals;
+    keys.reserve(other.size());
+    vals.reserve(other.size());
+    for (auto iter = other.begin(); !iter.is_end(); ++iter) {
+      keys.emplace_back((*iter).key_);
+      vals.emplace_back((*iter).val_);
+    }
+    bulk_load(keys.data(), vals.data(), keys.size());
+  }
+
+  /**====================================
+   * Move Constructors
+   * ===================================*/
+
+  /** SHM move constructor. */
+  btree_map(Allocator *alloc, btree_map &&other) noexcept {
+    shm_init_container(alloc);
+    lock_.Init();
+    if (GetAllocator() == other.GetAllocator()) {
+      strong_copy(other);
+      other.SetNull();
+    } else {
+      SetNull();
+      shm_strong_copy_construct_and_op(other);
+      other.shm_destroy();
+    }
+  }
+
+  /** SHM move assignment operator. */
+  btree_map& operator=(btree_map &&other) noexcept {
+    if (this != &other) {
+      shm_destroy();
+      if (GetAllocator() == other.GetAllocator()) {
+        strong_copy(other);
+        other.SetNull();
+      } else {
+        shm_strong_copy_construct_and_op(other);
+        other.shm_destroy();
+      }
+    }
+    return *this;
+  }
+
+  /** Copy the tree header */
+  HSHM_ALWAYS_INLINE void strong_copy(const btree_map &other) {
+    root_ptr_.off_ = other.root_ptr_.off_.load();
+    height_ = other.height_;
+    length_ = other.length_.load();
+    free_leaf_ptr_ = other.free_leaf_ptr_;
+    free_inner_ptr_ = other.free_inner_ptr_;
+  }
+
+  /**====================================
+   * Destructor
+   * ===================================*/
+
+  /** Check if the tree has no nodes */
+  HSHM_ALWAYS_INLINE bool IsNull() const {
+    return root_ptr_.IsNull();
+  }
+
+  /** Sets this tree as empty */
+  HSHM_ALWAYS_INLINE void SetNull() {
+    root_ptr_.SetNull();
+    height_ = 0;
+    length_ = 0;
+    free_leaf_ptr_.SetNull();
+    free_inner_ptr_.SetNull();
+  }
+
+  /** Free every node */
+  void shm_destroy_main() {
+    FreeSubtree(GetRootPtr(), height_);
+    FreeUnlinkedNodes();
+  }
+
+  /**====================================
+   * Writer Methods
+   * ===================================*/
+
+  /**
+   * Insert a (key, value) pair. Overrides the value if key already exists.
+   * @return true
+   * */
+  bool emplace(const Key &key, const T &val) {
+    ScopedMutex lock(lock_, 0);
+    return emplace_templ<true>(key, val);
+  }
+
+  /**
+   * Insert a (key, value) pair if key does not exist yet
+   * @return true if the pair was inserted
+   * */
+  bool try_emplace(const Key &key, const T &val) {
+    ScopedMutex lock(lock_, 0);
+    return emplace_templ<false>(key, val);
+  }
+
+  /**
+   * Erase the entry with \a key. A leaf left empty is unlinked and kept
+   * for reuse, unless it is the root.
+   * @return true if the key was found
+   * */
+  bool erase(const Key &key) {
+    ScopedMutex lock(lock_, 0);
+    if (IsNull()) {
+      return false;
+    }
+    INNER_T *path[max_height_];
+    uint32_t path_idx[max_height_];
+    LEAF_T *leaf = FindLeaf(key, path, path_idx);
+    uint32_t pos = LeafLowerBound(leaf, key);
+    if (pos == leaf->count_ || key < leaf->entries_[pos].key_) {
+      return false;
+    }
+    leaf->WriteLock();
+    memmove(&leaf->entries_[pos], &leaf->entries_[pos + 1],
+            (leaf->count_ - pos - 1) * sizeof(ENTRY_T));
+    --leaf->count_;
+    if (leaf->count_ == 0 && height_ > 1) {
+      UnlinkLeaf(leaf, path, path_idx);
+    } else {
+      leaf->WriteUnlock();
+    }
+    length_.fetch_sub(1);
+    return true;
+  }
+
+  /**
+   * Replace the contents of the map with \a n pairs sorted by strictly
+   * increasing key. Leaves are filled completely and built bottom-up,
+   * which is much faster than n inserts. Must not race with readers,
+   * since the old nodes are freed.
+   * */
+  void bulk_load(const Key *keys, const T *vals, size_t n) {
+    ScopedMutex lock(lock_, 0);
+    FreeSubtree(GetRootPtr(), height_);
+    FreeUnlinkedNodes();
+    SetNull();
+    if (n == 0) {
+      return;
+    }
+
+    // Build the leaves
+    std::vector<std::pair<OffsetPointer, Key>> level;
+    LEAF_T *prior = nullptr;
+    for (size_t off = 0; off < n; off += leaf_cap_) {
+      size_t count = n - off;
+      if (count > leaf_cap_) {
+        count = leaf_cap_;
+      }
+      OffsetPointer leaf_ptr;
+      LEAF_T *leaf = AllocateLeaf(leaf_ptr);
+      for (size_t i = 0; i < count; ++i) {
+        leaf->entries_[i].key_ = keys[off + i];
+        leaf->entries_[i].val_ = vals[off + i];
+      }
+      leaf->count_ = count;
+      if (prior) {
+        prior->next_ptr_ = leaf_ptr;
+      }
+      prior = leaf;
+      level.emplace_back(leaf_ptr, keys[off]);
+    }
+    height_ = 1;
+
+    // Build the inner levels
+    while (level.size() > 1) {
+      std::vector<std::pair<OffsetPointer, Key>> parents;
+      for (size_t off = 0; off < level.size(); off += inner_cap_ + 1) {
+        size_t count = level.size() - off;
+        if (count > inner_cap_ + 1) {
+          count = inner_cap_ + 1;
+        }
+        OffsetPointer inner_ptr;
+        INNER_T *inner = AllocateInner(inner_ptr);
+        for (size_t i = 0; i < count; ++i) {
+          inner->children_[i] = level[off + i].first;
+          if (i > 0) {
+            inner->keys_[i - 1] = level[off + i].second;
+          }
+        }
+        inner->count_ = count - 1;
+        parents.emplace_back(inner_ptr, level[off].second);
+      }
+      level = std::move(parents);
+      ++height_;
+    }
+    length_ = n;
+    root_ptr_.off_.exchange(level[0].first.off_.load(),
+                            std::memory_order_release);
+  }
+
+  /** Erase the entire map. Must not race with readers. */
+  void clear() {
+    ScopedMutex lock(lock_, 0);
+    FreeSubtree(GetRootPtr(), height_);
+    FreeUnlinkedNodes();
+    SetNull();
+  }
+
+  /**====================================
+   * Optimistic Reader Methods
+   * ===================================*/
+
+  /**
+   * Copy the value of \a key into \a val. Safe to call while other
+   * threads or processes modify the map.
+   *
+   * @return true if the key was found
+   * */
+  bool lookup(const Key &key, T &val) const {
+    while (true) {
+      uint64_t version;
+      const LEAF_T *leaf = OptimisticFindLeaf(key, version);
+      if (leaf == nullptr) {
+        if (root_ptr_.IsNull()) { return false; }
+        continue;
+      }
+      uint32_t count = ClampCount(leaf->count_, leaf_cap_);
+      uint32_t pos = LeafLowerBound(leaf, key, count);
+      bool found = pos < count && !(key < leaf->entries_[pos].key_);
+      if (found) {
+        val = leaf->entries_[pos].val_;
+      }
+      if (leaf->ReadValidate(version)) {
+        return found;
+      }
+    }
+  }
+
+  /**
+   * Copy at most \a max entries with keys in [lo, hi) into \a out, in key
+   * order. Safe to call while other threads or processes modify the map.
+   * Each leaf is read atomically, but the scan as a whole is not a
+   * snapshot.
+   *
+   * @return the number of entries copied
+   * */
+  size_t scan(const Key &lo, const Key &hi, ENTRY_T *out, size_t max) const {
+    size_t n = 0;
+    Key start = lo;
+    bool exclusive = false;
+    while (n < max) {
+      // Descend to the leaf which may contain start
+      uint64_t version;
+      const LEAF_T *leaf = OptimisticFindLeaf(start, version);
+      if (leaf == nullptr) {
+        if (root_ptr_.IsNull()) { return n; }
+        continue;
+      }
+
+      // Walk the leaves until hi, restarting from the last key on conflict
+      while (true) {
+        size_t leaf_n = n;
+        bool done = false;
+        uint32_t count = ClampCount(leaf->count_, leaf_cap_);
+        for (uint32_t i = 0; i < count; ++i) {
+          const ENTRY_T &entry = leaf->entries_[i];
+          if (entry.key_ < start || (exclusive && !(start < entry.key_))) {
+            continue;
+          }
+          if (!(entry.key_ < hi) || leaf_n == max) {
+            done = true;
+            break;
+          }
+          out[leaf_n++] = entry;
+        }
+        OffsetPointer next_ptr = leaf->next_ptr_;
+        if (!leaf->ReadValidate(version)) {
+          break;
+        }
+        n = leaf_n;
+        if (n > 0) {
+          start = out[n - 1].key_;
+          exclusive = true;
+        }
+        if (done || n == max || next_ptr.IsNull()) {
+          return n;
+        }
+        // The next leaf may have been unlinked since next_ptr was read
+        const LEAF_T *next = GetAllocator()->template Convert<LEAF_T>(next_ptr);
+        uint64_t next_version = next->ReadLock();
+        if (!leaf->ReadValidate(version)) {
+          break;
+        }
+        leaf = next;
+        version = next_version;
+      }
+    }
+    return n;
+  }
+
+  /**====================================
+   * Query Methods
+   * ===================================*/
+
+  /** The number of entries in the map */
+  HSHM_ALWAYS_INLINE size_t size() const {
+    return length_.load();
+  }
+
+  /** The number of levels in the tree */
+  HSHM_ALWAYS_INLINE size_t height() const {
+    return height_;
+  }
+
+  /**
+   * Locate an entry in the map
+   *
+   * @return the value of key
+   * @exception UNORDERED_MAP_CANT_FIND the key was not in the map
+   * */
+  HSHM_ALWAYS_INLINE T& operator[](const Key &key) {
+    iterator_t iter = find(key);
+    if (iter.is_end()) {
+      throw UNORDERED_MAP_CANT_FIND.format();
+    }
+    return (*iter).val_;
+  }
+
+  /** Find the entry with \a key */
+  iterator_t find(const Key &key) const {
+    iterator_t iter = lower_bound(key);
+    if (!iter.is_end() && key < (*iter).key_) {
+      return end();
+    }
+    return iter;
+  }
+
+  /** Find the first entry whose key is not less than \a key */
+  iterator_t lower_bound(const Key &key) const {
+    if (IsNull()) {
+      return end();
+    }
+    LEAF_T *leaf = FindLeaf(key, nullptr, nullptr);
+    return iterator_t(GetAllocator(), leaf, LeafLowerBound(leaf, key));
+  }
+
+  /** Find the first entry whose key is greater than \a key */
+  iterator_t upper_bound(const Key &key) const {
+    if (IsNull()) {
+      return end();
+    }
+    LEAF_T *leaf = FindLeaf(key, nullptr, nullptr);
+    uint32_t pos = LeafLowerBound(leaf, key);
+    if (pos < leaf->count_ && !(key < leaf->entries_[pos].key_)) {
+      ++pos;
+    }
+    return iterator_t(GetAllocator(), leaf, pos);
+  }
+
+  /**====================================
+   * Iterators
+   * ===================================*/
+
+  /** Forward iterator begin */
+  iterator_t begin() const {
+    if (IsNull()) {
+      return end();
+    }
+    OffsetPointer node_ptr = GetRootPtr();
+    for (size_t level = height_; level > 1; --level) {
+      node_ptr = GetAllocator()->template
+        Convert<INNER_T>(node_ptr)->children_[0];
+    }
+    return iterator_t(GetAllocator(),
+                      GetAllocator()->template Convert<LEAF_T>(node_ptr), 0);
+  }
+
+  /** Forward iterator end */
+  HSHM_ALWAYS_INLINE iterator_t end() const {
+    return iterator_t(GetAllocator(), nullptr, 0);
+  }
+
+ private:
+  /**====================================
+   * Helpers
+   * ===================================*/
+
+  /** Insert a (key, value) pair. The writer lock must be held. */
+  template<bool modify_existing>
+  bool emplace_templ(const Key &key, const T &val) {
+    // Create the root leaf
+    if (IsNull()) {
+      OffsetPointer leaf_ptr;
+      AllocateLeaf(leaf_ptr);
+      height_ = 1;
+      root_ptr_.off_.exchange(leaf_ptr.off_.load(), std::memory_order_release);
+    }
+
+    // Find the leaf and the path of inner nodes to it
+    INNER_T *path[max_height_];
+    uint32_t path_idx[max_height_];
+    LEAF_T *leaf = FindLeaf(key, path, path_idx);
+    uint32_t pos = LeafLowerBound(leaf, key);
+    if (pos < leaf->count_ && !(key < leaf->entries_[pos].key_)) {
+      if constexpr(!modify_existing) {
+        return false;
+      } else {
+        leaf->WriteLock();
+        leaf->entries_[pos].val_ = val;
+        leaf->WriteUnlock();
+        return true;
+      }
+    }
+
+    // Insert into a leaf with free space
+    ENTRY_T entry;
+    entry.key_ = key;
+    entry.val_ = val;
+    if (leaf->count_ < leaf_cap_) {
+      leaf->WriteLock();
+      LeafInsert(leaf, pos, entry);
+      leaf->WriteUnlock();
+      length_.fetch_add(1);
+      return true;
+    }
+
+    // Split the leaf. Every modified node stays locked until the split
+    // has reached the parents, so readers cannot see a half-split tree.
+    btree_node_header *locked[max_height_ + 1];
+    size_t num_locked = 0;
+    leaf->WriteLock();
+    locked[num_locked++] = leaf;
+    OffsetPointer right_ptr;
+    LEAF_T *right = AllocateLeaf(right_ptr);
+    uint32_t half = leaf->count_ / 2;
+    right->count_ = leaf->count_ - half;
+    memcpy(right->entries_, &leaf->entries_[half],
+           right->count_ * sizeof(ENTRY_T));
+    leaf->count_ = half;
+    if (pos <= half) {
+      LeafInsert(leaf, pos, entry);
+    } else {
+      LeafInsert(right, pos - half, entry);
+    }
+    right->next_ptr_ = leaf->next_ptr_;
+    leaf->next_ptr_ = right_ptr;
+    Key sep = right->entries_[0].key_;
+    OffsetPointer child_ptr = right_ptr;
+
+    // Insert the separator into the parents, splitting them as needed
+    size_t depth = height_ - 1;
+    while (true) {
+      if (depth == 0) {
+        // The root was split: grow the tree
+        OffsetPointer root_ptr;
+        INNER_T *root = AllocateInner(root_ptr);
+        root->children_[0] = GetRootPtr();
+        root->children_[1] = child_ptr;
+        root->keys_[0] = sep;
+        root->count_ = 1;
+        ++height_;
+        root_ptr_.off_.exchange(root_ptr.off_.load(),
+                                std::memory_order_release);
+        break;
+      }
+      INNER_T *parent = path[depth - 1];
+      uint32_t idx = path_idx[depth - 1];
+      parent->WriteLock();
+      locked[num_locked++] = parent;
+      if (parent->count_ < inner_cap_) {
+        InnerInsert(parent, idx, sep, child_ptr);
+        break;
+      }
+      // Split the parent: the middle key moves up
+      OffsetPointer rinner_ptr;
+      INNER_T *rinner = AllocateInner(rinner_ptr);
+      Key keys[inner_cap_ + 1];
+      OffsetPointer children[inner_cap_ + 2];
+      memcpy(keys, parent->keys_, idx * sizeof(Key));
+      keys[idx] = sep;
+      memcpy(keys + idx + 1, parent->keys_ + idx,
+             (inner_cap_ - idx) * sizeof(Key));
+      memcpy((void*)children, (void*)parent->children_,
+             (idx + 1) * sizeof(OffsetPointer));
+      children[idx + 1] = child_ptr;
+      memcpy((void*)(children + idx + 2), (void*)(parent->children_ + idx + 1),
+             (inner_cap_ - idx) * sizeof(OffsetPointer));
+      uint32_t mid = (inner_cap_ + 1) / 2;
+      parent->count_ = mid;
+      memcpy(parent->keys_, keys, mid * sizeof(Key));
+      memcpy((void*)parent->children_, (void*)children,
+             (mid + 1) * sizeof(OffsetPointer));
+      rinner->count_ = inner_cap_ - mid;
+      memcpy(rinner->keys_, keys + mid + 1, rinner->count_ * sizeof(Key));
+      memcpy((void*)rinner->children_, (void*)(children + mid + 1),
+             (rinner->count_ + 1) * sizeof(OffsetPointer));
+      sep = keys[mid];
+      child_ptr = rinner_ptr;
+      --depth;
+    }
+    for (size_t i = 0; i < num_locked; ++i) {
+      locked[i]->WriteUnlock();
+    }
+    length_.fetch_add(1);
+    return true;
+  }
+
+  /**
+   * Descend to the leaf which may contain \a key. Records the inner nodes
+   * on the path and the child taken from each if \a path is non-null.
+   * Must not race with writers.
+   * */
+  LEAF_T* FindLeaf(const Key &key, INNER_T **path,
+                   uint32_t *path_idx) const {
+    OffsetPointer node_ptr = GetRootPtr();
+    for (size_t level = 0; level + 1 < height_; ++level) {
+      INNER_T *inner = GetAllocator()->template Convert<INNER_T>(node_ptr);
+      uint32_t idx = InnerUpperBound(inner, key, inner->count_);
+      if (path) {
+        path[level] = inner;
+        path_idx[level] = idx;
+      }
+      node_ptr = inner->children_[idx];
+    }
+    return GetAllocator()->template Convert<LEAF_T>(node_ptr);
+  }
+
+  /**
+   * Descend to the leaf which may contain \a key without locking. Each
+   * child pointer is validated against its parent's version before use.
+   *
+   * @param version the version of the returned leaf
+   * @return the leaf, or null if the descent must restart
+   * */
+  const LEAF_T* OptimisticFindLeaf(const Key &key, uint64_t &version) const {
+    OffsetPointer node_ptr = GetRootPtr();
+    if (node_ptr.IsNull()) {
+      return nullptr;
+    }
+    const btree_node_header *node = GetAllocator()->template
+      Convert<btree_node_header>(node_ptr);
+    version = node->ReadLock();
+    if (GetRootPtr().off_.load() != node_ptr.off_.load()) {
+      return nullptr;
+    }
+    while (!node->is_leaf_) {
+      auto inner = static_cast<const INNER_T*>(node);
+      uint32_t count = ClampCount(inner->count_, inner_cap_);
+      OffsetPointer child_ptr =
+        inner->children_[InnerUpperBound(inner, key, count)];
+      if (!node->ReadValidate(version)) {
+        return nullptr;
+      }
+      const btree_node_header *child = GetAllocator()->template
+        Convert<btree_node_header>(child_ptr);
+      uint64_t child_version = child->ReadLock();
+      if (!node->ReadValidate(version)) {
+        return nullptr;
+      }
+      node = child;
+      version = child_version;
+    }
+    return static_cast<const LEAF_T*>(node);
+  }
+
+  /** The first entry of a leaf whose key is not less than \a key */
+  HSHM_ALWAYS_INLINE static uint32_t LeafLowerBound(const LEAF_T *leaf,
+                                                    const Key &key,
+                                                    uint32_t count) {
+    uint32_t lo = 0, hi = count;
+    while (lo < hi) {
+      uint32_t mid = (lo + hi) / 2;
+      if (leaf->entries_[mid].key_ < key) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    return lo;
+  }
+
+  /** LeafLowerBound over every entry of a leaf */
+  HSHM_ALWAYS_INLINE static uint32_t LeafLowerBound(const LEAF_T *leaf,
+                                                    const Key &key) {
+    return LeafLowerBound(leaf, key, leaf->count_);
+  }
+
+  /** The child of an inner node which may contain \a key */
+  HSHM_ALWAYS_INLINE static uint32_t InnerUpperBound(const INNER_T *inner,
+                                                     const Key &key,
+                                                     uint32_t count) {
+    uint32_t lo = 0, hi = count;
+    while (lo < hi) {
+      uint32_t mid = (lo + hi) / 2;
+      if (key < inner->keys_[mid]) {
+        hi = mid;
+      } else {
+        lo = mid + 1;
+      }
+    }
+    return lo;
+  }
+
+  /** Get the pointer to the root node */
+  HSHM_ALWAYS_INLINE OffsetPointer GetRootPtr() const {
+    return OffsetPointer(root_ptr_.off_.load(std::memory_order_acquire));
+  }
+
+  /** Bound a count read without a lock, which may be torn */
+  HSHM_ALWAYS_INLINE static uint32_t ClampCount(uint32_t count, size_t cap) {
+    return count > cap ? static_cast<uint32_t>(cap) : count;
+  }
+
+  /** Insert an entry at \a pos of a leaf with free space */
+  HSHM_ALWAYS_INLINE static void LeafInsert(LEAF_T *leaf, uint32_t pos,
+                                            const ENTRY_T &entry) {
+    memmove(&leaf->entries_[pos + 1], &leaf->entries_[pos],
+            (leaf->count_ - pos) * sizeof(ENTRY_T));
+    leaf->entries_[pos] = entry;
+    ++leaf->count_;
+  }
+
+  /** Insert a key and its right child at \a idx of an inner node */
+  HSHM_ALWAYS_INLINE static void InnerInsert(INNER_T *inner, uint32_t idx,
+                                             const Key &key,
+                                             OffsetPointer child_ptr) {
+    memmove(&inner->keys_[idx + 1], &inner->keys_[idx],
+            (inner->count_ - idx) * sizeof(Key));
+    memmove((void*)&inner->children_[idx + 2],
+            (void*)&inner->children_[idx + 1],
+            (inner->count_ - idx) * sizeof(OffsetPointer));
+    inner->keys_[idx] = key;
+    inner->children_[idx + 1] = child_ptr;
+    ++inner->count_;
+  }
+
+  /**
+   * Remove child \a idx of an inner node with at least two children,
+   * along with the key separating it from a neighbor
+   * */
+  HSHM_ALWAYS_INLINE static void InnerErase(INNER_T *inner, uint32_t idx) {
+    uint32_t key_idx = idx > 0 ? idx - 1 : 0;
+    memmove(&inner->keys_[key_idx], &inner->keys_[key_idx + 1],
+            (inner->count_ - key_idx - 1) * sizeof(Key));
+    memmove((void*)&inner->children_[idx],
+            (void*)&inner->children_[idx + 1],
+            (inner->count_ - idx) * sizeof(OffsetPointer));
+    --inner->count_;
+  }
+
+  /**
+   * Unlink the empty, write-locked \a leaf found through \a path. It is
+   * removed from the leaf chain and its parent, and inner nodes left
+   * without children are removed from theirs. A root with a single child
+   * is replaced by the child. Unlinked nodes go to the free lists, and
+   * every modified node stays locked until the tree is consistent again.
+   * */
+  void UnlinkLeaf(LEAF_T *leaf, INNER_T **path, uint32_t *path_idx) {
+    btree_node_header *locked[2 * max_height_ + 2];
+    size_t num_locked = 0;
+    locked[num_locked++] = leaf;
+
+    // Skip the leaf in the leaf chain
+    LEAF_T *prior = FindPriorLeaf(path, path_idx);
+    if (prior) {
+      prior->WriteLock();
+      locked[num_locked++] = prior;
+      prior->next_ptr_ = leaf->next_ptr_;
+    }
+
+    // Remove the leaf from its parent, and empty parents from theirs.
+    // The root always has two children, so this stops before it.
+    size_t depth = height_ - 1;
+    OffsetPointer leaf_ptr = path[depth - 1]->children_[path_idx[depth - 1]];
+    while (true) {
+      INNER_T *parent = path[depth - 1];
+      parent->WriteLock();
+      locked[num_locked++] = parent;
+      if (parent->count_ > 0) {
+        InnerErase(parent, path_idx[depth - 1]);
+        break;
+      }
+      OffsetPointer parent_ptr =
+        path[depth - 2]->children_[path_idx[depth - 2]];
+      PushFreeInner(parent, parent_ptr);
+      --depth;
+    }
+    PushFreeLeaf(leaf, leaf_ptr);
+
+    // Replace a root with a single child by the child
+    while (height_ > 1) {
+      OffsetPointer root_ptr = GetRootPtr();
+      INNER_T *root = GetAllocator()->template Convert<INNER_T>(root_ptr);
+      if (root->count_ > 0) {
+        break;
+      }
+      if (root != path[0] || depth > 1) {
+        root->WriteLock();
+        locked[num_locked++] = root;
+      }
+      root_ptr_.off_.exchange(root->children_[0].off_.load(),
+                              std::memory_order_release);
+      --height_;
+      PushFreeInner(root, root_ptr);
+    }
+    for (size_t i = 0; i < num_locked; ++i) {
+      locked[i]->WriteUnlock();
+    }
+  }
+
+  /**
+   * The leaf before the leaf reached through \a path, or null if that
+   * leaf is the first. Must not race with writers.
+   * */
+  LEAF_T* FindPriorLeaf(INNER_T **path, uint32_t *path_idx) const {
+    for (size_t depth = height_ - 1; depth > 0; --depth) {
+      uint32_t idx = path_idx[depth - 1];
+      if (idx == 0) {
+        continue;
+      }
+      // Take the last leaf of the left sibling subtree
+      OffsetPointer node_ptr = path[depth - 1]->children_[idx - 1];
+      for (size_t level = depth; level + 1 < height_; ++level) {
+        INNER_T *inner = GetAllocator()->template Convert<INNER_T>(node_ptr);
+        node_ptr = inner->children_[inner->count_];
+      }
+      return GetAllocator()->template Convert<LEAF_T>(node_ptr);
+    }
+    return nullptr;
+  }
+
+  /**
+   * Allocate an empty leaf. An unlinked leaf is reused first. It keeps
+   * its version, since a reader may still validate against it.
+   * */
+  LEAF_T* AllocateLeaf(OffsetPointer &leaf_ptr) {
+    LEAF_T *leaf;
+    if (!free_leaf_ptr_.IsNull()) {
+      leaf_ptr = free_leaf_ptr_;
+      leaf = GetAllocator()->template Convert<LEAF_T>(leaf_ptr);
+      free_leaf_ptr_ = leaf->next_ptr_;
+      leaf->count_ = 0;
+    } else {
+      leaf = GetAllocator()->template
+        AllocatePtr<LEAF_T, OffsetPointer>(sizeof(LEAF_T), leaf_ptr);
+      leaf->Init(true);
+    }
+    leaf->next_ptr_.SetNull();
+    return leaf;
+  }
+
+  /** Allocate an empty inner node, reusing an unlinked one first */
+  INNER_T* AllocateInner(OffsetPointer &inner_ptr) {
+    INNER_T *inner;
+    if (!free_inner_ptr_.IsNull()) {
+      inner_ptr = free_inner_ptr_;
+      inner = GetAllocator()->template Convert<INNER_T>(inner_ptr);
+      free_inner_ptr_ = inner->children_[0];
+      inner->count_ = 0;
+    } else {
+      inner = GetAllocator()->template
+        AllocatePtr<INNER_T, OffsetPointer>(sizeof(INNER_T), inner_ptr);
+      inner->Init(false);
+    }
+    return inner;
+  }
+
+  /** Keep an unlinked, write-locked leaf for reuse */
+  HSHM_ALWAYS_INLINE void PushFreeLeaf(LEAF_T *leaf, OffsetPointer leaf_ptr) {
+    leaf->next_ptr_ = free_leaf_ptr_;
+    free_leaf_ptr_ = leaf_ptr;
+  }
+
+  /** Keep an unlinked, write-locked inner node for reuse */
+  HSHM_ALWAYS_INLINE void PushFreeInner(INNER_T *inner,
+                                        OffsetPointer inner_ptr) {
+    inner->children_[0] = free_inner_ptr_;
+    free_inner_ptr_ = inner_ptr;
+  }
+
+  /** Free the nodes on the free lists. Must not race with readers. */
+  void FreeUnlinkedNodes() {
+    while (!free_leaf_ptr_.IsNull()) {
+      OffsetPointer leaf_ptr = free_leaf_ptr_;
+      free_leaf_ptr_ = GetAllocator()->template
+        Convert<LEAF_T>(leaf_ptr)->next_ptr_;
+      GetAllocator()->Free(leaf_ptr);
+    }
+    while (!free_inner_ptr_.IsNull()) {
+      OffsetPointer inner_ptr = free_inner_ptr_;
+      free_inner_ptr_ = GetAllocator()->template
+        Convert<INNER_T>(inner_ptr)->children_[0];
+      GetAllocator()->Free(inner_ptr);
+    }
+  }
+
+  /** Free the subtree rooted at \a node_ptr with \a height levels */
+  void FreeSubtree(OffsetPointer node_ptr, size_t height) {
+    if (node_ptr.IsNull()) {
+      return;
+    }
+    if (height > 1) {
+      INNER_T *inner = GetAllocator()->template Convert<INNER_T>(node_ptr);
+      for (uint32_t i = 0; i <= inner->count_; ++i) {
+        FreeSubtree(inner->children_[i], height - 1);
+      }
+    }
+    GetAllocator()->Free(node_ptr);
+  }
+};
+
+}  // namespace hshm::ipc
+
+#undef TYPED_HEADER
+#undef TYPED_CLASS
+#undef CLASS_NAME
+
+#endif  // HERMES_DATA_STRUCTURES_BTREE_MAP_H_
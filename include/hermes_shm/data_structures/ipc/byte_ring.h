@@ -0,0 +1,388 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HERMES_SHM_INCLUDE_HERMES_SHM_DATA_STRUCTURES_IPC_BYTE_RING_H_
+#define HERMES_SHM_INCLUDE_HERMES_SHM_DATA_STRUCTURES_IPC_BYTE_RING_H_
+
+#include <cstring>
+#include "hermes_shm/data_structures/ipc/internal/shm_internal.h"
+#include "hermes_shm/thread/lock.h"
+#include "hermes_shm/types/bitfield.h"
+
+namespace hshm::ipc {
+
+/** Forward declaration of byte_ring_templ */
+template<bool MULTI_PRODUCER>
+class byte_ring_templ;
+
+/**
+ * The header in front of each message of a byte_ring. Records are
+ * 8-byte aligned, so a header never straddles the end of the ring.
+ * */
+struct byte_ring_header {
+  std::atomic<uint32_t> flags_;  /**< BYTE_RING_BUSY or BYTE_RING_SKIP */
+  uint32_t size_;                /**< The number of payload bytes */
+};
+
+/** The message is reserved, but not committed yet */
+#define BYTE_RING_BUSY BIT_OPT(uint32_t, 0)
+/** The record only pads the ring up to its end and holds no message */
+#define BYTE_RING_SKIP BIT_OPT(uint32_t, 1)
+
+/**
+ * MACROS used to simplify the byte_ring namespace
+ * Used as inputs to the SHM_CONTAINER_TEMPLATE
+ * */
+#define CLASS_NAME byte_ring_templ
+#define TYPED_CLASS byte_ring_templ<MULTI_PRODUCER>
+#define TYPED_HEADER ShmHeader<byte_ring_templ<MULTI_PRODUCER>>
+
+/**
+ * A ring of variable-length messages, written in place in shared memory.
+ *
+ * A producer calls reserve(len) to get len bytes inside the ring, writes
+ * the message there, then calls commit(). The consumer calls peek() to
+ * read the oldest message in place and release() to free it. Messages
+ * are consumed in reservation order, so the consumer waits on a message
+ * that is reserved but not committed.
+ *
+ * With MULTI_PRODUCER, reservations are serialized by a lock that is
+ * only held to carve out the record; producers write and commit their
+ * messages concurrently. The header of a record is written before tail_
+ * passes it, so the consumer never mistakes old payload bytes for one.
+ *
+ * A message that does not fit before the end of the ring is placed at
+ * its start, behind a skip record. Messages can be up to half the
+ * capacity, so that any message fits once the ring drains.
+ * */
+template<bool MULTI_PRODUCER>
+class byte_ring_templ : public ShmContainer {
+ public:
+  SHM_CONTAINER_TEMPLATE((CLASS_NAME), (TYPED_CLASS))
+  OffsetPointer buf_ptr_;
+  size_t mask_;
+  hshm::Mutex lock_;
+  char pad0_[HSHM_CACHE_LINE_SIZE];
+  std::atomic<size_t> tail_;
+  size_t head_cache_;  /**< The producers' copy of head_ */
+  char pad1_[HSHM_CACHE_LINE_SIZE];
+  std::atomic<size_t> head_;
+  size_t tail_cache_;  /**< The consumer's copy of tail_ */
+  char pad2_[HSHM_CACHE_LINE_SIZE];
+
+ public:
+  /**====================================
+   * Default Constructor
+   * ===================================*/
+
+  /** SHM constructor. The capacity is rounded up to a power of two. */
+  explicit byte_ring_templ(Allocator *alloc,
+                           size_t capacity = KILOBYTES(64)) {
+    shm_init_container(alloc);
+    SetNull();
+    shm_init_buf(capacity);
+  }
+
+  /**====================================
+   * Copy Constructors
+   * ===================================*/
+
+  /** SHM copy constructor */
+  explicit byte_ring_templ(Allocator *alloc,
+                           const byte_ring_templ &other) {
+    shm_init_container(alloc);
+    SetNull();
+    shm_strong_copy_construct_and_op(other);
+  }
+
+  /** SHM copy assignment operator */
+  byte_ring_templ& operator=(const byte_ring_templ &other) {
+    if (this != &other) {
+      shm_destroy();
+      shm_strong_copy_construct_and_op(other);
+    }
+    return *this;
+  }
+
+  /** SHM copy constructor + operator main. Other must be quiescent. */
+  void shm_strong_copy_construct_and_op(const byte_ring_templ &other) {
+    shm_init_buf(other.GetCapacity());
+    memcpy(GetBuf(), other.GetBuf(), other.GetCapacity());
+    head_ = other.head_.load();
+    tail_ = other.tail_.load();
+    head_cache_ = head_.load();
+    tail_cache_ = tail_.load();
+  }
+
+  /**====================================
+   * Move Constructors
+   * ===================================*/
+
+  /** SHM move constructor. */
+  byte_ring_templ(Allocator *alloc,
+                  byte_ring_templ &&other) noexcept {
+    shm_init_container(alloc);
+    if (GetAllocator() == other.GetAllocator()) {
+      strong_copy(other);
+      other.SetNull();
+    } else {
+      SetNull();
+      shm_strong_copy_construct_and_op(other);
+      other.shm_destroy();
+    }
+  }
+
+  /** SHM move assignment operator. */
+  byte_ring_templ& operator=(byte_ring_templ &&other) noexcept {
+    if (this != &other) {
+      shm_destroy();
+      if (GetAllocator() == other.GetAllocator()) {
+        strong_copy(other);
+        other.SetNull();
+      } else {
+        shm_strong_copy_construct_and_op(other);
+        other.shm_destroy();
+      }
+    }
+    return *this;
+  }
+
+  /** Take the buffer of another ring */
+  void strong_copy(const byte_ring_templ &other) {
+    buf_ptr_ = other.buf_ptr_;
+    mask_ = other.mask_;
+    lock_.Init();
+    head_ = other.head_.load();
+    tail_ = other.tail_.load();
+    head_cache_ = head_.load();
+    tail_cache_ = tail_.load();
+  }
+
+  /**====================================
+   * Destructor
+   * ===================================*/
+
+  /** SHM destructor.  */
+  void shm_destroy_main() {
+    GetAllocator()->Free(buf_ptr_);
+  }
+
+  /** Check if the ring is null */
+  bool IsNull() const {
+    return buf_ptr_.IsNull();
+  }
+
+  /** Sets this ring as null */
+  void SetNull() {
+    buf_ptr_.SetNull();
+    mask_ = 0;
+    lock_.Init();
+    head_ = 0;
+    tail_ = 0;
+    head_cache_ = 0;
+    tail_cache_ = 0;
+  }
+
+  /**====================================
+   * Producer Methods
+   * ===================================*/
+
+  /**
+   * Reserve \a len bytes at the tail of the ring. The bytes stay invisible
+   * to the consumer until they are passed to commit.
+   *
+   * @return the reserved bytes, or nullptr if the ring is full
+   * */
+  char* reserve(size_t len) {
+    if (len > GetMaxMessageSize()) {
+      throw BYTE_RING_MESSAGE_TOO_LARGE.format(len, GetCapacity());
+    }
+    size_t rec_size = RecordSize(len);
+    if constexpr(MULTI_PRODUCER) {
+      lock_.Lock(0);
+    }
+    char *data = reserve_locked(len, rec_size);
+    if constexpr(MULTI_PRODUCER) {
+      lock_.Unlock();
+    }
+    return data;
+  }
+
+  /** Publish a message returned by reserve */
+  HSHM_ALWAYS_INLINE void commit(char *data) {
+    byte_ring_header *hdr = reinterpret_cast<byte_ring_header*>(
+      data - sizeof(byte_ring_header));
+    hdr->flags_.store(0, std::memory_order_release);
+  }
+
+  /** Copy \a len bytes into the ring as one message */
+  bool push(const void *data, size_t len) {
+    char *dst = reserve(len);
+    if (dst == nullptr) {
+      return false;
+    }
+    memcpy(dst, data, len);
+    commit(dst);
+    return true;
+  }
+
+  /**====================================
+   * Consumer Methods
+   * ===================================*/
+
+  /**
+   * Get the oldest message in the ring, in place. The message stays valid
+   * until it is passed to release.
+   *
+   * @return the message, or nullptr if none is committed
+   * */
+  char* peek(size_t &len) {
+    char *buf = GetBuf();
+    size_t head = head_.load(std::memory_order_relaxed);
+    while (true) {
+      if (head == tail_cache_) {
+        tail_cache_ = tail_.load(std::memory_order_acquire);
+        if (head == tail_cache_) {
+          return nullptr;
+        }
+      }
+      byte_ring_header *hdr =
+        reinterpret_cast<byte_ring_header*>(buf + (head & mask_));
+      uint32_t flags = hdr->flags_.load(std::memory_order_acquire);
+      if (flags & BYTE_RING_BUSY) {
+        return nullptr;
+      }
+      if (flags & BYTE_RING_SKIP) {
+        head += RecordSize(hdr->size_);
+        head_.store(head, std::memory_order_release);
+        continue;
+      }
+      len = hdr->size_;
+      return reinterpret_cast<char*>(hdr + 1);
+    }
+  }
+
+  /** Free the message returned by the last peek */
+  HSHM_ALWAYS_INLINE void release() {
+    size_t head = head_.load(std::memory_order_relaxed);
+    byte_ring_header *hdr =
+      reinterpret_cast<byte_ring_header*>(GetBuf() + (head & mask_));
+    head_.store(head + RecordSize(hdr->size_), std::memory_order_release);
+  }
+
+  /**
+   * Copy the oldest message into \a data and release it. Messages larger
+   * than \a max_len are truncated.
+   *
+   * @param len the size of the message, before truncation
+   * @return false if the ring is empty
+   * */
+  bool pop(void *data, size_t max_len, size_t &len) {
+    char *src = peek(len);
+    if (src == nullptr) {
+      return false;
+    }
+    memcpy(data, src, std::min(len, max_len));
+    release();
+    return true;
+  }
+
+  /**====================================
+   * Getters
+   * ===================================*/
+
+  /** Get the number of bytes in use, including headers */
+  size_t GetSize() const {
+    return tail_.load() - head_.load();
+  }
+
+  /** Get the number of bytes in the ring */
+  size_t GetCapacity() const {
+    return mask_ + 1;
+  }
+
+  /**
+   * Get the largest message the ring accepts. This is half the capacity,
+   * but no more than the 32-bit size field of a header can hold.
+   * */
+  size_t GetMaxMessageSize() const {
+    return std::min<size_t>(GetCapacity() / 2 - sizeof(byte_ring_header),
+                            UINT32_MAX);
+  }
+
+ private:
+  /** The size of the record holding a \a len-byte message */
+  HSHM_ALWAYS_INLINE static size_t RecordSize(size_t len) {
+    return sizeof(byte_ring_header) + ((len + 7) & ~static_cast<size_t>(7));
+  }
+
+  /** Carve out a record. Requires the reservation lock. */
+  HSHM_ALWAYS_INLINE char* reserve_locked(size_t len, size_t rec_size) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t off = tail & mask_;
+    size_t skip = 0;
+    if (off + rec_size > GetCapacity()) {
+      skip = GetCapacity() - off;
+    }
+    if (tail + skip + rec_size - head_cache_ > GetCapacity()) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+      if (tail + skip + rec_size - head_cache_ > GetCapacity()) {
+        return nullptr;
+      }
+    }
+    char *buf = GetBuf();
+    if (skip) {
+      auto pad = reinterpret_cast<byte_ring_header*>(buf + off);
+      pad->size_ = skip - sizeof(byte_ring_header);
+      pad->flags_.store(BYTE_RING_SKIP, std::memory_order_relaxed);
+      off = 0;
+    }
+    auto hdr = reinterpret_cast<byte_ring_header*>(buf + off);
+    hdr->size_ = static_cast<uint32_t>(len);
+    hdr->flags_.store(BYTE_RING_BUSY, std::memory_order_relaxed);
+    tail_.store(tail + skip + rec_size, std::memory_order_release);
+    return reinterpret_cast<char*>(hdr + 1);
+  }
+
+  /** Allocate a buffer of at least \a capacity bytes */
+  void shm_init_buf(size_t capacity) {
+    size_t buf_size = 64;
+    while (buf_size < capacity) {
+      buf_size <<= 1;
+    }
+    mask_ = buf_size - 1;
+    char *buf = GetAllocator()->template
+      AllocatePtr<char, OffsetPointer>(buf_size, buf_ptr_);
+    if (buf == nullptr) {
+      throw OUT_OF_MEMORY.format(buf_size, "unknown");
+    }
+  }
+
+  /** Get the byte buffer */
+  HSHM_ALWAYS_INLINE char* GetBuf() const {
+    return GetAllocator()->template Convert<char>(buf_ptr_);
+  }
+};
+
+/** A byte ring for any number of producers and a single consumer */
+using byte_ring = byte_ring_templ<true>;
+
+/** A byte ring for a single producer and a single consumer */
+using spsc_byte_ring = byte_ring_templ<false>;
+
+}  // namespace hshm::ipc
+
+#undef CLASS_NAME
+#undef TYPED_CLASS
+#undef TYPED_HEADER
+
+#endif  // HERMES_SHM_INCLUDE_HERMES_SHM_DATA_STRUCTURES_IPC_BYTE_RING_H_
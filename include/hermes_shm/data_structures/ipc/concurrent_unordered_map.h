@@ -0,0 +1,334 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+* Distributed under BSD 3-Clause license.                                   *
+* Copyright by The HDF Group.                                               *
+* Copyright by the Illinois Institute of Technology.                        *
+* All rights reserved.                                                      *
+*                                                                           *
+* This file is part of Hermes. The full Hermes copyright notice, including  *
+* terms governing use, modification, and redistribution, is contained in    *
+* the COPYING file, which can be found at the top directory. If you do not  *
+* have access to the file, you may request a copy from help@hdfgroup.org.   *
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef HERMES_DATA_STRUCTURES_CONCURRENT_UNORDERED_MAP_H_
+#define HERMES_DATA_STRUCTURES_CONCURRENT_UNORDERED_MAP_H_
+
+#include "hermes_shm/data_structures/ipc/internal/shm_internal.h"
+#include "hermes_shm/thread/lock/rwlock.h"
+#include "vector.h"
+#include "unordered_map.h"
+
+namespace hshm::ipc {
+
+/**
+ * MACROS used to simplify the concurrent_unordered_map namespace
+ * Used as inputs to the SHM_CONTAINER_TEMPLATE
+ * */
+#define CLASS_NAME concurrent_unordered_map
+#define TYPED_CLASS concurrent_unordered_map<Key, T, Hash>
+#define TYPED_HEADER ShmHeader<concurrent_unordered_map<Key, T, Hash>>
+
+/**
+ * An unordered_map which may be modified by many threads and processes
+ * at once. Buckets are protected by a fixed set of striped reader-writer
+ * locks: bucket b is guarded by stripe (b % num_stripes). The bucket
+ * count is always a multiple of the stripe count, so a key maps to the
+ * same stripe no matter how often the map grows. Growth acquires every
+ * stripe.
+ *
+ * References into the map cannot outlive a lock, so lookups copy the
+ * value out instead of returning an iterator.
+ * */
+template<typename Key, typename T, class Hash = std::hash<Key>>
+class concurrent_unordered_map : public ShmContainer {
+ public:
+  SHM_CONTAINER_TEMPLATE((CLASS_NAME), (TYPED_CLASS))
+
+  /**====================================
+   * Typedefs
+   * ===================================*/
+  typedef unordered_map<Key, T, Hash> MAP_T;
+
+  /**====================================
+   * Variables
+   * ===================================*/
+  ShmArchive<MAP_T> map_;
+  ShmArchive<vector<RwLock>> locks_;
+  std::atomic<size_t> grow_at_;  /**< The map size which triggers growth */
+
+ public:
+  /**====================================
+   * Default Constructor
+   * ===================================*/
+
+  /**
+   * SHM constructor. Initialize the map.
+   *
+   * @param alloc the shared-memory allocator
+   * @param num_buckets the number of buckets to create. Rounded up to a
+   * multiple of num_stripes.
+   * @param num_stripes the number of bucket locks
+   * @param max_capacity the maximum number of elements per bucket before
+   * a growth is triggered
+   * @param growth the multiplier to grow the bucket vector size
+   * */
+  explicit concurrent_unordered_map(Allocator *alloc,
+                                    size_t num_buckets = 1024,
+                                    size_t num_stripes = 64,
+                                    RealNumber max_capacity = RealNumber(4, 5),
+                                    RealNumber growth = RealNumber(5, 4)) {
+    shm_init_container(alloc);
+    if (num_stripes == 0) {
+      num_stripes = 1;
+    }
+    num_buckets = RoundToStripes(num_buckets, num_stripes);
+    HSHM_MAKE_AR(map_, GetAllocator(), num_buckets,
+                 max_capacity, growth, false)
+    HSHM_MAKE_AR(locks_, GetAllocator(), num_stripes)
+    UpdateGrowAt();
+  }
+
+  /**====================================
+   * Copy Constructors
+   * ===================================*/
+
+  /** SHM copy constructor. Not thread-safe with respect to \a other. */
+  explicit concurrent_unordered_map(Allocator *alloc,
+                                    const concurrent_unordered_map &other) {
+    shm_init_container(alloc);
+    shm_strong_copy_construct_and_op(other);
+  }
+
+  /** SHM copy assignment operator. Not thread-safe. */
+  concurrent_unordered_map& operator=(const concurrent_unordered_map &other) {
+    if (this != &other) {
+      shm_destroy();
+      shm_strong_copy_construct_and_op(other);
+    }
+    return *this;
+  }
+
+  /** SHM copy constructor + operator main */
+  void shm_strong_copy_construct_and_op(
+      const concurrent_unordered_map &other) {
+    HSHM_MAKE_AR(map_, GetAllocator(), *other.map_)
+    HSHM_MAKE_AR(locks_, GetAllocator(), (*other.locks_).size())
+    UpdateGrowAt();
+  }
+
+  /**====================================
+   * Move Constructors
+   * ===================================*/
+
+  /** SHM move constructor. Not thread-safe. */
+  concurrent_unordered_map(Allocator *alloc,
+                           concurrent_unordered_map &&other) noexcept {
+    shm_init_container(alloc);
+    if (GetAllocator() == other.GetAllocator()) {
+      shm_move_main(other);
+    } else {
+      shm_strong_copy_construct_and_op(other);
+      other.shm_destroy();
+    }
+  }
+
+  /** SHM move assignment operator. Not thread-safe. */
+  concurrent_unordered_map& operator=(
+      concurrent_unordered_map &&other) noexcept {
+    if (this != &other) {
+      shm_destroy();
+      if (GetAllocator() == other.GetAllocator()) {
+        shm_move_main(other);
+      } else {
+        shm_strong_copy_construct_and_op(other);
+        other.shm_destroy();
+      }
+    }
+    return *this;
+  }
+
+  /** Steal the contents of a map in the same allocator */
+  void shm_move_main(concurrent_unordered_map &other) {
+    HSHM_MAKE_AR(map_, GetAllocator(), std::move(*other.map_))
+    HSHM_MAKE_AR(locks_, GetAllocator(), std::move(*other.locks_))
+    grow_at_ = other.grow_at_.load();
+    other.SetNull();
+  }
+
+  /**====================================
+   * Destructor
+   * ===================================*/
+
+  /** SHM destructor. */
+  void shm_destroy_main() {
+    (*map_).shm_destroy();
+    (*locks_).shm_destroy();
+  }
+
+  /** Check if the map is empty */
+  bool IsNull() const {
+    return (*locks_).IsNull();
+  }
+
+  /** Sets this map as empty */
+  void SetNull() {
+    grow_at_ = 0;
+  }
+
+  /**====================================
+   * Map Methods
+   * ===================================*/
+
+  /**
+   * Construct an object directly in the map. Overrides the object if
+   * key already exists.
+   * */
+  template<typename ...Args>
+  bool emplace(const Key &key, Args&&... args) {
+    return emplace_templ<true>(key, std::forward<Args>(args)...);
+  }
+
+  /**
+   * Construct an object directly in the map. Does not modify the key
+   * if it already exists.
+   * */
+  template<typename ...Args>
+  bool try_emplace(const Key &key, Args&&... args) {
+    return emplace_templ<false>(key, std::forward<Args>(args)...);
+  }
+
+  /** Erase the object indexable by \a key */
+  void erase(const Key &key) {
+    ScopedRwWriteLock lock(GetStripe(key), 0);
+    (*map_).erase(key);
+  }
+
+  /**
+   * Copy the object indexable by \a key into \a val
+   *
+   * @return true if the key was found, false otherwise
+   * */
+  bool find(const Key &key, T &val) {
+    ScopedRwReadLock lock(GetStripe(key), 0);
+    MAP_T &map = *map_;
+    auto iter = map.find(key);
+    if (iter.is_end()) {
+      return false;
+    }
+    val = (*iter).GetVal();
+    return true;
+  }
+
+  /** Check whether \a key is in the map */
+  bool contains(const Key &key) {
+    ScopedRwReadLock lock(GetStripe(key), 0);
+    MAP_T &map = *map_;
+    return !map.find(key).is_end();
+  }
+
+  /** Erase the entire map */
+  void clear() {
+    LockAll();
+    (*map_).clear();
+    UnlockAll();
+  }
+
+  /**====================================
+   * Query Methods
+   * ===================================*/
+
+  /** The number of entries in the map */
+  HSHM_ALWAYS_INLINE size_t size() const {
+    return (*map_).size();
+  }
+
+  /** The number of buckets in the map */
+  size_t get_num_buckets() {
+    ScopedRwReadLock lock((*locks_)[0], 0);
+    return (*map_).get_num_buckets();
+  }
+
+  /** The number of bucket locks */
+  HSHM_ALWAYS_INLINE size_t get_num_stripes() const {
+    return (*locks_).size();
+  }
+
+ private:
+  /**====================================
+   * Helpers
+   * ===================================*/
+
+  /** Insert a (key, value) pair under the key's stripe lock */
+  template<bool modify_existing, typename ...Args>
+  bool emplace_templ(const Key &key, Args&&... args) {
+    bool ret;
+    {
+      ScopedRwWriteLock lock(GetStripe(key), 0);
+      ret = (*map_).template emplace_templ<false, modify_existing>(
+        key, std::forward<Args>(args)...);
+    }
+    if (ret && size() > grow_at_.load()) {
+      Grow();
+    }
+    return ret;
+  }
+
+  /** Grow the bucket vector while holding every stripe */
+  void Grow() {
+    LockAll();
+    MAP_T &map = *map_;
+    size_t num_buckets = map.get_num_buckets();
+    if (map.size() > (map.max_capacity_ * num_buckets).as_int()) {
+      size_t new_num_buckets = RoundToStripes(
+        (map.growth_ * num_buckets).as_int() + 1, get_num_stripes());
+      map.rehash_templ(new_num_buckets, false);
+      UpdateGrowAt();
+    }
+    UnlockAll();
+  }
+
+  /** Get the lock guarding the bucket of \a key */
+  HSHM_ALWAYS_INLINE RwLock& GetStripe(const Key &key) {
+    vector<RwLock> &locks = *locks_;
+    return locks[Hash{}(key) % locks.size()];
+  }
+
+  /** Acquire every stripe in order, so concurrent growths cannot deadlock */
+  void LockAll() {
+    vector<RwLock> &locks = *locks_;
+    for (RwLock &lock : locks) {
+      lock.WriteLock(0);
+    }
+  }
+
+  /** Release every stripe */
+  void UnlockAll() {
+    vector<RwLock> &locks = *locks_;
+    for (RwLock &lock : locks) {
+      lock.WriteUnlock();
+    }
+  }
+
+  /** Recompute the growth threshold from the current bucket count */
+  void UpdateGrowAt() {
+    MAP_T &map = *map_;
+    grow_at_ = (map.max_capacity_ * map.get_num_buckets()).as_int();
+  }
+
+  /** Round \a num_buckets up to a non-zero multiple of \a num_stripes */
+  static size_t RoundToStripes(size_t num_buckets, size_t num_stripes) {
+    if (num_buckets < num_stripes) {
+      return num_stripes;
+    }
+    return (num_buckets + num_stripes - 1) / num_stripes * num_stripes;
+  }
+};
+
+}  // namespace hshm::ipc
+
+#undef TYPED_HEADER
+#undef TYPED_CLASS
+#undef CLASS_NAME
+
+#endif  // HERMES_DATA_STRUCTURES_CONCURRENT_UNORDERED_MAP_H_
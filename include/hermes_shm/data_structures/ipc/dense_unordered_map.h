@@ -0,0 +1,445 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+* Distributed under BSD 3-Clause license.                                   *
+* Copyright by The HDF Group.                                               *
+* Copyright by the Illinois Institute of Technology.                        *
+* All rights reserved.                                                      *
+*                                                                           *
+* This file is part of Hermes. The full Hermes copyright notice, including  *
+* terms governing use, modification, and redistribution, is contained in    *
+* the COPYING file, which can be found at the top directory. If you do not  *
+* have access to the file, you may request a copy from help@hdfgroup.org.   *
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HERMES_DATA_STRUCTURES_DENSE_UNORDERED_MAP_H_
+#define HERMES_DATA_STRUCTURES_DENSE_UNORDERED_MAP_H_
+
+#include "hermes_shm/data_structures/ipc/vector.h"
+#include "pair.h"
+#include "hermes_shm/data_structures/ipc/internal/shm_internal.h"
+
+namespace hshm::ipc {
+
+/** forward pointer for dense_unordered_map */
+template<typename Key, typename T, class Hash = std::hash<Key>>
+class dense_unordered_map;
+
+/** Entry index marking the end of a bucket chain */
+#define DENSE_UNORDERED_MAP_NULL SIZE_MAX
+
+/**
+ * A (key, value) pair stored in the entry vector of a dense_unordered_map,
+ * along with the full hash of its key and the index of the next entry in
+ * its bucket.
+ * */
+template<typename Key, typename T>
+struct dense_unordered_map_entry : public pair<Key, T> {
+  size_t hash_;
+  size_t next_;
+
+  /** SHM constructor. Default. */
+  explicit dense_unordered_map_entry(Allocator *alloc)
+  : pair<Key, T>(alloc), hash_(0), next_(DENSE_UNORDERED_MAP_NULL) {}
+
+  /** Construct the pair from \a args */
+  template<typename ...Args>
+  explicit dense_unordered_map_entry(Allocator *alloc, size_t hash,
+                                     Args&& ...args)
+  : pair<Key, T>(alloc, std::forward<Args>(args)...), hash_(hash),
+    next_(DENSE_UNORDERED_MAP_NULL) {}
+
+  /** SHM copy constructor */
+  explicit dense_unordered_map_entry(Allocator *alloc,
+                                     const dense_unordered_map_entry &other)
+  : pair<Key, T>(alloc, other), hash_(other.hash_), next_(other.next_) {}
+
+  /** SHM move constructor */
+  explicit dense_unordered_map_entry(Allocator *alloc,
+                                     dense_unordered_map_entry &&other)
+  : pair<Key, T>(alloc, std::move(other)), hash_(other.hash_),
+    next_(other.next_) {}
+
+  /** SHM move assignment operator */
+  dense_unordered_map_entry& operator=(dense_unordered_map_entry &&other) {
+    if (this != &other) {
+      pair<Key, T>::operator=(std::move(other));
+      hash_ = other.hash_;
+      next_ = other.next_;
+    }
+    return *this;
+  }
+};
+
+/** Relocatable if the underlying pair is */
+template<typename Key, typename T>
+struct is_trivially_relocatable<dense_unordered_map_entry<Key, T>>
+  : is_trivially_relocatable<pair<Key, T>> {};
+
+/**
+ * MACROS used to simplify the dense_unordered_map namespace
+ * Used as inputs to the SHM_CONTAINER_TEMPLATE
+ * */
+#define CLASS_NAME dense_unordered_map
+#define TYPED_CLASS dense_unordered_map<Key, T, Hash>
+#define TYPED_HEADER ShmHeader<dense_unordered_map<Key, T, Hash>>
+
+/**
+ * An unordered_map layout for maps which are iterated often. Entries are
+ * stored contiguously in a vector, in insertion order until the first
+ * erase, and buckets hold the index of the first entry of their chain.
+ *
+ * Iteration is a linear scan of the entry vector, independent of the
+ * bucket count. Erase moves the last entry into the erased slot, so it
+ * reorders entries and invalidates iterators to the last entry.
+ * */
+template<typename Key, typename T, class Hash>
+class dense_unordered_map : public ShmContainer {
+ public:
+  SHM_CONTAINER_TEMPLATE((CLASS_NAME), (TYPED_CLASS))
+
+  /**====================================
+   * Typedefs
+   * ===================================*/
+  typedef dense_unordered_map_entry<Key, T> ENTRY_T;
+  typedef typename vector<ENTRY_T>::iterator_t iterator_t;
+
+  /**====================================
+   * Variables
+   * ===================================*/
+  ShmArchive<vector<ENTRY_T>> entries_;
+  ShmArchive<vector<size_t>> buckets_;
+  RealNumber max_capacity_;
+  RealNumber growth_;
+
+ public:
+  /**====================================
+   * Default Constructor
+   * ===================================*/
+
+  /**
+   * SHM constructor. Initialize the map.
+   *
+   * @param alloc the shared-memory allocator
+   * @param num_buckets the number of buckets to create
+   * @param max_capacity the maximum number of elements per bucket before
+   * a growth is triggered
+   * @param growth the multiplier to grow the bucket vector size
+   * */
+  explicit dense_unordered_map(Allocator *alloc,
+                               int num_buckets = 20,
+                               RealNumber max_capacity = RealNumber(4, 5),
+                               RealNumber growth = RealNumber(5, 4)) {
+    shm_init_container(alloc);
+    HSHM_MAKE_AR0(entries_, GetAllocator())
+    HSHM_MAKE_AR(buckets_, GetAllocator(), num_buckets,
+                 DENSE_UNORDERED_MAP_NULL)
+    max_capacity_ = max_capacity;
+    growth_ = growth;
+  }
+
+  /**====================================
+   * Copy Constructors
+   * ===================================*/
+
+  /** SHM copy constructor */
+  explicit dense_unordered_map(Allocator *alloc,
+                               const dense_unordered_map &other) {
+    shm_init_container(alloc);
+    HSHM_MAKE_AR(entries_, GetAllocator(), *other.entries_)
+    HSHM_MAKE_AR(buckets_, GetAllocator(), *other.buckets_)
+    max_capacity_ = other.max_capacity_;
+    growth_ = other.growth_;
+  }
+
+  /** SHM copy assignment operator */
+  dense_unordered_map& operator=(const dense_unordered_map &other) {
+    if (this != &other) {
+      GetEntries() = other.GetEntries();
+      GetBuckets() = other.GetBuckets();
+      max_capacity_ = other.max_capacity_;
+      growth_ = other.growth_;
+    }
+    return *this;
+  }
+
+  /**====================================
+   * Move Constructors
+   * ===================================*/
+
+  /** SHM move constructor. */
+  dense_unordered_map(Allocator *alloc,
+                      dense_unordered_map &&other) noexcept {
+    shm_init_container(alloc);
+    HSHM_MAKE_AR(entries_, GetAllocator(), std::move(other.GetEntries()))
+    HSHM_MAKE_AR(buckets_, GetAllocator(), std::move(other.GetBuckets()))
+    max_capacity_ = other.max_capacity_;
+    growth_ = other.growth_;
+  }
+
+  /** SHM move assignment operator. */
+  dense_unordered_map& operator=(dense_unordered_map &&other) noexcept {
+    if (this != &other) {
+      GetEntries() = std::move(other.GetEntries());
+      GetBuckets() = std::move(other.GetBuckets());
+      max_capacity_ = other.max_capacity_;
+      growth_ = other.growth_;
+    }
+    return *this;
+  }
+
+  /**====================================
+   * Destructor
+   * ===================================*/
+
+  /** Check if the map is empty (has no bucket vector) */
+  HSHM_ALWAYS_INLINE bool IsNull() const {
+    return GetBuckets().IsNull();
+  }
+
+  /** Sets this map as empty */
+  HSHM_ALWAYS_INLINE void SetNull() {}
+
+  /** Destroy the entries and buckets */
+  HSHM_ALWAYS_INLINE void shm_destroy_main() {
+    GetEntries().shm_destroy();
+    GetBuckets().shm_destroy();
+  }
+
+  /**====================================
+   * Emplace Methods
+   * ===================================*/
+
+  /**
+   * Construct an object directly in the map. Overrides the object if
+   * key already exists.
+   *
+   * @param key the key to future index the map
+   * @param args the arguments to construct the object
+   * @return true
+   * */
+  template<typename ...Args>
+  bool emplace(const Key &key, Args&&... args) {
+    return emplace_templ<true>(key, std::forward<Args>(args)...);
+  }
+
+  /**
+   * Construct an object directly in the map. Does not modify the key
+   * if it already exists.
+   *
+   * @param key the key to future index the map
+   * @param args the arguments to construct the object
+   * @return true if the object was inserted
+   * */
+  template<typename ...Args>
+  bool try_emplace(const Key &key, Args&&... args) {
+    return emplace_templ<false>(key, std::forward<Args>(args)...);
+  }
+
+  /**====================================
+   * Erase Methods
+   * ===================================*/
+
+  /** Erase an object indexable by \a key */
+  void erase(const Key &key) {
+    size_t idx = find_idx(key, Hash{}(key));
+    if (idx != DENSE_UNORDERED_MAP_NULL) {
+      erase_idx(idx);
+    }
+  }
+
+  /**
+   * Erase an object at the iterator. The last entry is moved into its
+   * place, so \a iter points to the next entry to visit afterwards.
+   * */
+  void erase(iterator_t &iter) {
+    if (iter.is_end()) return;
+    erase_idx(iter.i_);
+  }
+
+  /** Erase the entire map */
+  void clear() {
+    vector<size_t> &buckets = GetBuckets();
+    size_t num_buckets = buckets.size();
+    GetEntries().clear();
+    buckets.clear();
+    buckets.resize(num_buckets, DENSE_UNORDERED_MAP_NULL);
+  }
+
+  /** Grow the map to \a num_buckets buckets. Requests to shrink are ignored. */
+  void rehash(size_t num_buckets) {
+    vector<size_t> &buckets = GetBuckets();
+    if (num_buckets <= buckets.size()) {
+      return;
+    }
+    buckets.clear();
+    buckets.resize(num_buckets, DENSE_UNORDERED_MAP_NULL);
+    vector<ENTRY_T> &entries = GetEntries();
+    for (size_t i = 0; i < entries.size(); ++i) {
+      ENTRY_T &entry = entries[i];
+      size_t &head = buckets[entry.hash_ % num_buckets];
+      entry.next_ = head;
+      head = i;
+    }
+  }
+
+  /**====================================
+   * Index Methods
+   * ===================================*/
+
+  /**
+   * Locate an entry in the map
+   *
+   * @return the object pointed by key
+   * @exception UNORDERED_MAP_CANT_FIND the key was not in the map
+   * */
+  HSHM_ALWAYS_INLINE T& operator[](const Key &key) {
+    size_t idx = find_idx(key, Hash{}(key));
+    if (idx != DENSE_UNORDERED_MAP_NULL) {
+      return GetEntries()[idx].GetVal();
+    }
+    throw UNORDERED_MAP_CANT_FIND.format();
+  }
+
+  /** Find an object in the map */
+  iterator_t find(const Key &key) {
+    size_t idx = find_idx(key, Hash{}(key));
+    if (idx == DENSE_UNORDERED_MAP_NULL) {
+      return end();
+    }
+    return GetEntries().begin() + idx;
+  }
+
+  /**====================================
+   * Query Methods
+   * ===================================*/
+
+  /** The number of entries in the map */
+  HSHM_ALWAYS_INLINE size_t size() const {
+    return GetEntries().size();
+  }
+
+  /** The number of buckets in the map */
+  HSHM_ALWAYS_INLINE size_t get_num_buckets() const {
+    return GetBuckets().size();
+  }
+
+  /**====================================
+   * Iterators
+   * ===================================*/
+
+  /** Forward iterator begin */
+  HSHM_ALWAYS_INLINE iterator_t begin() const {
+    return GetEntries().begin();
+  }
+
+  /** Forward iterator end */
+  HSHM_ALWAYS_INLINE iterator_t end() const {
+    return GetEntries().end();
+  }
+
+  /** Get the entries */
+  HSHM_ALWAYS_INLINE vector<ENTRY_T>& GetEntries() {
+    return *entries_;
+  }
+
+  /** Get the entries (const) */
+  HSHM_ALWAYS_INLINE vector<ENTRY_T>& GetEntries() const {
+    return const_cast<vector<ENTRY_T>&>(*entries_);
+  }
+
+  /** Get the buckets */
+  HSHM_ALWAYS_INLINE vector<size_t>& GetBuckets() {
+    return *buckets_;
+  }
+
+  /** Get the buckets (const) */
+  HSHM_ALWAYS_INLINE vector<size_t>& GetBuckets() const {
+    return const_cast<vector<size_t>&>(*buckets_);
+  }
+
+ private:
+  /**====================================
+   * Helpers
+   * ===================================*/
+
+  /** Insert a (key, value) pair */
+  template<bool modify_existing, typename ...Args>
+  bool emplace_templ(const Key &key, Args&& ...args) {
+    size_t hash = Hash{}(key);
+    size_t idx = find_idx(key, hash);
+    if (idx != DENSE_UNORDERED_MAP_NULL) {
+      if constexpr(!modify_existing) {
+        return false;
+      } else {
+        erase_idx(idx);
+      }
+    }
+
+    // Append the entry and link it into its bucket
+    vector<ENTRY_T> &entries = GetEntries();
+    vector<size_t> &buckets = GetBuckets();
+    entries.emplace_back(hash, PiecewiseConstruct(),
+                         make_argpack(key),
+                         make_argpack(std::forward<Args>(args)...));
+    idx = entries.size() - 1;
+    size_t &head = buckets[hash % buckets.size()];
+    entries[idx].next_ = head;
+    head = idx;
+
+    // Grow the bucket vector if the map is too full
+    size_t num_buckets = buckets.size();
+    if (entries.size() > (max_capacity_ * num_buckets).as_int()) {
+      size_t new_num_buckets = (growth_ * num_buckets).as_int();
+      if (new_num_buckets <= num_buckets) {
+        new_num_buckets = num_buckets + 1;
+      }
+      rehash(new_num_buckets);
+    }
+    return true;
+  }
+
+  /** Find the index of the entry with \a key */
+  HSHM_ALWAYS_INLINE size_t find_idx(const Key &key, size_t hash) const {
+    vector<ENTRY_T> &entries = GetEntries();
+    vector<size_t> &buckets = GetBuckets();
+    size_t idx = buckets[hash % buckets.size()];
+    while (idx != DENSE_UNORDERED_MAP_NULL) {
+      ENTRY_T &entry = entries[idx];
+      if (entry.hash_ == hash && entry.GetKey() == key) {
+        return idx;
+      }
+      idx = entry.next_;
+    }
+    return DENSE_UNORDERED_MAP_NULL;
+  }
+
+  /** Get the link which points to the entry at \a idx */
+  HSHM_ALWAYS_INLINE size_t& find_link(size_t idx) {
+    vector<ENTRY_T> &entries = GetEntries();
+    vector<size_t> &buckets = GetBuckets();
+    size_t *link = &buckets[entries[idx].hash_ % buckets.size()];
+    while (*link != idx) {
+      link = &entries[*link].next_;
+    }
+    return *link;
+  }
+
+  /** Erase the entry at \a idx by moving the last entry into it */
+  void erase_idx(size_t idx) {
+    vector<ENTRY_T> &entries = GetEntries();
+    find_link(idx) = entries[idx].next_;
+    size_t last = entries.size() - 1;
+    if (idx != last) {
+      find_link(last) = idx;
+      entries[idx] = std::move(entries[last]);
+    }
+    entries.erase(entries.begin() + last);
+  }
+};
+
+}  // namespace hshm::ipc
+
+#undef CLASS_NAME
+#undef TYPED_CLASS
+#undef TYPED_HEADER
+
+#endif  // HERMES_DATA_STRUCTURES_DENSE_UNORDERED_MAP_H_
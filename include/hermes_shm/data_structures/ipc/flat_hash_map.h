@@ -0,0 +1,635 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+* Distributed under BSD 3-Clause license.                                   *
+* Copyright by The HDF Group.                                               *
+* Copyright by the Illinois Institute of Technology.                        *
+* All rights reserved.                                                      *
+*                                                                           *
+* This file is part of Hermes. The full Hermes copyright notice, including  *
+* terms governing use, modification, and redistribution, is contained in    *
+* the COPYING file, which can be found at the top directory. If you do not  *
+* have access to the file, you may request a copy from help@hdfgroup.org.   *
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef HERMES_DATA_STRUCTURES_FLAT_HASH_MAP_H_
+#define HERMES_DATA_STRUCTURES_FLAT_HASH_MAP_H_
+
+#include <cstring>
+#include <type_traits>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "hermes_shm/data_structures/ipc/internal/shm_internal.h"
+
+namespace hshm::ipc {
+
+/** forward pointer for flat_hash_map */
+template<typename Key, typename T, class Hash = std::hash<Key>>
+class flat_hash_map;
+
+/** Control byte of an empty slot */
+#define FLAT_HASH_CTRL_EMPTY static_cast<int8_t>(-128)
+/** Control byte of an erased slot */
+#define FLAT_HASH_CTRL_DELETED static_cast<int8_t>(-2)
+
+/**
+ * A group of 16 control bytes, probed in parallel.
+ * Each bit of a returned mask corresponds to one slot of the group.
+ * */
+struct flat_hash_group {
+  static const size_t width_ = 16;
+#ifdef __SSE2__
+  __m128i ctrl_;
+
+  /** Load the group starting at \a ctrl */
+  HSHM_ALWAYS_INLINE explicit flat_hash_group(const int8_t *ctrl)
+  : ctrl_(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl))) {}
+
+  /** Slots whose control byte is \a h2 */
+  HSHM_ALWAYS_INLINE uint32_t Match(int8_t h2) const {
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl_));
+  }
+
+  /** Slots which are empty */
+  HSHM_ALWAYS_INLINE uint32_t MatchEmpty() const {
+    return Match(FLAT_HASH_CTRL_EMPTY);
+  }
+
+  /** Slots which are empty or erased (the sign bit is set) */
+  HSHM_ALWAYS_INLINE uint32_t MatchEmptyOrDeleted() const {
+    return _mm_movemask_epi8(ctrl_);
+  }
+#else
+  int8_t ctrl_[width_];
+
+  /** Load the group starting at \a ctrl */
+  HSHM_ALWAYS_INLINE explicit flat_hash_group(const int8_t *ctrl) {
+    memcpy(ctrl_, ctrl, width_);
+  }
+
+  /** Slots whose control byte is \a h2 */
+  HSHM_ALWAYS_INLINE uint32_t Match(int8_t h2) const {
+    uint32_t mask = 0;
+    for (size_t i = 0; i < width_; ++i) {
+      mask |= static_cast<uint32_t>(ctrl_[i] == h2) << i;
+    }
+    return mask;
+  }
+
+  /** Slots which are empty */
+  HSHM_ALWAYS_INLINE uint32_t MatchEmpty() const {
+    return Match(FLAT_HASH_CTRL_EMPTY);
+  }
+
+  /** Slots which are empty or erased (the sign bit is set) */
+  HSHM_ALWAYS_INLINE uint32_t MatchEmptyOrDeleted() const {
+    uint32_t mask = 0;
+    for (size_t i = 0; i < width_; ++i) {
+      mask |= static_cast<uint32_t>(ctrl_[i] < 0) << i;
+    }
+    return mask;
+  }
+#endif
+};
+
+/** A (key, value) slot stored inline in the table */
+template<typename Key, typename T>
+struct flat_hash_slot {
+  Key key_;
+  T val_;
+
+  /** Get the key */
+  HSHM_ALWAYS_INLINE Key& GetKey() { return key_; }
+  /** Get the key (const) */
+  HSHM_ALWAYS_INLINE const Key& GetKey() const { return key_; }
+  /** Get the value */
+  HSHM_ALWAYS_INLINE T& GetVal() { return val_; }
+  /** Get the value (const) */
+  HSHM_ALWAYS_INLINE const T& GetVal() const { return val_; }
+};
+
+/**
+ * The flat_hash_map iterator. Visits every full slot in table order.
+ * */
+template<typename Key, typename T, class Hash>
+struct flat_hash_map_iterator {
+  typedef flat_hash_slot<Key, T> SLOT_T;
+  int8_t *ctrl_;
+  SLOT_T *slots_;
+  size_t idx_;
+  size_t capacity_;
+
+  /** Construct an iterator at \a idx and advance to a full slot */
+  HSHM_ALWAYS_INLINE flat_hash_map_iterator(int8_t *ctrl, SLOT_T *slots,
+                                            size_t idx, size_t capacity)
+  : ctrl_(ctrl), slots_(slots), idx_(idx), capacity_(capacity) {
+    make_correct();
+  }
+
+  /** Get the pointed slot */
+  HSHM_ALWAYS_INLINE SLOT_T& operator*() const {
+    return slots_[idx_];
+  }
+
+  /** Get the pointed slot */
+  HSHM_ALWAYS_INLINE SLOT_T* operator->() const {
+    return &slots_[idx_];
+  }
+
+  /** Go to the next full slot */
+  HSHM_ALWAYS_INLINE flat_hash_map_iterator& operator++() {
+    ++idx_;
+    make_correct();
+    return *this;
+  }
+
+  /** Skip slots which are empty or erased */
+  HSHM_ALWAYS_INLINE void make_correct() {
+    while (idx_ < capacity_ && ctrl_[idx_] < 0) {
+      ++idx_;
+    }
+  }
+
+  /** Check if two iterators are equal */
+  HSHM_ALWAYS_INLINE friend bool operator==(
+    const flat_hash_map_iterator &a, const flat_hash_map_iterator &b) {
+    return a.idx_ == b.idx_;
+  }
+
+  /** Check if two iterators are inequal */
+  HSHM_ALWAYS_INLINE friend bool operator!=(
+    const flat_hash_map_iterator &a, const flat_hash_map_iterator &b) {
+    return a.idx_ != b.idx_;
+  }
+
+  /** Determine whether this iterator is the end iterator */
+  HSHM_ALWAYS_INLINE bool is_end() const {
+    return idx_ >= capacity_;
+  }
+};
+
+/**
+ * MACROS used to simplify the flat_hash_map namespace
+ * Used as inputs to the SHM_CONTAINER_TEMPLATE
+ * */
+#define CLASS_NAME flat_hash_map
+#define TYPED_CLASS flat_hash_map<Key, T, Hash>
+#define TYPED_HEADER ShmHeader<flat_hash_map<Key, T, Hash>>
+
+/**
+ * An open-addressing hash map in the style of a Swiss table.
+ *
+ * The table is a single allocation: (capacity + 16) control bytes followed
+ * by capacity inline slots. A control byte holds 7 bits of the key's hash
+ * when the slot is full, or marks the slot empty or erased. Lookups
+ * compare 16 control bytes at a time and only touch the slots whose
+ * control byte matches, so they neither allocate nor chase pointers.
+ * The first 16 control bytes are mirrored after the last, so a group can
+ * be loaded from any slot without wrapping.
+ *
+ * Keys and values must be trivially copyable.
+ * */
+template<typename Key, typename T, class Hash>
+class flat_hash_map : public ShmContainer {
+ public:
+  SHM_CONTAINER_TEMPLATE((CLASS_NAME), (TYPED_CLASS))
+  static_assert(std::is_trivially_copyable_v<Key> &&
+                std::is_trivially_copyable_v<T>,
+                "flat_hash_map requires trivially copyable keys and values");
+
+  /**====================================
+   * Typedefs
+   * ===================================*/
+  typedef flat_hash_slot<Key, T> SLOT_T;
+  typedef flat_hash_map_iterator<Key, T, Hash> iterator_t;
+
+  /**====================================
+   * Variables
+   * ===================================*/
+  OffsetPointer table_ptr_;  /**< Control bytes followed by slots */
+  size_t capacity_;  /**< Number of slots. A power of two, or 0. */
+  size_t length_;  /**< Number of full slots */
+  size_t growth_left_;  /**< Empty slots usable before a rehash */
+
+  /** The group width */
+  static const size_t width_ = flat_hash_group::width_;
+
+ public:
+  /**====================================
+   * Default Constructor
+   * ===================================*/
+
+  /**
+   * SHM constructor. Initialize the map.
+   *
+   * @param alloc the shared-memory allocator
+   * @param num_elements the number of elements to reserve space for
+   * */
+  explicit flat_hash_map(Allocator *alloc, size_t num_elements = 0) {
+    shm_init_container(alloc);
+    SetNull();
+    reserve(num_elements);
+  }
+
+  /**====================================
+   * Copy Constructors
+   * ===================================*/
+
+  /** SHM copy constructor */
+  explicit flat_hash_map(Allocator *alloc, const flat_hash_map &other) {
+    shm_init_container(alloc);
+    SetNull();
+    shm_strong_copy_construct_and_op(other);
+  }
+
+  /** SHM copy assignment operator */
+  flat_hash_map& operator=(const flat_hash_map &other) {
+    if (this != &other) {
+      shm_destroy();
+      shm_strong_copy_construct_and_op(other);
+    }
+    return *this;
+  }
+
+  /** SHM copy constructor + operator main. Copies the table verbatim. */
+  void shm_strong_copy_construct_and_op(const flat_hash_map &other) {
+    if (other.capacity_ == 0) {
+      return;
+    }
+    size_t table_size = GetTableSize(other.capacity_);
+    char *table = GetAllocator()->template
+      AllocatePtr<char, OffsetPointer>(table_size, table_ptr_);
+    memcpy(table, other.GetTable(), table_size);
+    capacity_ = other.capacity_;
+    length_ = other.length_;
+    growth_left_ = other.growth_left_;
+  }
+
+  /**====================================
+   * Move Constructors
+   * ===================================*/
+
+  /** SHM move constructor. */
+  flat_hash_map(Allocator *alloc, flat_hash_map &&other) noexcept {
+    shm_init_container(alloc);
+    if (GetAllocator() == other.GetAllocator()) {
+      strong_copy(other);
+      other.SetNull();
+    } else {
+      SetNull();
+      shm_strong_copy_construct_and_op(other);
+      other.shm_destroy();
+    }
+  }
+
+  /** SHM move assignment operator. */
+  flat_hash_map& operator=(flat_hash_map &&other) noexcept {
+    if (this != &other) {
+      shm_destroy();
+      if (GetAllocator() == other.GetAllocator()) {
+        strong_copy(other);
+        other.SetNull();
+      } else {
+        shm_strong_copy_construct_and_op(other);
+        other.shm_destroy();
+      }
+    }
+    return *this;
+  }
+
+  /** Copy the table header */
+  HSHM_ALWAYS_INLINE void strong_copy(const flat_hash_map &other) {
+    table_ptr_ = other.table_ptr_;
+    capacity_ = other.capacity_;
+    length_ = other.length_;
+    growth_left_ = other.growth_left_;
+  }
+
+  /**====================================
+   * Destructor
+   * ===================================*/
+
+  /** Check if the map has no table */
+  HSHM_ALWAYS_INLINE bool IsNull() const {
+    return table_ptr_.IsNull();
+  }
+
+  /** Sets this map as empty */
+  HSHM_ALWAYS_INLINE void SetNull() {
+    table_ptr_.SetNull();
+    capacity_ = 0;
+    length_ = 0;
+    growth_left_ = 0;
+  }
+
+  /** Free the table */
+  HSHM_ALWAYS_INLINE void shm_destroy_main() {
+    GetAllocator()->Free(table_ptr_);
+  }
+
+  /**====================================
+   * Emplace Methods
+   * ===================================*/
+
+  /**
+   * Construct an object directly in the map. Overrides the object if
+   * key already exists.
+   * */
+  template<typename ...Args>
+  bool emplace(const Key &key, Args&&... args) {
+    return emplace_templ<true>(key, std::forward<Args>(args)...);
+  }
+
+  /**
+   * Construct an object directly in the map. Does not modify the key
+   * if it already exists.
+   * */
+  template<typename ...Args>
+  bool try_emplace(const Key &key, Args&&... args) {
+    return emplace_templ<false>(key, std::forward<Args>(args)...);
+  }
+
+  /**====================================
+   * Erase Methods
+   * ===================================*/
+
+  /** Erase an object indexable by \a key */
+  void erase(const Key &key) {
+    size_t idx;
+    if (find_idx(key, HashKey(key), idx)) {
+      SetCtrl(idx, FLAT_HASH_CTRL_DELETED);
+      --length_;
+    }
+  }
+
+  /** Erase the object at the iterator */
+  void erase(iterator_t &iter) {
+    if (iter.is_end()) { return; }
+    SetCtrl(iter.idx_, FLAT_HASH_CTRL_DELETED);
+    --length_;
+  }
+
+  /** Erase the entire map, keeping its capacity */
+  void clear() {
+    if (capacity_ == 0) { return; }
+    memset(GetCtrl(), FLAT_HASH_CTRL_EMPTY, capacity_ + width_);
+    length_ = 0;
+    growth_left_ = GetMaxLoad(capacity_);
+  }
+
+  /**====================================
+   * Index Methods
+   * ===================================*/
+
+  /**
+   * Locate an entry in the map
+   *
+   * @return the object pointed by key
+   * @exception UNORDERED_MAP_CANT_FIND the key was not in the map
+   * */
+  HSHM_ALWAYS_INLINE T& operator[](const Key &key) {
+    size_t idx;
+    if (find_idx(key, HashKey(key), idx)) {
+      return GetSlots()[idx].val_;
+    }
+    throw UNORDERED_MAP_CANT_FIND.format();
+  }
+
+  /** Find an object in the map */
+  HSHM_ALWAYS_INLINE iterator_t find(const Key &key) {
+    size_t idx;
+    if (find_idx(key, HashKey(key), idx)) {
+      return iterator_t(GetCtrl(), GetSlots(), idx, capacity_);
+    }
+    return end();
+  }
+
+  /**====================================
+   * Query Methods
+   * ===================================*/
+
+  /** The number of entries in the map */
+  HSHM_ALWAYS_INLINE size_t size() const {
+    return length_;
+  }
+
+  /** The number of slots in the map */
+  HSHM_ALWAYS_INLINE size_t capacity() const {
+    return capacity_;
+  }
+
+  /** Make room for \a num_elements entries without rehashing */
+  void reserve(size_t num_elements) {
+    size_t capacity = width_;
+    while (GetMaxLoad(capacity) < num_elements) {
+      capacity *= 2;
+    }
+    if (capacity > capacity_) {
+      rehash(capacity);
+    }
+  }
+
+  /**====================================
+   * Iterators
+   * ===================================*/
+
+  /** Forward iterator begin */
+  HSHM_ALWAYS_INLINE iterator_t begin() const {
+    return iterator_t(GetCtrl(), GetSlots(), 0, capacity_);
+  }
+
+  /** Forward iterator end */
+  HSHM_ALWAYS_INLINE iterator_t end() const {
+    return iterator_t(GetCtrl(), GetSlots(), capacity_, capacity_);
+  }
+
+ private:
+  /**====================================
+   * Helpers
+   * ===================================*/
+
+  /** Insert a (key, value) pair */
+  template<bool modify_existing, typename ...Args>
+  HSHM_ALWAYS_INLINE bool emplace_templ(const Key &key, Args&& ...args) {
+    size_t hash = HashKey(key);
+    size_t idx;
+    if (find_idx(key, hash, idx)) {
+      if constexpr(!modify_existing) {
+        return false;
+      } else {
+        new (&GetSlots()[idx].val_) T(std::forward<Args>(args)...);
+        return true;
+      }
+    }
+    idx = find_insert_idx(hash);
+    if (growth_left_ == 0 && GetCtrl()[idx] == FLAT_HASH_CTRL_EMPTY) {
+      Grow();
+      idx = find_insert_idx(hash);
+    }
+    if (GetCtrl()[idx] == FLAT_HASH_CTRL_EMPTY) {
+      --growth_left_;
+    }
+    SLOT_T &slot = GetSlots()[idx];
+    new (&slot.key_) Key(key);
+    new (&slot.val_) T(std::forward<Args>(args)...);
+    SetCtrl(idx, H2(hash));
+    ++length_;
+    return true;
+  }
+
+  /** Find the slot containing \a key */
+  HSHM_ALWAYS_INLINE bool find_idx(const Key &key, size_t hash,
+                                   size_t &idx) const {
+    if (capacity_ == 0) { return false; }
+    char *table = GetTable();
+    const int8_t *ctrl = reinterpret_cast<int8_t*>(table);
+    SLOT_T *slots = reinterpret_cast<SLOT_T*>(table + GetSlotsOff(capacity_));
+    size_t mask = capacity_ - 1;
+    size_t pos = H1(hash) & mask;
+    int8_t h2 = H2(hash);
+    for (size_t probe = 1; ; ++probe) {
+      flat_hash_group group(ctrl + pos);
+      for (uint32_t match = group.Match(h2); match; match &= match - 1) {
+        size_t i = (pos + __builtin_ctz(match)) & mask;
+        if (slots[i].key_ == key) {
+          idx = i;
+          return true;
+        }
+      }
+      if (group.MatchEmpty()) {
+        return false;
+      }
+      pos = (pos + probe * width_) & mask;
+    }
+  }
+
+  /** Find the first empty or erased slot on the probe path of \a hash */
+  HSHM_ALWAYS_INLINE size_t find_insert_idx(size_t hash) {
+    if (capacity_ == 0) {
+      Grow();
+    }
+    const int8_t *ctrl = GetCtrl();
+    size_t mask = capacity_ - 1;
+    size_t pos = H1(hash) & mask;
+    for (size_t probe = 1; ; ++probe) {
+      flat_hash_group group(ctrl + pos);
+      uint32_t match = group.MatchEmptyOrDeleted();
+      if (match) {
+        return (pos + __builtin_ctz(match)) & mask;
+      }
+      pos = (pos + probe * width_) & mask;
+    }
+  }
+
+  /**
+   * Rehash once the table has no empty slots left. If erased slots make up
+   * much of the table, rehash at the same capacity to drop them.
+   * */
+  void Grow() {
+    if (capacity_ == 0) {
+      rehash(width_);
+    } else if (length_ < GetMaxLoad(capacity_) / 2) {
+      rehash(capacity_);
+    } else {
+      rehash(capacity_ * 2);
+    }
+  }
+
+  /** Move every entry into a new table with \a capacity slots */
+  void rehash(size_t capacity) {
+    OffsetPointer old_ptr = table_ptr_;
+    size_t old_capacity = capacity_;
+    const int8_t *old_ctrl = GetCtrl();
+    SLOT_T *old_slots = GetSlots();
+
+    // Allocate a new table where every slot is empty
+    GetAllocator()->template
+      AllocatePtr<char, OffsetPointer>(GetTableSize(capacity), table_ptr_);
+    capacity_ = capacity;
+    length_ = 0;
+    clear();
+
+    // Copy every full slot into the new table
+    for (size_t i = 0; i < old_capacity; ++i) {
+      if (old_ctrl[i] < 0) { continue; }
+      SLOT_T &old_slot = old_slots[i];
+      size_t hash = HashKey(old_slot.key_);
+      size_t idx = find_insert_idx(hash);
+      memcpy(&GetSlots()[idx], &old_slot, sizeof(SLOT_T));
+      SetCtrl(idx, H2(hash));
+      --growth_left_;
+      ++length_;
+    }
+    if (!old_ptr.IsNull()) {
+      GetAllocator()->Free(old_ptr);
+    }
+  }
+
+  /** Set the control byte of slot \a idx and its mirror */
+  HSHM_ALWAYS_INLINE void SetCtrl(size_t idx, int8_t h) {
+    int8_t *ctrl = GetCtrl();
+    ctrl[idx] = h;
+    if (idx < width_) {
+      ctrl[capacity_ + idx] = h;
+    }
+  }
+
+  /** Hash a key, mixing the bits so that H1 and H2 are independent */
+  HSHM_ALWAYS_INLINE static size_t HashKey(const Key &key) {
+    uint64_t hash = static_cast<uint64_t>(Hash{}(key));
+    hash *= 0x9E3779B97F4A7C15ull;
+    return static_cast<size_t>(hash ^ (hash >> 32));
+  }
+
+  /** The part of the hash choosing the first group to probe */
+  HSHM_ALWAYS_INLINE static size_t H1(size_t hash) {
+    return hash >> 7;
+  }
+
+  /** The part of the hash stored in the control byte */
+  HSHM_ALWAYS_INLINE static int8_t H2(size_t hash) {
+    return static_cast<int8_t>(hash & 0x7F);
+  }
+
+  /** The number of entries allowed before growth (7/8 load factor) */
+  HSHM_ALWAYS_INLINE static size_t GetMaxLoad(size_t capacity) {
+    return capacity - capacity / 8;
+  }
+
+  /** The offset of the slots in the table */
+  HSHM_ALWAYS_INLINE static size_t GetSlotsOff(size_t capacity) {
+    size_t align = alignof(SLOT_T) < 16 ? 16 : alignof(SLOT_T);
+    return (capacity + width_ + align - 1) / align * align;
+  }
+
+  /** The total size of a table with \a capacity slots */
+  HSHM_ALWAYS_INLINE static size_t GetTableSize(size_t capacity) {
+    return GetSlotsOff(capacity) + capacity * sizeof(SLOT_T);
+  }
+
+  /** Get the start of the table */
+  HSHM_ALWAYS_INLINE char* GetTable() const {
+    if (table_ptr_.IsNull()) { return nullptr; }
+    return GetAllocator()->template Convert<char>(table_ptr_);
+  }
+
+  /** Get the control bytes */
+  HSHM_ALWAYS_INLINE int8_t* GetCtrl() const {
+    return reinterpret_cast<int8_t*>(GetTable());
+  }
+
+  /** Get the slots */
+  HSHM_ALWAYS_INLINE SLOT_T* GetSlots() const {
+    char *table = GetTable();
+    if (table == nullptr) { return nullptr; }
+    return reinterpret_cast<SLOT_T*>(table + GetSlotsOff(capacity_));
+  }
+};
+
+}  // namespace hshm::ipc
+
+#undef TYPED_HEADER
+#undef TYPED_CLASS
+#undef CLASS_NAME
+
+#endif  // HERMES_DATA_STRUCTURES_FLAT_HASH_MAP_H_
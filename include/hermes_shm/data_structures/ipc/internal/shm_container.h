@@ -19,6 +19,10 @@
 #include "shm_container_macro.h"
 #include "shm_macros.h"
 
+/** The members of a shared-memory container */
+#define SHM_CONTAINER_TEMPLATE(CLASS_NAME, TYPED_CLASS) \
+  SHM_CONTAINER_PRIVATE_TEMPLATE(CLASS_NAME, TYPED_CLASS, (false))
+
 namespace hipc = hshm::ipc;
 
 namespace hshm::ipc {
@@ -67,6 +71,87 @@ struct ShmWrapperHeader {};
  * */
 class ShmContainer {};
 
+/**
+ * Whether an object of type T can be moved to a new address with memcpy,
+ * skipping its move constructor and destructor. ShmContainers refer to
+ * their data by allocator offsets and never point into themselves, so
+ * they are relocatable. Specialize this for other relocatable types.
+ * */
+template<typename T>
+struct is_trivially_relocatable
+  : std::integral_constant<bool, std::is_trivially_copyable_v<T> ||
+                                 std::is_base_of_v<ShmContainer, T>> {};
+
+/** Shorthand for is_trivially_relocatable<T>::value */
+template<typename T>
+inline constexpr bool is_trivially_relocatable_v =
+  is_trivially_relocatable<T>::value;
+
+/**
+ * How a container refers to its allocator and turns the offsets it stores
+ * into pointers. A shared-memory container stores the allocator id, so any
+ * process can look the allocator up in the registry and add its buffer
+ * base to offsets.
+ * */
+template<bool PRIVATE>
+struct ShmAllocRef {
+  allocator_id_t id_;
+
+  /** Whether a container can refer to the allocator. Always true. */
+  HSHM_ALWAYS_INLINE static bool IsCompatible(Allocator *) {
+    return true;
+  }
+
+  /** Refer to \a alloc */
+  HSHM_ALWAYS_INLINE void Set(Allocator *alloc) {
+    id_ = alloc->GetId();
+  }
+
+  /** Get the allocator */
+  HSHM_ALWAYS_INLINE Allocator* Get() const {
+    return HERMES_MEMORY_REGISTRY_REF.GetAllocator(id_);
+  }
+
+  /** Convert an offset of the allocator into a pointer */
+  template<typename T, typename POINTER_T>
+  HSHM_ALWAYS_INLINE T* Convert(const POINTER_T &p) const {
+    return Get()->template Convert<T, POINTER_T>(p);
+  }
+};
+
+/**
+ * A private container lives in the memory of one process, over an
+ * allocator whose offsets are process addresses (e.g., MallocAllocator).
+ * It stores the allocator pointer and uses offsets as native pointers,
+ * skipping the registry lookup and the buffer translation.
+ * */
+template<>
+struct ShmAllocRef<true> {
+  Allocator *alloc_;
+
+  /** Whether \a alloc stores addresses in its offsets */
+  HSHM_ALWAYS_INLINE static bool IsCompatible(Allocator *alloc) {
+    return alloc->HasNativeOffsets();
+  }
+
+  /** Refer to \a alloc. The caller checks IsCompatible. */
+  HSHM_ALWAYS_INLINE void Set(Allocator *alloc) {
+    alloc_ = alloc;
+  }
+
+  /** Get the allocator */
+  HSHM_ALWAYS_INLINE Allocator* Get() const {
+    return alloc_;
+  }
+
+  /** Convert an offset of the allocator into a pointer */
+  template<typename T, typename POINTER_T>
+  HSHM_ALWAYS_INLINE T* Convert(const POINTER_T &p) const {
+    if (p.IsNull()) { return nullptr; }
+    return reinterpret_cast<T*>(p.off_.load());
+  }
+};
+
 /** Typed nullptr */
 template<typename T>
 HSHM_ALWAYS_INLINE static T* typed_nullptr() {
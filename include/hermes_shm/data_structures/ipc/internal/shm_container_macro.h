@@ -1,11 +1,11 @@
 #ifndef HERMES_DATA_STRUCTURES_INTERNAL_SHM_CONTAINER_MACRO_H_
 #define HERMES_DATA_STRUCTURES_INTERNAL_SHM_CONTAINER_MACRO_H_
-#define SHM_CONTAINER_TEMPLATE(CLASS_NAME,TYPED_CLASS)\
+#define SHM_CONTAINER_PRIVATE_TEMPLATE(CLASS_NAME,TYPED_CLASS,PRIVATE)\
 public:\
 /**====================================\
  * Variables & Types\
  * ===================================*/\
-hipc::allocator_id_t alloc_id_;\
+hipc::ShmAllocRef<TYPE_UNWRAP(PRIVATE)> alloc_id_;\
 \
 /**====================================\
  * Constructors\
@@ -20,9 +20,12 @@ TYPE_UNWRAP(CLASS_NAME)(TYPE_UNWRAP(CLASS_NAME) &&other) = delete;\
 /** Copy constructor. Deleted. */\
 TYPE_UNWRAP(CLASS_NAME)(const TYPE_UNWRAP(CLASS_NAME) &other) = delete;\
 \
-/** Initialize container */\
+/** Initialize container. Throws if the container cannot use alloc. */\
 void shm_init_container(hipc::Allocator *alloc) {\
-  alloc_id_ = alloc->GetId();\
+  if (!alloc_id_.IsCompatible(alloc)) {\
+    throw hshm::PRIVATE_CONTAINER_ALLOCATOR.format();\
+  }\
+  alloc_id_.Set(alloc);\
 }\
 \
 /**====================================\
@@ -55,12 +58,18 @@ HSHM_ALWAYS_INLINE POINTER_T GetShmPointer() const {\
 \
 /** Get the allocator for this container */\
 HSHM_ALWAYS_INLINE hipc::Allocator* GetAllocator() const {\
-  return HERMES_MEMORY_REGISTRY_REF.GetAllocator(alloc_id_);\
+  return alloc_id_.Get();\
 }\
 \
 /** Get the shared-memory allocator id */\
 HSHM_ALWAYS_INLINE hipc::allocator_id_t& GetAllocatorId() const {\
   return GetAllocator()->GetId();\
 }\
+\
+/** Convert an offset stored by this container into a pointer */\
+template<typename OBJ_T, typename POINTER_T = hipc::OffsetPointer>\
+HSHM_ALWAYS_INLINE OBJ_T* ConvertPtr(const POINTER_T &p) const {\
+  return alloc_id_.template Convert<OBJ_T, POINTER_T>(p);\
+}\
 
 #endif  // HERMES_DATA_STRUCTURES_INTERNAL_SHM_CONTAINER_MACRO_H_
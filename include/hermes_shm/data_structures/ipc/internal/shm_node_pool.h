@@ -0,0 +1,146 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HERMES_DATA_STRUCTURES_IPC_INTERNAL_SHM_NODE_POOL_H_
+#define HERMES_DATA_STRUCTURES_IPC_INTERNAL_SHM_NODE_POOL_H_
+
+#include "hermes_shm/memory/memory.h"
+#include "hermes_shm/memory/allocator/allocator.h"
+
+namespace hshm::ipc {
+
+/** The header placed before each chunk of nodes carved by a node_pool */
+struct node_pool_chunk {
+  OffsetPointer next_ptr_;
+};
+
+/**
+ * A per-container freelist of linked-list nodes, stored in shared memory.
+ * Free nodes are threaded through their own next_ptr_.
+ *
+ * When chunk_nodes_ is 1, nodes are allocated one at a time and at most
+ * max_free_ of them are kept for reuse; the rest go back to the allocator.
+ *
+ * When chunk_nodes_ is larger, nodes are carved out of chunks so that
+ * neighbors sit next to each other in memory. Such nodes cannot be freed
+ * individually, so they always return to the freelist. Once the container
+ * drains, the chunks are released if more than max_free_ nodes are idle.
+ * */
+template<typename EntryT>
+struct node_pool {
+  OffsetPointer free_ptr_;   /**< The first free node */
+  OffsetPointer chunk_ptr_;  /**< The most recently carved chunk */
+  size_t free_count_;        /**< The number of free nodes */
+  size_t max_free_;          /**< The high-water mark of free nodes */
+  size_t chunk_nodes_;       /**< The number of nodes per chunk */
+
+  /** Initialize an empty pool */
+  void shm_init(size_t max_free, size_t chunk_nodes) {
+    free_ptr_.SetNull();
+    chunk_ptr_.SetNull();
+    free_count_ = 0;
+    max_free_ = max_free;
+    chunk_nodes_ = chunk_nodes ? chunk_nodes : 1;
+  }
+
+  /** Get a node from the freelist, carving or allocating one if empty */
+  HSHM_ALWAYS_INLINE EntryT* AllocateEntry(Allocator *alloc,
+                                           OffsetPointer &p) {
+    if (free_ptr_.IsNull()) {
+      if (chunk_nodes_ == 1) {
+        return alloc->template AllocateObjs<EntryT>(1, p);
+      }
+      CarveChunk(alloc);
+    }
+    p = free_ptr_;
+    auto entry = alloc->template Convert<EntryT>(p);
+    free_ptr_ = entry->next_ptr_;
+    --free_count_;
+    return entry;
+  }
+
+  /** Return a node to the freelist, or to the allocator past the cap */
+  HSHM_ALWAYS_INLINE void FreeEntry(Allocator *alloc,
+                                    OffsetPointer p, EntryT *entry) {
+    if (chunk_nodes_ == 1 && free_count_ >= max_free_) {
+      alloc->Free(p);
+      return;
+    }
+    entry->next_ptr_ = free_ptr_;
+    free_ptr_ = p;
+    ++free_count_;
+  }
+
+  /** Release idle chunks. Only valid when the container holds no nodes. */
+  void Trim(Allocator *alloc) {
+    if (chunk_nodes_ > 1 && free_count_ > max_free_) {
+      FreeChunks(alloc);
+    }
+  }
+
+  /** Release every node held by the pool */
+  void shm_destroy(Allocator *alloc) {
+    if (chunk_nodes_ > 1) {
+      FreeChunks(alloc);
+      return;
+    }
+    while (!free_ptr_.IsNull()) {
+      OffsetPointer p = free_ptr_;
+      free_ptr_ = alloc->template Convert<EntryT>(p)->next_ptr_;
+      alloc->Free(p);
+    }
+    free_count_ = 0;
+  }
+
+ private:
+  /** The offset of the first node past a chunk header */
+  static constexpr size_t HeaderSize() {
+    return (sizeof(node_pool_chunk) + alignof(EntryT) - 1) /
+      alignof(EntryT) * alignof(EntryT);
+  }
+
+  /** Allocate a chunk and push its nodes on the freelist in order */
+  void CarveChunk(Allocator *alloc) {
+    OffsetPointer chunk_p;
+    auto chunk = alloc->template AllocatePtr<node_pool_chunk, OffsetPointer>(
+      HeaderSize() + chunk_nodes_ * sizeof(EntryT), chunk_p);
+    if (chunk == nullptr) {
+      throw OUT_OF_MEMORY.format(
+        HeaderSize() + chunk_nodes_ * sizeof(EntryT), "unknown");
+    }
+    chunk->next_ptr_ = chunk_ptr_;
+    chunk_ptr_ = chunk_p;
+    auto nodes = reinterpret_cast<EntryT*>(
+      reinterpret_cast<char*>(chunk) + HeaderSize());
+    OffsetPointer node_p = chunk_p + HeaderSize();
+    for (size_t i = chunk_nodes_; i > 0; --i) {
+      nodes[i - 1].next_ptr_ = free_ptr_;
+      free_ptr_ = node_p + (i - 1) * sizeof(EntryT);
+    }
+    free_count_ += chunk_nodes_;
+  }
+
+  /** Free every chunk and forget the nodes carved from them */
+  void FreeChunks(Allocator *alloc) {
+    while (!chunk_ptr_.IsNull()) {
+      OffsetPointer p = chunk_ptr_;
+      chunk_ptr_ = alloc->template Convert<node_pool_chunk>(p)->next_ptr_;
+      alloc->Free(p);
+    }
+    free_ptr_.SetNull();
+    free_count_ = 0;
+  }
+};
+
+}  // namespace hshm::ipc
+
+#endif  // HERMES_DATA_STRUCTURES_IPC_INTERNAL_SHM_NODE_POOL_H_
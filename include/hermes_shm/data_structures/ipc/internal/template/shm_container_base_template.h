@@ -2,7 +2,7 @@ public:
 /**====================================
  * Variables & Types
  * ===================================*/
-hipc::allocator_id_t alloc_id_;
+hipc::ShmAllocRef<PRIVATE> alloc_id_;
 
 /**====================================
  * Constructors
@@ -17,9 +17,12 @@ CLASS_NAME(CLASS_NAME &&other) = delete;
 /** Copy constructor. Deleted. */
 CLASS_NAME(const CLASS_NAME &other) = delete;
 
-/** Initialize container */
+/** Initialize container. Throws if the container cannot use alloc. */
 void shm_init_container(hipc::Allocator *alloc) {
-  alloc_id_ = alloc->GetId();
+  if (!alloc_id_.IsCompatible(alloc)) {
+    throw hshm::PRIVATE_CONTAINER_ALLOCATOR.format();
+  }
+  alloc_id_.Set(alloc);
 }
 
 /**====================================
@@ -52,10 +55,16 @@ HSHM_ALWAYS_INLINE POINTER_T GetShmPointer() const {
 
 /** Get the allocator for this container */
 HSHM_ALWAYS_INLINE hipc::Allocator* GetAllocator() const {
-  return HERMES_MEMORY_REGISTRY_REF.GetAllocator(alloc_id_);
+  return alloc_id_.Get();
 }
 
 /** Get the shared-memory allocator id */
 HSHM_ALWAYS_INLINE hipc::allocator_id_t& GetAllocatorId() const {
   return GetAllocator()->GetId();
+}
+
+/** Convert an offset stored by this container into a pointer */
+template<typename OBJ_T, typename POINTER_T = hipc::OffsetPointer>
+HSHM_ALWAYS_INLINE OBJ_T* ConvertPtr(const POINTER_T &p) const {
+  return alloc_id_.template Convert<OBJ_T, POINTER_T>(p);
 }
\ No newline at end of file
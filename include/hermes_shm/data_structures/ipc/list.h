@@ -15,6 +15,7 @@
 #define HERMES_DATA_STRUCTURES_THREAD_UNSAFE_LIST_H_
 
 #include "hermes_shm/data_structures/ipc/internal/shm_internal.h"
+#include "hermes_shm/data_structures/ipc/internal/shm_node_pool.h"
 #include "hermes_shm/data_structures/containers/functional.h"
 #include "hermes_shm/data_structures/serialization/serialize_common.h"
 
@@ -23,7 +24,7 @@
 namespace hshm::ipc {
 
 /** forward pointer for list */
-template<typename T>
+template<typename T, bool PRIVATE = false>
 class list;
 
 /** represents an object within a list */
@@ -37,11 +38,11 @@ struct list_entry {
 /**
  * The list iterator
  * */
-template<typename T>
+template<typename T, bool PRIVATE>
 struct list_iterator_templ {
  public:
   /**< A shm reference to the containing list object. */
-  list<T> *list_;
+  list<T, PRIVATE> *list_;
   /**< A pointer to the entry in shared memory */
   list_entry<T> *entry_;
   /**< The offset of the entry in the shared-memory allocator */
@@ -51,7 +52,7 @@ struct list_iterator_templ {
   list_iterator_templ() = default;
 
   /** Construct an iterator  */
-  explicit list_iterator_templ(list<T> &list,
+  explicit list_iterator_templ(list<T, PRIVATE> &list,
                                list_entry<T> *entry,
                                OffsetPointer entry_ptr)
     : list_(&list), entry_(entry), entry_ptr_(entry_ptr) {}
@@ -87,8 +88,7 @@ struct list_iterator_templ {
   list_iterator_templ& operator++() {
     if (is_end()) { return *this; }
     entry_ptr_ = entry_->next_ptr_;
-    entry_ = list_->GetAllocator()->template
-      Convert<list_entry<T>>(entry_->next_ptr_);
+    entry_ = list_->template ConvertPtr<list_entry<T>>(entry_->next_ptr_);
     return *this;
   }
 
@@ -96,8 +96,7 @@ struct list_iterator_templ {
   list_iterator_templ& operator--() {
     if (is_end() || is_begin()) { return *this; }
     entry_ptr_ = entry_->prior_ptr_;
-    entry_ = list_->GetAllocator()->template
-      Convert<list_entry<T>>(entry_->prior_ptr_);
+    entry_ = list_->template ConvertPtr<list_entry<T>>(entry_->prior_ptr_);
     return *this;
   }
 
@@ -179,18 +178,19 @@ struct list_iterator_templ {
  * Used as inputs to the SHM_CONTAINER_TEMPLATE
  * */
 #define CLASS_NAME list
-#define TYPED_CLASS list<T>
-#define TYPED_HEADER ShmHeader<list<T>>
+#define TYPED_CLASS list<T, PRIVATE>
+#define TYPED_HEADER ShmHeader<list<T, PRIVATE>>
 
 /**
  * Doubly linked list implementation
  * */
-template<typename T>
+template<typename T, bool PRIVATE>
 class list : public ShmContainer {
  public:
-  SHM_CONTAINER_TEMPLATE((CLASS_NAME), (TYPED_CLASS))
+  SHM_CONTAINER_PRIVATE_TEMPLATE((CLASS_NAME), (TYPED_CLASS), (PRIVATE))
   OffsetPointer head_ptr_, tail_ptr_;
   size_t length_;
+  OffsetPointer pool_ptr_;
 
  public:
   /**====================================
@@ -198,9 +198,9 @@ class list : public ShmContainer {
    * ===================================*/
 
   /** forward iterator typedef */
-  typedef list_iterator_templ<T> iterator_t;
+  typedef list_iterator_templ<T, PRIVATE> iterator_t;
   /** const forward iterator typedef */
-  typedef list_iterator_templ<T> citerator_t;
+  typedef list_iterator_templ<T, PRIVATE> citerator_t;
 
  public:
   /**====================================
@@ -263,9 +263,12 @@ class list : public ShmContainer {
    * Move Constructors
    * ===================================*/
 
-  /** SHM move constructor. */
+  /**
+   * SHM move constructor. This cannot throw, so \a alloc is not checked
+   * against private mode; it must be usable by this container.
+   * */
   list(Allocator *alloc, list &&other) noexcept {
-    shm_init_container(alloc);
+    alloc_id_.Set(alloc);
     if (GetAllocator() == other.GetAllocator()) {
       memcpy((void*) this, (void *) &other, sizeof(*this));
       other.SetNull();
@@ -297,11 +300,12 @@ class list : public ShmContainer {
   /** SHM destructor.  */
   void shm_destroy_main() {
     clear();
+    _destroy_node_pool();
   }
 
-  /** Check if the list is empty */
+  /** Check if the list is empty and holds no pooled nodes */
   bool IsNull() const {
-    return length_ == 0;
+    return length_ == 0 && pool_ptr_.IsNull();
   }
 
   /** Sets this list as empty */
@@ -309,12 +313,32 @@ class list : public ShmContainer {
     length_ = 0;
     head_ptr_.SetNull();
     tail_ptr_.SetNull();
+    pool_ptr_.SetNull();
   }
 
   /**====================================
    * list Methods
    * ===================================*/
 
+  /**
+   * Recycle erased nodes through a freelist local to this list instead of
+   * returning them to the allocator. The list must be empty.
+   *
+   * @param max_free the number of free nodes to keep before returning
+   * them to the allocator
+   * @param chunk_nodes the number of nodes to allocate at once. When larger
+   * than 1, nodes are carved out of contiguous chunks.
+   * */
+  void enable_node_pool(size_t max_free, size_t chunk_nodes = 1) {
+    if (length_ != 0) {
+      throw NODE_POOL_IN_USE.format("list::enable_node_pool");
+    }
+    _destroy_node_pool();
+    auto pool = GetAllocator()->template
+      AllocateObjs<node_pool<list_entry<T>>>(1, pool_ptr_);
+    pool->shm_init(max_free, chunk_nodes);
+  }
+
   /** Construct an element at the back of the list */
   template<typename... Args>
   void emplace_back(Args&&... args) {
@@ -340,25 +364,20 @@ class list : public ShmContainer {
     } else if (pos.is_begin()) {
       entry->prior_ptr_.SetNull();
       entry->next_ptr_ = head_ptr_;
-      auto head = GetAllocator()->template
-        Convert<list_entry<T>>(tail_ptr_);
+      auto head = ConvertPtr<list_entry<T>>(head_ptr_);
       head->prior_ptr_ = entry_ptr;
       head_ptr_ = entry_ptr;
     } else if (pos.is_end()) {
       entry->prior_ptr_ = tail_ptr_;
       entry->next_ptr_.SetNull();
-      auto tail = GetAllocator()->template
-        Convert<list_entry<T>>(tail_ptr_);
+      auto tail = ConvertPtr<list_entry<T>>(tail_ptr_);
       tail->next_ptr_ = entry_ptr;
       tail_ptr_ = entry_ptr;
     } else {
-      auto next = GetAllocator()->template
-        Convert<list_entry<T>>(pos.entry_->next_ptr_);
-      auto prior = GetAllocator()->template
-        Convert<list_entry<T>>(pos.entry_->prior_ptr_);
-      entry->next_ptr_ = pos.entry_->next_ptr_;
+      auto prior = ConvertPtr<list_entry<T>>(pos.entry_->prior_ptr_);
+      entry->next_ptr_ = pos.entry_ptr_;
       entry->prior_ptr_ = pos.entry_->prior_ptr_;
-      next->prior_ptr_ = entry_ptr;
+      pos.entry_->prior_ptr_ = entry_ptr;
       prior->next_ptr_ = entry_ptr;
     }
     ++length_;
@@ -384,7 +403,7 @@ class list : public ShmContainer {
     while (pos != last) {
       auto next = pos + 1;
       HSHM_DESTROY_AR(pos.entry_->data_)
-      GetAllocator()->Free(pos.entry_ptr_);
+      _free_entry(pos.entry_ptr_, pos.entry_);
       --length_;
       pos = next;
     }
@@ -392,8 +411,7 @@ class list : public ShmContainer {
     if (first_prior_ptr.IsNull()) {
       head_ptr_ = last.entry_ptr_;
     } else {
-      auto first_prior = GetAllocator()->template
-        Convert<list_entry<T>>(first_prior_ptr);
+      auto first_prior = ConvertPtr<list_entry<T>>(first_prior_ptr);
       first_prior->next_ptr_ = last.entry_ptr_;
     }
 
@@ -402,6 +420,10 @@ class list : public ShmContainer {
     } else {
       last.entry_->prior_ptr_ = first_prior_ptr;
     }
+
+    if (length_ == 0 && !pool_ptr_.IsNull()) {
+      _node_pool()->Trim(GetAllocator());
+    }
   }
 
   /** Destroy all elements in the list */
@@ -436,8 +458,7 @@ class list : public ShmContainer {
   /** Forward iterator begin */
   iterator_t begin() {
     if (size() == 0) { return end(); }
-    auto head = GetAllocator()->template
-      Convert<list_entry<T>>(head_ptr_);
+    auto head = ConvertPtr<list_entry<T>>(head_ptr_);
     return iterator_t(*this,
       head, head_ptr_);
   }
@@ -445,8 +466,7 @@ class list : public ShmContainer {
   /** Last iterator begin */
   iterator_t last() {
     if (size() == 0) { return end(); }
-    auto tail = GetAllocator()->template
-      Convert<list_entry<T>>(tail_ptr_);
+    auto tail = ConvertPtr<list_entry<T>>(tail_ptr_);
     return iterator_t(*this, tail, tail_ptr_);
   }
 
@@ -458,8 +478,7 @@ class list : public ShmContainer {
   /** Constant forward iterator begin */
   citerator_t cbegin() const {
     if (size() == 0) { return cend(); }
-    auto head = GetAllocator()->template
-      Convert<list_entry<T>>(head_ptr_);
+    auto head = ConvertPtr<list_entry<T>>(head_ptr_);
     return citerator_t(const_cast<list&>(*this),
                        head, head_ptr_);
   }
@@ -477,28 +496,64 @@ class list : public ShmContainer {
   /** Serialize */
   template <typename Ar>
   void save(Ar &ar) const {
-    save_list<Ar, hipc::list<T>, T>(ar, *this);
+    save_list<Ar, list, T>(ar, *this);
   }
 
   /** Deserialize */
   template <typename Ar>
   void load(Ar &ar) {
-    load_list<Ar, hipc::list<T>, T>(ar, *this);
+    load_list<Ar, list, T>(ar, *this);
   }
 
  private:
   template<typename ...Args>
   HSHM_ALWAYS_INLINE list_entry<T>* _create_entry(
     OffsetPointer &p, Args&& ...args) {
-    auto entry = GetAllocator()->template
-      AllocateObjs<list_entry<T>>(1, p);
+    list_entry<T> *entry;
+    if (pool_ptr_.IsNull()) {
+      entry = GetAllocator()->template AllocateObjs<list_entry<T>>(1, p);
+    } else {
+      entry = _node_pool()->AllocateEntry(GetAllocator(), p);
+    }
     HSHM_MAKE_AR(entry->data_, GetAllocator(), std::forward<Args>(args)...)
     return entry;
   }
+
+  /** Release the memory of an entry whose data was already destroyed */
+  HSHM_ALWAYS_INLINE void _free_entry(OffsetPointer p, list_entry<T> *entry) {
+    if (pool_ptr_.IsNull()) {
+      GetAllocator()->Free(p);
+    } else {
+      _node_pool()->FreeEntry(GetAllocator(), p, entry);
+    }
+  }
+
+  /** Get the node pool of this list */
+  HSHM_ALWAYS_INLINE node_pool<list_entry<T>>* _node_pool() {
+    return ConvertPtr<node_pool<list_entry<T>>>(pool_ptr_);
+  }
+
+  /** Free the node pool and every node it holds */
+  void _destroy_node_pool() {
+    if (pool_ptr_.IsNull()) {
+      return;
+    }
+    _node_pool()->shm_destroy(GetAllocator());
+    GetAllocator()->Free(pool_ptr_);
+    pool_ptr_.SetNull();
+  }
 };
 
 }  // namespace hshm::ipc
 
+namespace hshm {
+
+/** A list in private memory */
+template<typename T>
+using list = ipc::list<T, true>;
+
+}  // namespace hshm
+
 #undef CLASS_NAME
 #undef TYPED_CLASS
 #undef TYPED_HEADER
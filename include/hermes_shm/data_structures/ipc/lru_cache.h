@@ -0,0 +1,554 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+* Distributed under BSD 3-Clause license.                                   *
+* Copyright by The HDF Group.                                               *
+* Copyright by the Illinois Institute of Technology.                        *
+* All rights reserved.                                                      *
+*                                                                           *
+* This file is part of Hermes. The full Hermes copyright notice, including  *
+* terms governing use, modification, and redistribution, is contained in    *
+* the COPYING file, which can be found at the top directory. If you do not  *
+* have access to the file, you may request a copy from help@hdfgroup.org.   *
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HERMES_DATA_STRUCTURES_LRU_CACHE_H_
+#define HERMES_DATA_STRUCTURES_LRU_CACHE_H_
+
+#include <atomic>
+#include <functional>
+#include "hermes_shm/data_structures/ipc/internal/shm_internal.h"
+#include "hermes_shm/thread/lock.h"
+
+namespace hshm::ipc {
+
+/** forward pointer for lru_cache */
+template<typename Key, typename T, class Hash = std::hash<Key>>
+class lru_cache;
+
+/** Slot index marking the end of a chain */
+#define LRU_CACHE_NULL UINT32_MAX
+
+/** A cache entry. Slots are preallocated and reused after eviction. */
+template<typename Key, typename T>
+struct lru_cache_slot {
+  ShmArchive<Key> key_;
+  ShmArchive<T> val_;
+  size_t nbytes_;  /**< The size charged against the byte capacity */
+  std::atomic<uint32_t> ref_;  /**< CLOCK reference bit, set on a hit */
+  uint32_t next_;  /**< The next slot of a bucket chain or the free list */
+  uint32_t valid_;  /**< Whether the slot holds an entry */
+
+  /** Get the key */
+  HSHM_ALWAYS_INLINE Key& GetKey() { return *key_; }
+  /** Get the key (const) */
+  HSHM_ALWAYS_INLINE const Key& GetKey() const { return *key_; }
+  /** Get the value */
+  HSHM_ALWAYS_INLINE T& GetVal() { return *val_; }
+  /** Get the value (const) */
+  HSHM_ALWAYS_INLINE const T& GetVal() const { return *val_; }
+};
+
+/**
+ * The lru_cache iterator. Visits every entry in slot order.
+ * */
+template<typename Key, typename T>
+struct lru_cache_iterator {
+  typedef lru_cache_slot<Key, T> SLOT_T;
+  SLOT_T *slots_;
+  size_t idx_;
+  size_t capacity_;
+
+  /** Construct an iterator at \a idx and advance to a valid slot */
+  HSHM_ALWAYS_INLINE lru_cache_iterator(SLOT_T *slots, size_t idx,
+                                        size_t capacity)
+  : slots_(slots), idx_(idx), capacity_(capacity) {
+    make_correct();
+  }
+
+  /** Get the pointed slot */
+  HSHM_ALWAYS_INLINE SLOT_T& operator*() const {
+    return slots_[idx_];
+  }
+
+  /** Get the pointed slot */
+  HSHM_ALWAYS_INLINE SLOT_T* operator->() const {
+    return &slots_[idx_];
+  }
+
+  /** Go to the next valid slot */
+  HSHM_ALWAYS_INLINE lru_cache_iterator& operator++() {
+    ++idx_;
+    make_correct();
+    return *this;
+  }
+
+  /** Skip empty slots */
+  HSHM_ALWAYS_INLINE void make_correct() {
+    while (idx_ < capacity_ && !slots_[idx_].valid_) {
+      ++idx_;
+    }
+  }
+
+  /** Check if two iterators are equal */
+  HSHM_ALWAYS_INLINE friend bool operator==(const lru_cache_iterator &a,
+                                            const lru_cache_iterator &b) {
+    return a.idx_ == b.idx_;
+  }
+
+  /** Check if two iterators are inequal */
+  HSHM_ALWAYS_INLINE friend bool operator!=(const lru_cache_iterator &a,
+                                            const lru_cache_iterator &b) {
+    return a.idx_ != b.idx_;
+  }
+
+  /** Determine whether this iterator is the end iterator */
+  HSHM_ALWAYS_INLINE bool is_end() const {
+    return idx_ >= capacity_;
+  }
+};
+
+/**
+ * MACROS used to simplify the lru_cache namespace
+ * Used as inputs to the SHM_CONTAINER_TEMPLATE
+ * */
+#define CLASS_NAME lru_cache
+#define TYPED_CLASS lru_cache<Key, T, Hash>
+#define TYPED_HEADER ShmHeader<lru_cache<Key, T, Hash>>
+
+/**
+ * A bounded cache in shared memory which evicts approximately least
+ * recently used entries.
+ *
+ * Recency is tracked with the CLOCK algorithm: a hit only sets the
+ * entry's reference bit, so get() runs under a shared lock and never
+ * relinks a list. Eviction sweeps a hand over the slots, clearing set
+ * bits and evicting the first entry whose bit is clear.
+ *
+ * Every slot and bucket is allocated when the cache is constructed, so
+ * neither hits nor insertions allocate cache metadata. The cache is
+ * bounded by a number of entries and, optionally, by the sum of the
+ * sizes passed to put().
+ * */
+template<typename Key, typename T, class Hash>
+class lru_cache : public ShmContainer {
+ public:
+  SHM_CONTAINER_TEMPLATE((CLASS_NAME), (TYPED_CLASS))
+
+  /**====================================
+   * Typedefs
+   * ===================================*/
+  typedef lru_cache_slot<Key, T> SLOT_T;
+  typedef lru_cache_iterator<Key, T> iterator_t;
+
+  /**====================================
+   * Variables
+   * ===================================*/
+  OffsetPointer table_ptr_;  /**< Bucket heads followed by the slots */
+  size_t max_entries_;
+  size_t max_bytes_;  /**< 0 if the cache is only bounded by entries */
+  size_t length_;
+  size_t bytes_;
+  size_t hand_;  /**< The next slot the CLOCK hand inspects */
+  uint32_t free_head_;
+  RwLock lock_;
+
+ public:
+  /**====================================
+   * Default Constructor
+   * ===================================*/
+
+  /** SHM constructor. Default. */
+  explicit lru_cache(Allocator *alloc) {
+    shm_init_container(alloc);
+    SetNull();
+  }
+
+  /**
+   * SHM constructor
+   *
+   * @param max_entries the maximum number of entries
+   * @param max_bytes the maximum sum of entry sizes, or 0 for no limit
+   * */
+  explicit lru_cache(Allocator *alloc, size_t max_entries,
+                     size_t max_bytes = 0) {
+    shm_init_container(alloc);
+    SetNull();
+    AllocateTable(max_entries, max_bytes);
+  }
+
+  /**====================================
+   * Copy Constructors
+   * ===================================*/
+
+  /** SHM copy constructor */
+  explicit lru_cache(Allocator *alloc, const lru_cache &other) {
+    shm_init_container(alloc);
+    SetNull();
+    shm_strong_copy_construct_and_op(other);
+  }
+
+  /** SHM copy assignment operator */
+  lru_cache& operator=(const lru_cache &other) {
+    if (this != &other) {
+      shm_destroy();
+      shm_strong_copy_construct_and_op(other);
+    }
+    return *this;
+  }
+
+  /** SHM copy constructor + operator main */
+  void shm_strong_copy_construct_and_op(const lru_cache &other) {
+    if (other.IsNull()) {
+      return;
+    }
+    AllocateTable(other.max_entries_, other.max_bytes_);
+    for (auto iter = other.begin(); !iter.is_end(); ++iter) {
+      put((*iter).GetKey(), (*iter).GetVal(), (*iter).nbytes_);
+    }
+  }
+
+  /**====================================
+   * Move Constructors
+   * ===================================*/
+
+  /** SHM move constructor. */
+  lru_cache(Allocator *alloc, lru_cache &&other) noexcept {
+    shm_init_container(alloc);
+    if (GetAllocator() == other.GetAllocator()) {
+      strong_copy(other);
+      other.SetNull();
+    } else {
+      SetNull();
+      shm_strong_copy_construct_and_op(other);
+      other.shm_destroy();
+    }
+  }
+
+  /** SHM move assignment operator. */
+  lru_cache& operator=(lru_cache &&other) noexcept {
+    if (this != &other) {
+      shm_destroy();
+      if (GetAllocator() == other.GetAllocator()) {
+        strong_copy(other);
+        other.SetNull();
+      } else {
+        shm_strong_copy_construct_and_op(other);
+        other.shm_destroy();
+      }
+    }
+    return *this;
+  }
+
+  /** Copy the cache header */
+  HSHM_ALWAYS_INLINE void strong_copy(const lru_cache &other) {
+    table_ptr_ = other.table_ptr_;
+    max_entries_ = other.max_entries_;
+    max_bytes_ = other.max_bytes_;
+    length_ = other.length_;
+    bytes_ = other.bytes_;
+    hand_ = other.hand_;
+    free_head_ = other.free_head_;
+    lock_.Init();
+  }
+
+  /**====================================
+   * Destructor
+   * ===================================*/
+
+  /** Check if the cache has no table */
+  HSHM_ALWAYS_INLINE bool IsNull() const {
+    return table_ptr_.IsNull();
+  }
+
+  /** Sets this cache as empty */
+  HSHM_ALWAYS_INLINE void SetNull() {
+    table_ptr_.SetNull();
+    max_entries_ = 0;
+    max_bytes_ = 0;
+    length_ = 0;
+    bytes_ = 0;
+    hand_ = 0;
+    free_head_ = LRU_CACHE_NULL;
+    lock_.Init();
+  }
+
+  /** Destroy every entry and free the table */
+  void shm_destroy_main() {
+    SLOT_T *slots = GetSlots();
+    for (size_t i = 0; i < max_entries_; ++i) {
+      if (slots[i].valid_) {
+        HSHM_DESTROY_AR(slots[i].key_)
+        HSHM_DESTROY_AR(slots[i].val_)
+      }
+    }
+    GetAllocator()->Free(table_ptr_);
+  }
+
+  /**====================================
+   * Cache Methods
+   * ===================================*/
+
+  /**
+   * Copy the value of \a key into \a val and mark the entry as recently
+   * used. Only takes the cache's lock for reading.
+   *
+   * @return true if the key was cached
+   * */
+  bool get(const Key &key, T &val) {
+    if (IsNull()) {
+      return false;
+    }
+    ScopedRwReadLock lock(lock_, 0);
+    uint32_t idx = FindSlot(key, Hash{}(key));
+    if (idx == LRU_CACHE_NULL) {
+      return false;
+    }
+    SLOT_T &slot = GetSlots()[idx];
+    // Avoid dirtying the slot's cache line when the bit is already set
+    if (!slot.ref_.load(std::memory_order_relaxed)) {
+      slot.ref_.store(1, std::memory_order_relaxed);
+    }
+    val = slot.GetVal();
+    return true;
+  }
+
+  /** Whether \a key is cached. Does not mark the entry as used. */
+  bool contains(const Key &key) {
+    if (IsNull()) {
+      return false;
+    }
+    ScopedRwReadLock lock(lock_, 0);
+    return FindSlot(key, Hash{}(key)) != LRU_CACHE_NULL;
+  }
+
+  /**
+   * Cache a (key, value) pair, replacing the value if key is cached.
+   * Evicts entries until the new pair fits.
+   *
+   * @param nbytes the size charged against the byte capacity
+   * @param evict called with the key and value of each evicted entry
+   * before it is destroyed. Runs while the cache is locked, so it must
+   * not call back into the cache.
+   * @return false if the cache has no table or the pair alone exceeds
+   * the byte capacity
+   * */
+  template<typename EvictCb>
+  bool put(const Key &key, const T &val, size_t nbytes, EvictCb &&evict) {
+    if (IsNull() || (max_bytes_ && nbytes > max_bytes_)) {
+      return false;
+    }
+    ScopedRwWriteLock lock(lock_, 0);
+    size_t hash = Hash{}(key);
+    uint32_t idx = FindSlot(key, hash);
+
+    // Replace the value of a cached key
+    if (idx != LRU_CACHE_NULL) {
+      SLOT_T &slot = GetSlots()[idx];
+      bytes_ -= slot.nbytes_;
+      slot.nbytes_ = 0;
+      while (max_bytes_ && bytes_ + nbytes > max_bytes_) {
+        Evict(evict, idx);
+      }
+      HSHM_DESTROY_AR(slot.val_)
+      HSHM_MAKE_AR(slot.val_, GetAllocator(), val)
+      slot.nbytes_ = nbytes;
+      slot.ref_.store(1, std::memory_order_relaxed);
+      bytes_ += nbytes;
+      return true;
+    }
+
+    // Insert into a free slot
+    while (length_ == max_entries_ ||
+           (max_bytes_ && bytes_ + nbytes > max_bytes_)) {
+      Evict(evict, LRU_CACHE_NULL);
+    }
+    SLOT_T *slots = GetSlots();
+    idx = free_head_;
+    SLOT_T &slot = slots[idx];
+    free_head_ = slot.next_;
+    HSHM_MAKE_AR(slot.key_, GetAllocator(), key)
+    HSHM_MAKE_AR(slot.val_, GetAllocator(), val)
+    slot.nbytes_ = nbytes;
+    slot.ref_.store(0, std::memory_order_relaxed);
+    slot.valid_ = true;
+    uint32_t &head = GetBuckets()[hash % max_entries_];
+    slot.next_ = head;
+    head = idx;
+    ++length_;
+    bytes_ += nbytes;
+    return true;
+  }
+
+  /** Cache a (key, value) pair without an eviction callback */
+  bool put(const Key &key, const T &val, size_t nbytes = 0) {
+    return put(key, val, nbytes, [](Key&, T&) {});
+  }
+
+  /**
+   * Remove \a key from the cache. The eviction callback is not called.
+   * @return true if the key was cached
+   * */
+  bool erase(const Key &key) {
+    if (IsNull()) {
+      return false;
+    }
+    ScopedRwWriteLock lock(lock_, 0);
+    uint32_t idx = FindSlot(key, Hash{}(key));
+    if (idx == LRU_CACHE_NULL) {
+      return false;
+    }
+    RemoveSlot(idx);
+    return true;
+  }
+
+  /** Remove every entry from the cache */
+  void clear() {
+    if (IsNull()) {
+      return;
+    }
+    ScopedRwWriteLock lock(lock_, 0);
+    for (size_t i = 0; i < max_entries_; ++i) {
+      if (GetSlots()[i].valid_) {
+        RemoveSlot(i);
+      }
+    }
+    hand_ = 0;
+  }
+
+  /** The number of cached entries */
+  HSHM_ALWAYS_INLINE size_t size() const {
+    return length_;
+  }
+
+  /** The sum of the sizes of the cached entries */
+  HSHM_ALWAYS_INLINE size_t size_bytes() const {
+    return bytes_;
+  }
+
+  /** The maximum number of entries */
+  HSHM_ALWAYS_INLINE size_t capacity() const {
+    return max_entries_;
+  }
+
+  /** The maximum sum of entry sizes, or 0 for no limit */
+  HSHM_ALWAYS_INLINE size_t capacity_bytes() const {
+    return max_bytes_;
+  }
+
+  /**====================================
+   * Iterators
+   * ===================================*/
+
+  /** Forward iterator begin. Must not race with writers. */
+  HSHM_ALWAYS_INLINE iterator_t begin() const {
+    return iterator_t(GetSlots(), 0, max_entries_);
+  }
+
+  /** Forward iterator end */
+  HSHM_ALWAYS_INLINE iterator_t end() const {
+    return iterator_t(GetSlots(), max_entries_, max_entries_);
+  }
+
+ private:
+  /**====================================
+   * Helpers
+   * ===================================*/
+
+  /** Allocate the buckets and slots, and put every slot on the free list */
+  void AllocateTable(size_t max_entries, size_t max_bytes) {
+    if (max_entries == 0 || max_entries >= LRU_CACHE_NULL) {
+      throw LRU_CACHE_INVALID_CAPACITY.format(max_entries);
+    }
+    size_t buckets_size =
+      (max_entries * sizeof(uint32_t) + alignof(SLOT_T) - 1) /
+      alignof(SLOT_T) * alignof(SLOT_T);
+    GetAllocator()->template AllocatePtr<char, OffsetPointer>(
+      buckets_size + max_entries * sizeof(SLOT_T), table_ptr_);
+    max_entries_ = max_entries;
+    max_bytes_ = max_bytes;
+    uint32_t *buckets = GetBuckets();
+    SLOT_T *slots = GetSlots();
+    for (size_t i = 0; i < max_entries; ++i) {
+      buckets[i] = LRU_CACHE_NULL;
+      slots[i].ref_.store(0, std::memory_order_relaxed);
+      slots[i].valid_ = false;
+      slots[i].next_ = i + 1 < max_entries ? i + 1 : LRU_CACHE_NULL;
+    }
+    free_head_ = 0;
+  }
+
+  /** Find the slot holding \a key */
+  HSHM_ALWAYS_INLINE uint32_t FindSlot(const Key &key, size_t hash) const {
+    SLOT_T *slots = GetSlots();
+    uint32_t idx = GetBuckets()[hash % max_entries_];
+    while (idx != LRU_CACHE_NULL && !(slots[idx].GetKey() == key)) {
+      idx = slots[idx].next_;
+    }
+    return idx;
+  }
+
+  /**
+   * Advance the CLOCK hand until it finds an entry whose reference bit is
+   * clear, and evict it. Entries with the bit set get a second chance.
+   *
+   * @param keep a slot which must not be evicted
+   * */
+  template<typename EvictCb>
+  void Evict(EvictCb &evict, uint32_t keep) {
+    SLOT_T *slots = GetSlots();
+    while (true) {
+      uint32_t idx = hand_;
+      hand_ = (hand_ + 1) % max_entries_;
+      SLOT_T &slot = slots[idx];
+      if (!slot.valid_ || idx == keep) {
+        continue;
+      }
+      if (slot.ref_.load(std::memory_order_relaxed)) {
+        slot.ref_.store(0, std::memory_order_relaxed);
+        continue;
+      }
+      evict(slot.GetKey(), slot.GetVal());
+      RemoveSlot(idx);
+      return;
+    }
+  }
+
+  /** Unlink a slot from its bucket, destroy it, and free it */
+  void RemoveSlot(uint32_t idx) {
+    SLOT_T *slots = GetSlots();
+    SLOT_T &slot = slots[idx];
+    uint32_t *link = &GetBuckets()[Hash{}(slot.GetKey()) % max_entries_];
+    while (*link != idx) {
+      link = &slots[*link].next_;
+    }
+    *link = slot.next_;
+    HSHM_DESTROY_AR(slot.key_)
+    HSHM_DESTROY_AR(slot.val_)
+    slot.valid_ = false;
+    slot.next_ = free_head_;
+    free_head_ = idx;
+    --length_;
+    bytes_ -= slot.nbytes_;
+  }
+
+  /** Get the bucket heads */
+  HSHM_ALWAYS_INLINE uint32_t* GetBuckets() const {
+    return GetAllocator()->template Convert<uint32_t>(table_ptr_);
+  }
+
+  /** Get the slots */
+  HSHM_ALWAYS_INLINE SLOT_T* GetSlots() const {
+    size_t buckets_size =
+      (max_entries_ * sizeof(uint32_t) + alignof(SLOT_T) - 1) /
+      alignof(SLOT_T) * alignof(SLOT_T);
+    return reinterpret_cast<SLOT_T*>(
+      reinterpret_cast<char*>(GetBuckets()) + buckets_size);
+  }
+};
+
+}  // namespace hshm::ipc
+
+#undef TYPED_HEADER
+#undef TYPED_CLASS
+#undef CLASS_NAME
+
+#endif  // HERMES_DATA_STRUCTURES_LRU_CACHE_H_
@@ -0,0 +1,283 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HERMES_SHM_INCLUDE_HERMES_SHM_DATA_STRUCTURES_IPC_MPMC_QUEUE_H_
+#define HERMES_SHM_INCLUDE_HERMES_SHM_DATA_STRUCTURES_IPC_MPMC_QUEUE_H_
+
+#include "hermes_shm/data_structures/ipc/internal/shm_internal.h"
+#include "hermes_shm/types/qtok.h"
+
+namespace hshm::ipc {
+
+/** Forward declaration of mpmc_queue */
+template<typename T>
+class mpmc_queue;
+
+/**
+ * A slot of an mpmc_queue. seq_ tells producers and consumers whose turn
+ * it is: a slot at position pos is free for the producer of pos when
+ * seq_ == pos, and holds data for the consumer of pos when seq_ == pos + 1.
+ * */
+template<typename T>
+struct mpmc_queue_slot {
+  std::atomic<_qtok_t> seq_;
+  ShmArchive<T> data_;
+};
+
+/**
+ * MACROS used to simplify the mpmc_queue namespace
+ * Used as inputs to the SHM_CONTAINER_TEMPLATE
+ * */
+#define CLASS_NAME mpmc_queue
+#define TYPED_CLASS mpmc_queue<T>
+#define TYPED_HEADER ShmHeader<mpmc_queue<T>>
+
+/**
+ * A bounded lock-free queue for multiple producers and multiple consumers.
+ * Each slot carries a sequence number, so producers and consumers only
+ * contend on a CAS of tail_ or head_ and never wait on each other unless
+ * the queue is full or empty. The depth is rounded up to a power of two.
+ * tail_ and head_ are padded onto separate cache lines.
+ * */
+template<typename T>
+class mpmc_queue : public ShmContainer {
+ public:
+  SHM_CONTAINER_TEMPLATE((CLASS_NAME), (TYPED_CLASS))
+  OffsetPointer slots_ptr_;
+  size_t mask_;
+  char pad0_[HSHM_CACHE_LINE_SIZE];
+  std::atomic<_qtok_t> tail_;
+  char pad1_[HSHM_CACHE_LINE_SIZE];
+  std::atomic<_qtok_t> head_;
+  char pad2_[HSHM_CACHE_LINE_SIZE];
+
+ public:
+  /**====================================
+   * Default Constructor
+   * ===================================*/
+
+  /** SHM constructor. Default. */
+  explicit mpmc_queue(Allocator *alloc,
+                      size_t depth = 1024) {
+    shm_init_container(alloc);
+    SetNull();
+    shm_init_slots(depth);
+  }
+
+  /**====================================
+   * Copy Constructors
+   * ===================================*/
+
+  /** SHM copy constructor */
+  explicit mpmc_queue(Allocator *alloc,
+                      const mpmc_queue &other) {
+    shm_init_container(alloc);
+    SetNull();
+    shm_strong_copy_construct_and_op(other);
+  }
+
+  /** SHM copy assignment operator */
+  mpmc_queue& operator=(const mpmc_queue &other) {
+    if (this != &other) {
+      shm_destroy();
+      shm_strong_copy_construct_and_op(other);
+    }
+    return *this;
+  }
+
+  /** SHM copy constructor + operator main. Other must be quiescent. */
+  void shm_strong_copy_construct_and_op(const mpmc_queue &other) {
+    shm_init_slots(other.GetDepth());
+    _qtok_t head = other.head_.load();
+    _qtok_t tail = other.tail_.load();
+    mpmc_queue_slot<T> *slots = other.GetSlots();
+    for (_qtok_t pos = head; pos < tail; ++pos) {
+      emplace(slots[pos & other.mask_].data_.get_ref());
+    }
+  }
+
+  /**====================================
+   * Move Constructors
+   * ===================================*/
+
+  /** SHM move constructor. */
+  mpmc_queue(Allocator *alloc,
+             mpmc_queue &&other) noexcept {
+    shm_init_container(alloc);
+    if (GetAllocator() == other.GetAllocator()) {
+      strong_copy(other);
+      other.SetNull();
+    } else {
+      SetNull();
+      shm_strong_copy_construct_and_op(other);
+      other.shm_destroy();
+    }
+  }
+
+  /** SHM move assignment operator. */
+  mpmc_queue& operator=(mpmc_queue &&other) noexcept {
+    if (this != &other) {
+      shm_destroy();
+      if (GetAllocator() == other.GetAllocator()) {
+        strong_copy(other);
+        other.SetNull();
+      } else {
+        shm_strong_copy_construct_and_op(other);
+        other.shm_destroy();
+      }
+    }
+    return *this;
+  }
+
+  /** Take the slots of another queue */
+  void strong_copy(const mpmc_queue &other) {
+    slots_ptr_ = other.slots_ptr_;
+    mask_ = other.mask_;
+    head_ = other.head_.load();
+    tail_ = other.tail_.load();
+  }
+
+  /**====================================
+   * Destructor
+   * ===================================*/
+
+  /** SHM destructor.  */
+  void shm_destroy_main() {
+    mpmc_queue_slot<T> *slots = GetSlots();
+    _qtok_t tail = tail_.load();
+    for (_qtok_t pos = head_.load(); pos < tail; ++pos) {
+      HSHM_DESTROY_AR(slots[pos & mask_].data_)
+    }
+    GetAllocator()->Free(slots_ptr_);
+  }
+
+  /** Check if the queue is null */
+  bool IsNull() const {
+    return slots_ptr_.IsNull();
+  }
+
+  /** Sets this queue as null */
+  void SetNull() {
+    slots_ptr_.SetNull();
+    mask_ = 0;
+    head_ = 0;
+    tail_ = 0;
+  }
+
+  /**====================================
+   * mpmc Queue Methods
+   * ===================================*/
+
+  /** Construct an element at the tail of the queue */
+  template<typename ...Args>
+  qtok_t emplace(Args&&... args) {
+    mpmc_queue_slot<T> *slots = GetSlots();
+    mpmc_queue_slot<T> *slot;
+    _qtok_t pos = tail_.load(std::memory_order_relaxed);
+    while (true) {
+      slot = &slots[pos & mask_];
+      _qtok_t seq = slot->seq_.load(std::memory_order_acquire);
+      auto dif = static_cast<int64_t>(seq - pos);
+      if (dif == 0) {
+        if (tail_.compare_exchange_weak(pos, pos + 1,
+                                        std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (dif < 0) {
+        // The consumer of the prior lap has not freed this slot
+        return qtok_t::GetNull();
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+    HSHM_MAKE_AR(slot->data_, GetAllocator(), std::forward<Args>(args)...)
+    slot->seq_.store(pos + 1, std::memory_order_release);
+    return qtok_t(pos);
+  }
+
+  /** Pop the object at the head of the queue */
+  qtok_t pop(T &val) {
+    mpmc_queue_slot<T> *slots = GetSlots();
+    mpmc_queue_slot<T> *slot;
+    _qtok_t pos = head_.load(std::memory_order_relaxed);
+    while (true) {
+      slot = &slots[pos & mask_];
+      _qtok_t seq = slot->seq_.load(std::memory_order_acquire);
+      auto dif = static_cast<int64_t>(seq - (pos + 1));
+      if (dif == 0) {
+        if (head_.compare_exchange_weak(pos, pos + 1,
+                                        std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (dif < 0) {
+        // The producer of this position has not finished
+        return qtok_t::GetNull();
+      } else {
+        pos = head_.load(std::memory_order_relaxed);
+      }
+    }
+    val = std::move(slot->data_.get_ref());
+    HSHM_DESTROY_AR(slot->data_)
+    slot->seq_.store(pos + mask_ + 1, std::memory_order_release);
+    return qtok_t(pos);
+  }
+
+  /** Get size at this moment */
+  size_t GetSize() const {
+    size_t tail = tail_.load();
+    size_t head = head_.load();
+    if (tail < head) {
+      return 0;
+    }
+    return tail - head;
+  }
+
+  /** Get the number of slots in the queue */
+  size_t GetDepth() const {
+    return mask_ + 1;
+  }
+
+ private:
+  /** Allocate the slots for a depth rounded up to a power of two */
+  void shm_init_slots(size_t depth) {
+    size_t slot_count = 1;
+    while (slot_count < depth) {
+      slot_count <<= 1;
+    }
+    mask_ = slot_count - 1;
+    head_ = 0;
+    tail_ = 0;
+    mpmc_queue_slot<T> *slots = GetAllocator()->template
+      AllocateObjs<mpmc_queue_slot<T>>(slot_count, slots_ptr_);
+    if (slots == nullptr) {
+      throw OUT_OF_MEMORY.format(slot_count * sizeof(mpmc_queue_slot<T>),
+                                 "unknown");
+    }
+    for (size_t i = 0; i < slot_count; ++i) {
+      new (&slots[i].seq_) std::atomic<_qtok_t>(i);
+    }
+  }
+
+  /** Get the slot array */
+  HSHM_ALWAYS_INLINE mpmc_queue_slot<T>* GetSlots() const {
+    return GetAllocator()->template
+      Convert<mpmc_queue_slot<T>>(slots_ptr_);
+  }
+};
+
+}  // namespace hshm::ipc
+
+#undef CLASS_NAME
+#undef TYPED_CLASS
+#undef TYPED_HEADER
+
+#endif  // HERMES_SHM_INCLUDE_HERMES_SHM_DATA_STRUCTURES_IPC_MPMC_QUEUE_H_
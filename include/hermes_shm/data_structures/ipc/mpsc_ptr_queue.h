@@ -35,17 +35,20 @@ class mpsc_ptr_queue;
 
 /**
  * A queue optimized for multiple producers (emplace) with a single
- * consumer (pop).
+ * consumer (pop). tail_ and head_ are padded onto separate cache lines.
  * */
 template<typename T>
 class mpsc_ptr_queue : public ShmContainer {
  public:
   SHM_CONTAINER_TEMPLATE((CLASS_NAME), (TYPED_CLASS))
   ShmArchive<vector<T>> queue_;
-  std::atomic<_qtok_t> tail_;
-  std::atomic<_qtok_t> head_;
   RwLock lock_;
   bitfield32_t flags_;
+  char pad0_[HSHM_CACHE_LINE_SIZE];
+  std::atomic<_qtok_t> tail_;
+  char pad1_[HSHM_CACHE_LINE_SIZE];
+  std::atomic<_qtok_t> head_;
+  char pad2_[HSHM_CACHE_LINE_SIZE];
 
  public:
   /**====================================
@@ -171,18 +174,32 @@ class mpsc_ptr_queue : public ShmContainer {
       }
     }
 
-    // Emplace into queue at our slot
+    // Emplace into queue at our slot, marked so pop knows it's ready
     uint32_t idx = tail % queue.size();
-    if constexpr(std::is_arithmetic<T>::value) {
-      queue[idx] = MARK_FIRST_BIT(T, val);
-    } else if constexpr(IS_SHM_OFFSET_POINTER(T)) {
-      queue[idx] = T(MARK_FIRST_BIT(size_t, val.off_.load()));
-    } else if constexpr(IS_SHM_POINTER(T)) {
-      queue[idx] = T(val.allocator_id_,
-                     MARK_FIRST_BIT(size_t, val.off_.load()));
-    }
+    queue[idx] = Mark(val);
+    return qtok_t(tail);
+  }
 
-    // Let pop know that the data is fully prepared
+  /**
+   * Copy \a count pointers from \a vals to the tail of the queue,
+   * reserving their slots with a single atomic. Blocks while the queue
+   * is full, like emplace.
+   *
+   * @return the token of the first pointer
+   * */
+  qtok_t emplace_n(const T *vals, size_t count) {
+    _qtok_t tail = tail_.fetch_add(count);
+    _qtok_t head = head_.load();
+    vector<T> &queue = (*queue_);
+    size_t depth = queue.size();
+    for (size_t i = 0; i < count; ++i) {
+      _qtok_t pos = tail + i;
+      while (pos - head + 1 > depth) {
+        HERMES_THREAD_MODEL->Yield();
+        head = head_.load();
+      }
+      queue[pos % depth] = Mark(vals[i]);
+    }
     return qtok_t(tail);
   }
 
@@ -200,33 +217,84 @@ class mpsc_ptr_queue : public ShmContainer {
     _qtok_t idx = head % (*queue_).size();
     T &entry = (*queue_)[idx];
 
-    // Check if bit is marked
-    bool is_marked;
-    if constexpr(std::is_arithmetic<T>::value) {
-      is_marked = IS_FIRST_BIT_MARKED(T, entry);
-    } else {
-      is_marked = IS_FIRST_BIT_MARKED(size_t, entry.off_.load());
-    }
-
     // Complete dequeue if marked
-    if (is_marked) {
-      if constexpr(std::is_arithmetic<T>::value) {
-        val = UNMARK_FIRST_BIT(T, entry);
-        entry = 0;
-      } else if constexpr(IS_SHM_OFFSET_POINTER(T)) {
-        val = T(UNMARK_FIRST_BIT(size_t, entry.off_.load()));
-        entry.off_ = 0;
-      } else if constexpr(IS_SHM_POINTER(T)) {
-        val = T(entry.allocator_id_,
-                UNMARK_FIRST_BIT(size_t, entry.off_.load()));
-        entry.off_ = 0;
-      }
+    if (IsMarked(entry)) {
+      val = Unmark(entry);
       head_.fetch_add(1);
       return qtok_t(head);
     } else {
       return qtok_t::GetNull();
     }
   }
+
+  /**
+   * Pop up to \a count pointers into \a vals. The marked pointers at the
+   * head are consumed together, and head_ advances once.
+   *
+   * @return the number of pointers popped
+   * */
+  size_t pop_n(T *vals, size_t count) {
+    _qtok_t head = head_.load();
+    _qtok_t tail = tail_.load();
+    if (head >= tail) {
+      return 0;
+    }
+    vector<T> &queue = (*queue_);
+    size_t depth = queue.size();
+    count = std::min(count, std::min<size_t>(tail - head, depth));
+    size_t i = 0;
+    for (; i < count; ++i) {
+      T &entry = queue[(head + i) % depth];
+      if (!IsMarked(entry)) {
+        break;
+      }
+      vals[i] = Unmark(entry);
+    }
+    if (i > 0) {
+      head_.fetch_add(i);
+    }
+    return i;
+  }
+
+ private:
+  /** Mark the first bit of \a val, so pop knows the slot is ready */
+  HSHM_ALWAYS_INLINE static T Mark(const T &val) {
+    if constexpr(std::is_arithmetic<T>::value) {
+      return MARK_FIRST_BIT(T, val);
+    } else if constexpr(IS_SHM_OFFSET_POINTER(T)) {
+      return T(MARK_FIRST_BIT(size_t, val.off_.load()));
+    } else if constexpr(IS_SHM_POINTER(T)) {
+      return T(val.allocator_id_,
+               MARK_FIRST_BIT(size_t, val.off_.load()));
+    }
+  }
+
+  /** Check if bit is marked */
+  HSHM_ALWAYS_INLINE static bool IsMarked(T &entry) {
+    if constexpr(std::is_arithmetic<T>::value) {
+      return IS_FIRST_BIT_MARKED(T, entry);
+    } else {
+      return IS_FIRST_BIT_MARKED(size_t, entry.off_.load());
+    }
+  }
+
+  /** Take the value out of a marked slot and clear the slot */
+  HSHM_ALWAYS_INLINE static T Unmark(T &entry) {
+    if constexpr(std::is_arithmetic<T>::value) {
+      T val = UNMARK_FIRST_BIT(T, entry);
+      entry = 0;
+      return val;
+    } else if constexpr(IS_SHM_OFFSET_POINTER(T)) {
+      T val(UNMARK_FIRST_BIT(size_t, entry.off_.load()));
+      entry.off_ = 0;
+      return val;
+    } else if constexpr(IS_SHM_POINTER(T)) {
+      T val(entry.allocator_id_,
+            UNMARK_FIRST_BIT(size_t, entry.off_.load()));
+      entry.off_ = 0;
+      return val;
+    }
+  }
 };
 
 }  // namespace hshm::ipc
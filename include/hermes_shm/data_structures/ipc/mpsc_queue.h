@@ -17,6 +17,7 @@
 #include "vector.h"
 #include "pair.h"
 #include "hermes_shm/types/qtok.h"
+#include "hermes_shm/thread/lock/futex.h"
 
 namespace hshm::ipc {
 
@@ -35,27 +36,52 @@ class mpsc_queue;
 /**
  * A queue optimized for multiple producers (emplace) with a single
  * consumer (pop).
+ *
+ * The producer-side words (tail_, not_empty_) and the consumer-side
+ * words (head_, not_full_) are padded onto separate cache lines.
+ * Optionally, each slot can be padded to a cache line of its own, so a
+ * producer filling one slot does not invalidate the slot being popped.
  * */
 template<typename T>
 class mpsc_queue : public ShmContainer {
  public:
   SHM_CONTAINER_TEMPLATE((CLASS_NAME), (TYPED_CLASS))
   ShmArchive<vector<pair<bitfield32_t, T>>> queue_;
+  size_t depth_;   /**< The number of slots */
+  size_t stride_;  /**< The number of vector entries per slot */
+  bitfield32_t flags_;
+  char pad0_[HSHM_CACHE_LINE_SIZE];
   std::atomic<_qtok_t> tail_;
+  hshm::Futex not_empty_;
+  char pad1_[HSHM_CACHE_LINE_SIZE];
   std::atomic<_qtok_t> head_;
-  bitfield32_t flags_;
+  hshm::Futex not_full_;
+  char pad2_[HSHM_CACHE_LINE_SIZE];
 
  public:
   /**====================================
    * Default Constructor
    * ===================================*/
 
-  /** SHM constructor. Default. */
+  /**
+   * SHM constructor. Default.
+   *
+   * @param pad_slots whether to give each slot its own cache line
+   * */
   explicit mpsc_queue(Allocator *alloc,
-                      size_t depth = 1024) {
+                      size_t depth = 1024,
+                      bool pad_slots = false) {
     shm_init_container(alloc);
-    HSHM_MAKE_AR(queue_, GetAllocator(), depth);
+    depth_ = depth;
+    stride_ = 1;
+    if (pad_slots) {
+      size_t slot_size = sizeof(pair<bitfield32_t, T>);
+      stride_ = (HSHM_CACHE_LINE_SIZE + slot_size - 1) / slot_size;
+    }
+    HSHM_MAKE_AR(queue_, GetAllocator(), depth_ * stride_);
     flags_.Clear();
+    not_empty_.Init();
+    not_full_.Init();
     SetNull();
   }
 
@@ -67,6 +93,8 @@ class mpsc_queue : public ShmContainer {
   explicit mpsc_queue(Allocator *alloc,
                       const mpsc_queue &other) {
     shm_init_container(alloc);
+    not_empty_.Init();
+    not_full_.Init();
     SetNull();
     shm_strong_copy_construct_and_op(other);
   }
@@ -84,6 +112,8 @@ class mpsc_queue : public ShmContainer {
   void shm_strong_copy_construct_and_op(const mpsc_queue &other) {
     head_ = other.head_.load();
     tail_ = other.tail_.load();
+    depth_ = other.depth_;
+    stride_ = other.stride_;
     (*queue_) = (*other.queue_);
   }
 
@@ -95,9 +125,13 @@ class mpsc_queue : public ShmContainer {
   mpsc_queue(Allocator *alloc,
              mpsc_queue &&other) noexcept {
     shm_init_container(alloc);
+    not_empty_.Init();
+    not_full_.Init();
     if (GetAllocator() == other.GetAllocator()) {
       head_ = other.head_.load();
       tail_ = other.tail_.load();
+      depth_ = other.depth_;
+      stride_ = other.stride_;
       (*queue_) = std::move(*other.queue_);
       other.SetNull();
     } else {
@@ -113,6 +147,8 @@ class mpsc_queue : public ShmContainer {
       if (GetAllocator() == other.GetAllocator()) {
         head_ = other.head_.load();
         tail_ = other.tail_.load();
+        depth_ = other.depth_;
+        stride_ = other.stride_;
         (*queue_) = std::move(*other.queue_);
         other.SetNull();
       } else {
@@ -155,23 +191,89 @@ class mpsc_queue : public ShmContainer {
     _qtok_t head = head_.load();
     _qtok_t tail = tail_.fetch_add(1);
     size_t size = tail - head + 1;
-    vector<pair<bitfield32_t, T>> &queue = (*queue_);
 
-    // Check if there's space in the queue.
-    if (size > queue.size()) {
-      while (true) {
-        head = head_.load();
-        size = tail - head + 1;
-        if (size <= (*queue_).size()) {
-          break;
-        }
-        HERMES_THREAD_MODEL->Yield();
+    // Check if there's space in the queue. Sleep until the consumer
+    // frees our slot if not.
+    if (size > depth_) {
+      not_full_.WaitFor([this, tail]() {
+        return tail - head_.load() + 1 <= depth_;
+      }, HSHM_WAIT_FOREVER);
+    }
+    return emplace_at(tail, std::forward<Args>(args)...);
+  }
+
+  /**
+   * Construct an element at the tail of the queue, sleeping while the
+   * queue is full for at most \a timeout_us microseconds.
+   *
+   * @return the null qtok_t if the queue stayed full
+   * */
+  template<typename ...Args>
+  qtok_t emplace_wait(size_t timeout_us, Args&&... args) {
+    // Only reserve a slot once there is space for it, so that
+    // timing out leaves no hole in the queue
+    _qtok_t tail;
+    bool reserved = not_full_.WaitFor([this, &tail]() {
+      tail = tail_.load();
+      if (tail - head_.load() + 1 > depth_) {
+        return false;
       }
+      return tail_.compare_exchange_weak(tail, tail + 1);
+    }, timeout_us);
+    if (!reserved) {
+      return qtok_t::GetNull();
     }
+    return emplace_at(tail, std::forward<Args>(args)...);
+  }
 
+  /**
+   * Copy \a count objects from \a vals to the tail of the queue.
+   * The slots are reserved with a single atomic and the consumer is
+   * woken once for the whole batch. Blocks while the queue is full,
+   * like emplace.
+   *
+   * @return the token of the first object
+   * */
+  qtok_t emplace_n(const T *vals, size_t count) {
+    _qtok_t tail = tail_.fetch_add(count);
+    _qtok_t head = head_.load();
+    size_t depth = depth_;
+    for (size_t i = 0; i < count; ++i) {
+      _qtok_t pos = tail + i;
+      if (pos - head + 1 > depth) {
+        // Publish what we have so far, since the consumer may be asleep
+        not_empty_.Wake();
+        not_full_.WaitFor([this, pos, depth, &head]() {
+          head = head_.load();
+          return pos - head + 1 <= depth;
+        }, HSHM_WAIT_FOREVER);
+      }
+      construct_at(pos, vals[i]);
+    }
+    not_empty_.Wake();
+    return qtok_t(tail);
+  }
+
+ private:
+  /** Construct an element in the slot reserved for \a tail */
+  template<typename ...Args>
+  HSHM_ALWAYS_INLINE qtok_t emplace_at(_qtok_t tail, Args&&... args) {
+    construct_at(tail, std::forward<Args>(args)...);
+    not_empty_.Wake();
+    return qtok_t(tail);
+  }
+
+  /** The vector index of the slot for position \a pos */
+  HSHM_ALWAYS_INLINE size_t GetSlotIdx(_qtok_t pos) const {
+    return (pos % depth_) * stride_;
+  }
+
+  /** Construct and publish the element at position \a tail */
+  template<typename ...Args>
+  HSHM_ALWAYS_INLINE void construct_at(_qtok_t tail, Args&&... args) {
     // Emplace into queue at our slot
-    uint32_t idx = tail % queue.size();
-    auto iter = queue.begin() + idx;
+    vector<pair<bitfield32_t, T>> &queue = (*queue_);
+    auto iter = queue.begin() + GetSlotIdx(tail);
     queue.replace(iter,
                       hshm::PiecewiseConstruct(),
                       make_argpack(),
@@ -180,7 +282,6 @@ class mpsc_queue : public ShmContainer {
     // Let pop know that the data is fully prepared
     pair<bitfield32_t, T> &entry = (*iter);
     entry.GetFirst().SetBits(1);
-    return qtok_t(tail);
   }
 
  public:
@@ -194,18 +295,63 @@ class mpsc_queue : public ShmContainer {
     }
 
     // Pop the element, but only if it's marked valid
-    _qtok_t idx = head % (*queue_).size();
-    hipc::pair<bitfield32_t, T> &entry = (*queue_)[idx];
+    hipc::pair<bitfield32_t, T> &entry = (*queue_)[GetSlotIdx(head)];
     if (entry.GetFirst().Any(1)) {
       val = std::move(entry.GetSecond());
       entry.GetFirst().Clear();
       head_.fetch_add(1);
+      not_full_.Wake();
       return qtok_t(head);
     } else {
       return qtok_t::GetNull();
     }
   }
 
+  /**
+   * Pop up to \a count objects into \a vals. The published objects at
+   * the head are consumed together, and head_ advances once.
+   *
+   * @return the number of objects popped
+   * */
+  size_t pop_n(T *vals, size_t count) {
+    _qtok_t head = head_.load();
+    _qtok_t tail = tail_.load();
+    if (head >= tail) {
+      return 0;
+    }
+    vector<pair<bitfield32_t, T>> &queue = (*queue_);
+    count = std::min(count, std::min<size_t>(tail - head, depth_));
+    size_t i = 0;
+    for (; i < count; ++i) {
+      hipc::pair<bitfield32_t, T> &entry = queue[GetSlotIdx(head + i)];
+      if (!entry.GetFirst().Any(1)) {
+        break;
+      }
+      vals[i] = std::move(entry.GetSecond());
+      entry.GetFirst().Clear();
+    }
+    if (i > 0) {
+      head_.fetch_add(i);
+      not_full_.Wake();
+    }
+    return i;
+  }
+
+  /**
+   * Pop the head object, sleeping while the queue is empty for at most
+   * \a timeout_us microseconds.
+   *
+   * @return the null qtok_t if the queue stayed empty
+   * */
+  qtok_t pop_wait(T &val, size_t timeout_us) {
+    qtok_t qtok = qtok_t::GetNull();
+    not_empty_.WaitFor([this, &val, &qtok]() {
+      qtok = pop(val);
+      return !qtok.IsNull();
+    }, timeout_us);
+    return qtok;
+  }
+
   /** Consumer pops the head object */
   qtok_t pop() {
     // Don't pop if there's no entries
@@ -216,11 +362,11 @@ class mpsc_queue : public ShmContainer {
     }
 
     // Pop the element, but only if it's marked valid
-    _qtok_t idx = head % (*queue_).size();
-    hipc::pair<bitfield32_t, T> &entry = (*queue_)[idx];
+    hipc::pair<bitfield32_t, T> &entry = (*queue_)[GetSlotIdx(head)];
     if (entry.GetFirst().Any(1)) {
       entry.GetFirst().Clear();
       head_.fetch_add(1);
+      not_full_.Wake();
       return qtok_t(head);
     } else {
       return qtok_t::GetNull();
@@ -237,8 +383,7 @@ class mpsc_queue : public ShmContainer {
     }
 
     // Pop the element, but only if it's marked valid
-    _qtok_t idx = (head) % (*queue_).size();
-    hipc::pair<bitfield32_t, T> &entry = (*queue_)[idx];
+    hipc::pair<bitfield32_t, T> &entry = (*queue_)[GetSlotIdx(head)];
     if (entry.GetFirst().Any(1)) {
       val = &entry.GetSecond();
       return qtok_t(head);
@@ -257,8 +402,7 @@ class mpsc_queue : public ShmContainer {
     }
 
     // Pop the element, but only if it's marked valid
-    _qtok_t idx = (head) % (*queue_).size();
-    hipc::pair<bitfield32_t, T> &entry = (*queue_)[idx];
+    hipc::pair<bitfield32_t, T> &entry = (*queue_)[GetSlotIdx(head)];
     if (entry.GetFirst().Any(1)) {
       val = &entry;
       return qtok_t(head);
@@ -267,6 +411,11 @@ class mpsc_queue : public ShmContainer {
     }
   }
 
+  /** Get the number of slots in the queue */
+  size_t GetDepth() const {
+    return depth_;
+  }
+
   /** Get size at this moment */
   size_t GetSize() {
     size_t tail = tail_.load();
@@ -206,6 +206,12 @@ class pair : public ShmContainer {
 #undef TYPED_CLASS
 #undef TYPED_HEADER
 
+/** A pair is trivially relocatable if both of its members are */
+template<typename FirstT, typename SecondT>
+struct is_trivially_relocatable<pair<FirstT, SecondT>>
+  : std::integral_constant<bool, is_trivially_relocatable_v<FirstT> &&
+                                 is_trivially_relocatable_v<SecondT>> {};
+
 }  // namespace hshm::ipc
 
 #endif  // HERMES_INCLUDE_HERMES_DATA_STRUCTURES_IPC_PAIR_H_
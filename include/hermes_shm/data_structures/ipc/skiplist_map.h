@@ -0,0 +1,794 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+* Distributed under BSD 3-Clause license.                                   *
+* Copyright by The HDF Group.                                               *
+* Copyright by the Illinois Institute of Technology.                        *
+* All rights reserved.                                                      *
+*                                                                           *
+* This file is part of Hermes. The full Hermes copyright notice, including  *
+* terms governing use, modification, and redistribution, is contained in    *
+* the COPYING file, which can be found at the top directory. If you do not  *
+* have access to the file, you may request a copy from help@hdfgroup.org.   *
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HERMES_DATA_STRUCTURES_SKIPLIST_MAP_H_
+#define HERMES_DATA_STRUCTURES_SKIPLIST_MAP_H_
+
+#include <atomic>
+#include <type_traits>
+#include "hermes_shm/data_structures/ipc/internal/shm_internal.h"
+#include "hermes_shm/thread/lock.h"
+#include "hermes_shm/types/sharded_counter.h"
+
+namespace hshm::ipc {
+
+/** forward pointer for skiplist_map */
+template<typename Key, typename T>
+class skiplist_map;
+
+/**
+ * A skiplist_map node. The node is followed in memory by one
+ * AtomicOffsetPointer per level it is linked into.
+ *
+ * The top bit of a next pointer marks the node as erased on that level,
+ * so no node can be linked after it there. Offsets are not aligned, so
+ * the low bits are not free. A node is erased once its
+ * bottom level is marked. The version is a sequence lock over val_: it
+ * is odd while a thread modifies it. Keys and levels never change after
+ * insertion.
+ * */
+template<typename Key, typename T>
+struct skiplist_node {
+  std::atomic<uint64_t> version_;
+  uint32_t height_;  /**< The number of levels this node is linked into */
+  OffsetPointer retired_ptr_;  /**< The next erased node to reclaim */
+  Key key_;
+  T val_;
+
+  /** The bit which marks a next pointer */
+  static const size_t mark_bit_ = (size_t)1 << 63;
+  /** The offset stored in a marked null next pointer */
+  static const size_t marked_null_ = (size_t)-2;
+
+  /** Get the key */
+  HSHM_ALWAYS_INLINE Key& GetKey() { return key_; }
+  /** Get the key (const) */
+  HSHM_ALWAYS_INLINE const Key& GetKey() const { return key_; }
+  /** Get the value */
+  HSHM_ALWAYS_INLINE T& GetVal() { return val_; }
+  /** Get the value (const) */
+  HSHM_ALWAYS_INLINE const T& GetVal() const { return val_; }
+
+  /** The next pointer of each level */
+  HSHM_ALWAYS_INLINE AtomicOffsetPointer* GetNext() {
+    return reinterpret_cast<AtomicOffsetPointer*>(this + 1);
+  }
+
+  /** The next pointer of each level (const) */
+  HSHM_ALWAYS_INLINE const AtomicOffsetPointer* GetNext() const {
+    return reinterpret_cast<const AtomicOffsetPointer*>(this + 1);
+  }
+
+  /** Whether a raw next offset is marked */
+  HSHM_ALWAYS_INLINE static bool IsMarked(size_t off) {
+    return off != (size_t)-1 && (off & mark_bit_);
+  }
+
+  /** Mark a raw next offset */
+  HSHM_ALWAYS_INLINE static size_t Mark(size_t off) {
+    return off == (size_t)-1 ? marked_null_ : (off | mark_bit_);
+  }
+
+  /** Remove the mark of a raw next offset */
+  HSHM_ALWAYS_INLINE static size_t Unmark(size_t off) {
+    if (!IsMarked(off)) {
+      return off;
+    }
+    return off == marked_null_ ? (size_t)-1 : (off & ~mark_bit_);
+  }
+
+  /** Whether this node was erased */
+  HSHM_ALWAYS_INLINE bool IsErased() const {
+    return IsMarked(GetNext()[0].off_.load(std::memory_order_acquire));
+  }
+
+  /** The size of a node linked into \a height levels */
+  HSHM_ALWAYS_INLINE static size_t GetSize(uint32_t height) {
+    return sizeof(skiplist_node) + height * sizeof(AtomicOffsetPointer);
+  }
+
+  /** Begin modifying val_ */
+  HSHM_ALWAYS_INLINE void WriteLock() {
+    while (true) {
+      uint64_t version = version_.load(std::memory_order_relaxed);
+      if (!(version & 1) && version_.compare_exchange_weak(
+          version, version + 1, std::memory_order_acquire)) {
+        return;
+      }
+      HERMES_THREAD_MODEL->Yield();
+    }
+  }
+
+  /** Publish the modifications to val_ */
+  HSHM_ALWAYS_INLINE void WriteUnlock() {
+    version_.fetch_add(1, std::memory_order_release);
+  }
+
+  /**
+   * Copy the value of the node while it may be modified
+   * @return true if the node was not erased
+   * */
+  HSHM_ALWAYS_INLINE bool Read(T &val) const {
+    while (true) {
+      uint64_t version = version_.load(std::memory_order_acquire);
+      if (version & 1) {
+        HERMES_THREAD_MODEL->Yield();
+        continue;
+      }
+      val = val_;
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (version_.load(std::memory_order_relaxed) == version) {
+        return !IsErased();
+      }
+    }
+  }
+};
+
+/**
+ * The skiplist_map iterator. Visits the non-erased nodes in key order.
+ * Erased nodes are only freed by compact(), clear() and the destructor,
+ * so iterating while other threads insert and erase is safe, though
+ * values are read without validation.
+ * */
+template<typename Key, typename T>
+struct skiplist_map_iterator {
+  typedef skiplist_node<Key, T> NODE_T;
+  Allocator *alloc_;
+  NODE_T *node_;
+
+  /** Construct an iterator and advance to a non-erased node */
+  HSHM_ALWAYS_INLINE skiplist_map_iterator(Allocator *alloc, NODE_T *node)
+  : alloc_(alloc), node_(node) {
+    make_correct();
+  }
+
+  /** Get the pointed node */
+  HSHM_ALWAYS_INLINE NODE_T& operator*() const {
+    return *node_;
+  }
+
+  /** Get the pointed node */
+  HSHM_ALWAYS_INLINE NODE_T* operator->() const {
+    return node_;
+  }
+
+  /** Go to the next node */
+  HSHM_ALWAYS_INLINE skiplist_map_iterator& operator++() {
+    node_ = Next(node_);
+    make_correct();
+    return *this;
+  }
+
+  /** Skip erased nodes */
+  HSHM_ALWAYS_INLINE void make_correct() {
+    while (node_ && node_->IsErased()) {
+      node_ = Next(node_);
+    }
+  }
+
+  /** The node after \a node on the bottom level */
+  HSHM_ALWAYS_INLINE NODE_T* Next(NODE_T *node) const {
+    size_t off = NODE_T::Unmark(
+      node->GetNext()[0].off_.load(std::memory_order_acquire));
+    if (off == (size_t)-1) {
+      return nullptr;
+    }
+    return alloc_->template Convert<NODE_T>(OffsetPointer(off));
+  }
+
+  /** Check if two iterators are equal */
+  HSHM_ALWAYS_INLINE friend bool operator==(const skiplist_map_iterator &a,
+                                            const skiplist_map_iterator &b) {
+    return a.node_ == b.node_;
+  }
+
+  /** Check if two iterators are inequal */
+  HSHM_ALWAYS_INLINE friend bool operator!=(const skiplist_map_iterator &a,
+                                            const skiplist_map_iterator &b) {
+    return a.node_ != b.node_;
+  }
+
+  /** Determine whether this iterator is the end iterator */
+  HSHM_ALWAYS_INLINE bool is_end() const {
+    return node_ == nullptr;
+  }
+};
+
+/**
+ * MACROS used to simplify the skiplist_map namespace
+ * Used as inputs to the SHM_CONTAINER_TEMPLATE
+ * */
+#define CLASS_NAME skiplist_map
+#define TYPED_CLASS skiplist_map<Key, T>
+#define TYPED_HEADER ShmHeader<skiplist_map<Key, T>>
+
+/**
+ * A lock-free ordered map in shared memory. Nodes are linked into a
+ * random number of levels and inserted with a CAS on each level's
+ * OffsetPointer, so any number of threads or processes may insert, look
+ * up and scan concurrently without locks.
+ *
+ * Erase first marks the next pointers of a node, which makes it
+ * logically erased, then unlinks it with a CAS on each level. Searches
+ * unlink any marked node they pass, so erased nodes do not lengthen
+ * traversals. A concurrent reader may still be on an unlinked node, so
+ * erased nodes are kept on a retired list until compact(), clear() or the
+ * destructor frees them. Those must not race with other operations.
+ * Call compact() at quiescent points to bound memory under churn.
+ *
+ * Keys must be trivially copyable and ordered by operator<. Values must
+ * be trivially copyable.
+ * */
+template<typename Key, typename T>
+class skiplist_map : public ShmContainer {
+ public:
+  SHM_CONTAINER_TEMPLATE((CLASS_NAME), (TYPED_CLASS))
+  static_assert(std::is_trivially_copyable_v<Key> &&
+                std::is_trivially_copyable_v<T>,
+                "skiplist_map requires trivially copyable keys and values");
+
+  /**====================================
+   * Typedefs
+   * ===================================*/
+  typedef skiplist_node<Key, T> NODE_T;
+  typedef skiplist_map_iterator<Key, T> iterator_t;
+
+  /** The maximum number of levels */
+  static const uint32_t max_height_ = 24;
+
+  /**====================================
+   * Variables
+   * ===================================*/
+  AtomicOffsetPointer head_ptr_;  /**< Sentinel node of max_height_ levels */
+  AtomicOffsetPointer retired_ptr_;  /**< Erased nodes not yet freed */
+  sharded_counter<size_t, 4> length_;
+
+ public:
+  /**====================================
+   * Default Constructor
+   * ===================================*/
+
+  /** SHM constructor. Default. */
+  explicit skiplist_map(Allocator *alloc) {
+    shm_init_container(alloc);
+    SetNull();
+  }
+
+  /**====================================
+   * Copy Constructors
+   * ===================================*/
+
+  /** SHM copy constructor */
+  explicit skiplist_map(Allocator *alloc, const skiplist_map &other) {
+    shm_init_container(alloc);
+    SetNull();
+    shm_strong_copy_construct_and_op(other);
+  }
+
+  /** SHM copy assignment operator */
+  skiplist_map& operator=(const skiplist_map &other) {
+    if (this != &other) {
+      shm_destroy();
+      shm_strong_copy_construct_and_op(other);
+    }
+    return *this;
+  }
+
+  /** SHM copy constructor + operator main */
+  void shm_strong_copy_construct_and_op(const skiplist_map &other) {
+    for (auto iter = other.begin(); !iter.is_end(); ++iter) {
+      try_emplace((*iter).key_, (*iter).val_);
+    }
+  }
+
+  /**====================================
+   * Move Constructors
+   * ===================================*/
+
+  /** SHM move constructor. */
+  skiplist_map(Allocator *alloc, skiplist_map &&other) noexcept {
+    shm_init_container(alloc);
+    if (GetAllocator() == other.GetAllocator()) {
+      strong_copy(other);
+      other.SetNull();
+    } else {
+      SetNull();
+      shm_strong_copy_construct_and_op(other);
+      other.shm_destroy();
+    }
+  }
+
+  /** SHM move assignment operator. */
+  skiplist_map& operator=(skiplist_map &&other) noexcept {
+    if (this != &other) {
+      shm_destroy();
+      if (GetAllocator() == other.GetAllocator()) {
+        strong_copy(other);
+        other.SetNull();
+      } else {
+        shm_strong_copy_construct_and_op(other);
+        other.shm_destroy();
+      }
+    }
+    return *this;
+  }
+
+  /** Copy the list header */
+  HSHM_ALWAYS_INLINE void strong_copy(const skiplist_map &other) {
+    head_ptr_.off_ = other.head_ptr_.off_.load();
+    retired_ptr_.off_ = other.retired_ptr_.off_.load();
+    length_ = other.length_.load();
+  }
+
+  /**====================================
+   * Destructor
+   * ===================================*/
+
+  /** Check if the list has no nodes */
+  HSHM_ALWAYS_INLINE bool IsNull() const {
+    return head_ptr_.IsNull();
+  }
+
+  /** Sets this list as empty */
+  HSHM_ALWAYS_INLINE void SetNull() {
+    head_ptr_.SetNull();
+    retired_ptr_.SetNull();
+    length_ = 0;
+  }
+
+  /**
+   * Free every node, including the sentinel. Erased nodes still linked
+   * on the bottom level are freed from the retired list instead.
+   * */
+  void shm_destroy_main() {
+    OffsetPointer node_ptr = GetHeadPtr();
+    while (!node_ptr.IsNull()) {
+      NODE_T *node = GetAllocator()->template Convert<NODE_T>(node_ptr);
+      size_t next_off = node->GetNext()[0].off_.load();
+      if (!NODE_T::IsMarked(next_off)) {
+        GetAllocator()->Free(node_ptr);
+      }
+      node_ptr = OffsetPointer(NODE_T::Unmark(next_off));
+    }
+    FreeRetiredNodes();
+  }
+
+  /**====================================
+   * Concurrent Methods
+   * ===================================*/
+
+  /**
+   * Insert a (key, value) pair. Overrides the value if key already exists.
+   * @return true
+   * */
+  bool emplace(const Key &key, const T &val) {
+    return emplace_templ<true>(key, val);
+  }
+
+  /**
+   * Insert a (key, value) pair if key does not exist yet
+   * @return true if the pair was inserted
+   * */
+  bool try_emplace(const Key &key, const T &val) {
+    return emplace_templ<false>(key, val);
+  }
+
+  /**
+   * Erase the entry with \a key. The node is marked top-down, and the
+   * thread which marks its bottom level erases it. The node is then
+   * unlinked and retired.
+   * @return true if the key was found
+   * */
+  bool erase(const Key &key) {
+    if (IsNull()) {
+      return false;
+    }
+    NODE_T *preds[max_height_];
+    NODE_T *succs[max_height_];
+    NODE_T *node = FindPath(key, preds, succs);
+    if (node == nullptr) {
+      return false;
+    }
+    for (int level = node->height_ - 1; level >= 1; --level) {
+      MarkNext(node, level);
+    }
+    if (!MarkNext(node, 0)) {
+      return false;
+    }
+    length_ -= 1;
+    FindPath(key, preds, succs);
+    Retire(node);
+    return true;
+  }
+
+  /**
+   * Copy the value of \a key into \a val
+   * @return true if the key was found
+   * */
+  bool find(const Key &key, T &val) const {
+    NODE_T *node = FindNode(key);
+    return node && node->Read(val);
+  }
+
+  /** Whether \a key is in the map */
+  bool contains(const Key &key) const {
+    T val;
+    return find(key, val);
+  }
+
+  /**
+   * Copy at most \a max (key, value) pairs with keys in [lo, hi) into
+   * \a keys and \a vals, in key order. The scan is not a snapshot: pairs
+   * inserted or erased during the scan may or may not be seen.
+   *
+   * @return the number of pairs copied
+   * */
+  size_t scan(const Key &lo, const Key &hi, Key *keys, T *vals,
+              size_t max) const {
+    size_t n = 0;
+    for (iterator_t iter = lower_bound(lo);
+         !iter.is_end() && n < max; ++iter) {
+      NODE_T &node = *iter;
+      if (!(node.key_ < hi)) {
+        break;
+      }
+      if (node.Read(vals[n])) {
+        keys[n++] = node.key_;
+      }
+    }
+    return n;
+  }
+
+  /** The number of entries in the map */
+  HSHM_ALWAYS_INLINE size_t size() const {
+    return length_.load();
+  }
+
+  /**====================================
+   * Iterators
+   * ===================================*/
+
+  /** Find the first node whose key is not less than \a key */
+  iterator_t lower_bound(const Key &key) const {
+    if (IsNull()) {
+      return end();
+    }
+    NODE_T *preds[max_height_];
+    NODE_T *succs[max_height_];
+    FindPath(key, preds, succs);
+    return iterator_t(GetAllocator(), succs[0]);
+  }
+
+  /** Forward iterator begin */
+  iterator_t begin() const {
+    if (IsNull()) {
+      return end();
+    }
+    NODE_T *head = GetAllocator()->template Convert<NODE_T>(GetHeadPtr());
+    return iterator_t(GetAllocator(), LoadNext(head, 0));
+  }
+
+  /** Forward iterator end */
+  HSHM_ALWAYS_INLINE iterator_t end() const {
+    return iterator_t(GetAllocator(), nullptr);
+  }
+
+  /** Erase the entire map. Must not race with other operations. */
+  void clear() {
+    shm_destroy_main();
+    SetNull();
+  }
+
+  /**
+   * Free the erased nodes. Any erased node a search has not unlinked
+   * yet is unlinked first. Must not race with other operations.
+   *
+   * @return the number of nodes freed
+   * */
+  size_t compact() {
+    if (IsNull()) {
+      return 0;
+    }
+    NODE_T *head = GetAllocator()->template Convert<NODE_T>(GetHeadPtr());
+    for (int level = 0; level < (int)max_height_; ++level) {
+      NODE_T *pred = head;
+      NODE_T *curr = LoadNext(pred, level);
+      while (curr) {
+        size_t next_off = curr->GetNext()[level].off_.load();
+        if (NODE_T::IsMarked(next_off)) {
+          pred->GetNext()[level].off_ = NODE_T::Unmark(next_off);
+        } else {
+          pred = curr;
+        }
+        curr = LoadNext(pred, level);
+      }
+    }
+    return FreeRetiredNodes();
+  }
+
+ private:
+  /**====================================
+   * Helpers
+   * ===================================*/
+
+  /** Insert a (key, value) pair */
+  template<bool modify_existing>
+  bool emplace_templ(const Key &key, const T &val) {
+    NODE_T *preds[max_height_];
+    NODE_T *succs[max_height_];
+    GetOrCreateHead();
+    uint32_t height = RandomHeight();
+    OffsetPointer node_ptr;
+    NODE_T *node = nullptr;
+    while (true) {
+      // Modify an existing node
+      NODE_T *found = FindPath(key, preds, succs);
+      if (found) {
+        if constexpr(modify_existing) {
+          found->WriteLock();
+          found->val_ = val;
+          found->WriteUnlock();
+          // The node may have been erased before the value was set
+          if (found->IsErased()) {
+            continue;
+          }
+        }
+        if (node) {
+          GetAllocator()->Free(node_ptr);
+        }
+        return modify_existing;
+      }
+
+      // Link the new node into the bottom level
+      if (node == nullptr) {
+        node = GetAllocator()->template AllocatePtr<NODE_T, OffsetPointer>(
+          NODE_T::GetSize(height), node_ptr);
+        node->version_.store(0, std::memory_order_relaxed);
+        node->height_ = height;
+        node->key_ = key;
+        node->val_ = val;
+      }
+      for (uint32_t i = 0; i < height; ++i) {
+        node->GetNext()[i].off_ = ToOffset(succs[i]);
+      }
+      if (CasNext(preds[0], 0, succs[0], node_ptr)) {
+        break;
+      }
+    }
+    length_ += 1;
+
+    // Link the node into the upper levels. Once linked into the bottom
+    // level the node is visible, so this only speeds up later searches.
+    // Linking stops if the node is erased meanwhile.
+    for (uint32_t i = 1; i < height; ++i) {
+      while (true) {
+        size_t next_off = node->GetNext()[i].off_.load();
+        if (NODE_T::IsMarked(next_off)) {
+          break;
+        }
+        if (next_off != ToOffset(succs[i]) &&
+            !node->GetNext()[i].off_.compare_exchange_strong(
+              next_off, ToOffset(succs[i]))) {
+          continue;
+        }
+        if (CasNext(preds[i], i, succs[i], node_ptr)) {
+          break;
+        }
+        if (FindPath(key, preds, succs) != node) {
+          break;
+        }
+      }
+    }
+
+    // An erase may have missed the levels linked after it searched
+    if (node->IsErased()) {
+      FindPath(key, preds, succs);
+    }
+    return true;
+  }
+
+  /**
+   * Find the last node before \a key and the first node not before it
+   * on every level. Marked nodes passed on the way are unlinked, and the
+   * search restarts if another thread changed a predecessor first.
+   *
+   * @return the node with key, or null
+   * */
+  NODE_T* FindPath(const Key &key, NODE_T **preds, NODE_T **succs) const {
+  retry:
+    NODE_T *pred = GetAllocator()->template Convert<NODE_T>(GetHeadPtr());
+    for (int level = max_height_ - 1; level >= 0; --level) {
+      NODE_T *curr = LoadNext(pred, level);
+      while (curr) {
+        size_t next_off = curr->GetNext()[level].off_.load(
+          std::memory_order_acquire);
+        if (NODE_T::IsMarked(next_off)) {
+          // Unlink the erased node on this level
+          size_t curr_off = ToOffset(curr);
+          if (!pred->GetNext()[level].off_.compare_exchange_strong(
+              curr_off, NODE_T::Unmark(next_off))) {
+            goto retry;
+          }
+          curr = LoadNext(pred, level);
+          continue;
+        }
+        if (!(curr->key_ < key)) {
+          break;
+        }
+        pred = curr;
+        curr = FromOffset(next_off);
+      }
+      preds[level] = pred;
+      succs[level] = curr;
+    }
+    NODE_T *node = succs[0];
+    if (node && !(key < node->key_)) {
+      return node;
+    }
+    return nullptr;
+  }
+
+  /**
+   * Find the node with \a key without recording the path or unlinking
+   * erased nodes, which are skipped instead
+   * */
+  NODE_T* FindNode(const Key &key) const {
+    if (IsNull()) {
+      return nullptr;
+    }
+    NODE_T *pred = GetAllocator()->template Convert<NODE_T>(GetHeadPtr());
+    NODE_T *curr = nullptr;
+    for (int level = max_height_ - 1; level >= 0; --level) {
+      curr = LoadNext(pred, level);
+      while (curr) {
+        size_t next_off = curr->GetNext()[level].off_.load(
+          std::memory_order_acquire);
+        if (!NODE_T::IsMarked(next_off) && !(curr->key_ < key)) {
+          break;
+        }
+        if (!NODE_T::IsMarked(next_off)) {
+          pred = curr;
+        }
+        curr = FromOffset(next_off);
+      }
+    }
+    if (curr && !(key < curr->key_)) {
+      return curr;
+    }
+    return nullptr;
+  }
+
+  /** Load the next node of \a node on \a level, ignoring its mark */
+  HSHM_ALWAYS_INLINE NODE_T* LoadNext(NODE_T *node, int level) const {
+    return FromOffset(
+      node->GetNext()[level].off_.load(std::memory_order_acquire));
+  }
+
+  /** Get the node at a raw next offset, ignoring its mark */
+  HSHM_ALWAYS_INLINE NODE_T* FromOffset(size_t off) const {
+    off = NODE_T::Unmark(off);
+    if (off == (size_t)-1) {
+      return nullptr;
+    }
+    return GetAllocator()->template Convert<NODE_T>(OffsetPointer(off));
+  }
+
+  /**
+   * Mark the next pointer of \a node on \a level
+   * @return true if this thread marked it
+   * */
+  HSHM_ALWAYS_INLINE static bool MarkNext(NODE_T *node, int level) {
+    size_t off = node->GetNext()[level].off_.load();
+    while (!NODE_T::IsMarked(off)) {
+      if (node->GetNext()[level].off_.compare_exchange_weak(
+          off, NODE_T::Mark(off))) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /** Push an erased node onto the retired list */
+  HSHM_ALWAYS_INLINE void Retire(NODE_T *node) {
+    size_t node_off = ToOffset(node);
+    size_t head_off = retired_ptr_.off_.load();
+    do {
+      node->retired_ptr_ = OffsetPointer(head_off);
+    } while (!retired_ptr_.off_.compare_exchange_weak(head_off, node_off));
+  }
+
+  /**
+   * Free the nodes on the retired list. Must not race with other
+   * operations.
+   *
+   * @return the number of nodes freed
+   * */
+  size_t FreeRetiredNodes() {
+    size_t count = 0;
+    OffsetPointer node_ptr(retired_ptr_.off_.load());
+    while (!node_ptr.IsNull()) {
+      NODE_T *node = GetAllocator()->template Convert<NODE_T>(node_ptr);
+      OffsetPointer next_ptr = node->retired_ptr_;
+      GetAllocator()->Free(node_ptr);
+      node_ptr = next_ptr;
+      ++count;
+    }
+    retired_ptr_.SetNull();
+    return count;
+  }
+
+  /** Replace the next node of \a pred on \a level if it is \a expected */
+  HSHM_ALWAYS_INLINE bool CasNext(NODE_T *pred, int level, NODE_T *expected,
+                                  OffsetPointer desired) {
+    size_t off = ToOffset(expected);
+    return pred->GetNext()[level].off_.compare_exchange_strong(
+      off, desired.off_.load());
+  }
+
+  /** Get the offset of a node, or the null offset */
+  HSHM_ALWAYS_INLINE size_t ToOffset(NODE_T *node) const {
+    if (node == nullptr) {
+      return (size_t)-1;
+    }
+    return GetAllocator()->template
+      Convert<NODE_T, OffsetPointer>(node).off_.load();
+  }
+
+  /** Get the pointer to the sentinel node */
+  HSHM_ALWAYS_INLINE OffsetPointer GetHeadPtr() const {
+    return OffsetPointer(head_ptr_.off_.load(std::memory_order_acquire));
+  }
+
+  /** Allocate the sentinel node, unless another thread already has */
+  void GetOrCreateHead() {
+    if (!IsNull()) {
+      return;
+    }
+    OffsetPointer head_ptr;
+    NODE_T *head = GetAllocator()->template AllocatePtr<NODE_T, OffsetPointer>(
+      NODE_T::GetSize(max_height_), head_ptr);
+    head->version_.store(0, std::memory_order_relaxed);
+    head->height_ = max_height_;
+    for (uint32_t i = 0; i < max_height_; ++i) {
+      head->GetNext()[i].SetNull();
+    }
+    size_t null_off = (size_t)-1;
+    if (!head_ptr_.off_.compare_exchange_strong(null_off,
+                                                head_ptr.off_.load())) {
+      GetAllocator()->Free(head_ptr);
+    }
+  }
+
+  /** Pick the number of levels of a new node: P(h) = 4^-(h-1) */
+  HSHM_ALWAYS_INLINE static uint32_t RandomHeight() {
+    static thread_local uint64_t state =
+      0x9E3779B97F4A7C15ULL * (GetThreadShardIdx() + 1);
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    uint32_t height = 1;
+    uint64_t bits = state;
+    while (height < max_height_ && (bits & 3) == 0) {
+      ++height;
+      bits >>= 2;
+    }
+    return height;
+  }
+};
+
+}  // namespace hshm::ipc
+
+#undef TYPED_HEADER
+#undef TYPED_CLASS
+#undef CLASS_NAME
+
+#endif  // HERMES_DATA_STRUCTURES_SKIPLIST_MAP_H_
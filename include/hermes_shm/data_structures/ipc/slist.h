@@ -15,13 +15,14 @@
 #define HERMES_DATA_STRUCTURES_THREAD_UNSAFE_Sslist_H
 
 #include "hermes_shm/data_structures/ipc/internal/shm_internal.h"
+#include "hermes_shm/data_structures/ipc/internal/shm_node_pool.h"
 #include "hermes_shm/data_structures/containers/functional.h"
 #include "hermes_shm/data_structures/serialization/serialize_common.h"
 
 namespace hshm::ipc {
 
 /** forward pointer for slist */
-template<typename T>
+template<typename T, bool PRIVATE = false>
 class slist;
 
 /** represents an object within a slist */
@@ -41,11 +42,11 @@ struct slist_entry {
 /**
  * The slist iterator
  * */
-template<typename T>
+template<typename T, bool PRIVATE>
 struct slist_iterator_templ {
  public:
   /**< A shm reference to the containing slist object. */
-  slist<T> *slist_;
+  slist<T, PRIVATE> *slist_;
   /**< A pointer to the entry in shared memory */
   slist_entry<T> *entry_;
   /**< The offset of the entry in the shared-memory allocator */
@@ -55,7 +56,7 @@ struct slist_iterator_templ {
   slist_iterator_templ() = default;
 
   /** Construct an iterator */
-  explicit slist_iterator_templ(slist<T>& slist,
+  explicit slist_iterator_templ(slist<T, PRIVATE>& slist,
                                 slist_entry<T> *entry,
                                 OffsetPointer entry_ptr)
     : slist_(&slist), entry_(entry), entry_ptr_(entry_ptr) {}
@@ -91,8 +92,7 @@ struct slist_iterator_templ {
   slist_iterator_templ& operator++() {
     if (is_end()) { return *this; }
     entry_ptr_ = entry_->next_ptr_;
-    entry_ = slist_->GetAllocator()->template
-      Convert<slist_entry<T>>(entry_->next_ptr_);
+    entry_ = slist_->template ConvertPtr<slist_entry<T>>(entry_->next_ptr_);
     return *this;
   }
 
@@ -100,8 +100,7 @@ struct slist_iterator_templ {
   slist_iterator_templ& operator--() {
     if (is_end() || is_begin()) { return *this; }
     entry_ptr_ = entry_->prior_ptr_;
-    entry_ = slist_->GetAllocator()->template
-      Convert<slist_entry<T>>(entry_->prior_ptr_);
+    entry_ = slist_->template ConvertPtr<slist_entry<T>>(entry_->prior_ptr_);
     return *this;
   }
 
@@ -183,29 +182,30 @@ struct slist_iterator_templ {
  * Used as inputs to the SHM_CONTAINER_TEMPLATE
  * */
 #define CLASS_NAME slist
-#define TYPED_CLASS slist<T>
-#define TYPED_HEADER ShmHeader<slist<T>>
+#define TYPED_CLASS slist<T, PRIVATE>
+#define TYPED_HEADER ShmHeader<slist<T, PRIVATE>>
 
 /**
  * Doubly linked slist implementation
  * */
-template<typename T>
+template<typename T, bool PRIVATE>
 class slist : public ShmContainer {
  public:
   /**====================================
    * Variables
    * ===================================*/
-  SHM_CONTAINER_TEMPLATE((CLASS_NAME), (TYPED_CLASS))
+  SHM_CONTAINER_PRIVATE_TEMPLATE((CLASS_NAME), (TYPED_CLASS), (PRIVATE))
   OffsetPointer head_ptr_, tail_ptr_;
   size_t length_;
+  OffsetPointer pool_ptr_;
 
   /**====================================
    * Iterator Typedefs
    * ===================================*/
   /** forward iterator typedef */
-  typedef slist_iterator_templ<T> iterator_t;
+  typedef slist_iterator_templ<T, PRIVATE> iterator_t;
   /** const forward iterator typedef */
-  typedef slist_iterator_templ<T> citerator_t;
+  typedef slist_iterator_templ<T, PRIVATE> citerator_t;
 
  public:
   /**====================================
@@ -227,6 +227,7 @@ class slist : public ShmContainer {
     head_ptr_ = other.head_ptr_;
     tail_ptr_ = other.tail_ptr_;
     length_ = other.length_;
+    pool_ptr_ = other.pool_ptr_;
   }
 
   /** SHM copy constructor. From slist. */
@@ -275,9 +276,12 @@ class slist : public ShmContainer {
    * Move Constructors
    * ===================================*/
 
-  /** SHM move constructor. From slist. */
+  /**
+   * SHM move constructor. From slist. This cannot throw, so \a alloc is
+   * not checked against private mode; it must be usable by this container.
+   * */
   slist(Allocator *alloc, slist &&other) noexcept {
-    shm_init_container(alloc);
+    alloc_id_.Set(alloc);
     if (GetAllocator() == other.GetAllocator()) {
       strong_copy(other);
       other.SetNull();
@@ -306,9 +310,9 @@ class slist : public ShmContainer {
   * Destructor
   * ===================================*/
 
-  /** Check if the list is empty */
+  /** Check if the list is empty and holds no pooled nodes */
   bool IsNull() const {
-    return length_ == 0;
+    return length_ == 0 && pool_ptr_.IsNull();
   }
 
   /** Sets this list as empty */
@@ -316,17 +320,40 @@ class slist : public ShmContainer {
     length_ = 0;
     head_ptr_.SetNull();
     tail_ptr_.SetNull();
+    pool_ptr_.SetNull();
   }
 
   /** Destroy all shared memory allocated by the slist */
   void shm_destroy_main() {
     clear();
+    _destroy_node_pool();
   }
 
   /**====================================
    * slist Methods
    * ===================================*/
 
+  /**
+   * Recycle erased nodes through a freelist local to this slist instead of
+   * returning them to the allocator. The slist must be empty. Entries
+   * of a pooled slist must not be moved to another slist with
+   * unlink_all / link_front.
+   *
+   * @param max_free the number of free nodes to keep before returning
+   * them to the allocator
+   * @param chunk_nodes the number of nodes to allocate at once. When larger
+   * than 1, nodes are carved out of contiguous chunks.
+   * */
+  void enable_node_pool(size_t max_free, size_t chunk_nodes = 1) {
+    if (length_ != 0) {
+      throw NODE_POOL_IN_USE.format("slist::enable_node_pool");
+    }
+    _destroy_node_pool();
+    auto pool = GetAllocator()->template
+      AllocateObjs<node_pool<slist_entry<T>>>(1, pool_ptr_);
+    pool->shm_init(max_free, chunk_nodes);
+  }
+
   /** Construct an element at the back of the slist */
   template<typename... Args>
   void emplace_back(Args&&... args) {
@@ -353,19 +380,51 @@ class slist : public ShmContainer {
       head_ptr_ = entry_ptr;
     } else if (pos.is_end()) {
       entry->next_ptr_.SetNull();
-      auto tail = GetAllocator()->template
-        Convert<slist_entry<T>>(tail_ptr_);
+      auto tail = ConvertPtr<slist_entry<T>>(tail_ptr_);
       tail->next_ptr_ = entry_ptr;
       tail_ptr_ = entry_ptr;
     } else {
       auto prior_iter = find_prior(pos);
       slist_entry<T> *prior = prior_iter.entry_;
-      entry->next_ptr_ = pos.entry_->next_ptr_;
+      entry->next_ptr_ = pos.entry_ptr_;
       prior->next_ptr_ = entry_ptr;
     }
     ++length_;
   }
 
+  /**
+   * Unlink every entry from the slist without destroying them. The caller
+   * becomes responsible for re-linking (see link_front) or freeing them.
+   *
+   * @return the offset of the first entry in the unlinked chain
+   * */
+  OffsetPointer unlink_all() {
+    OffsetPointer head_ptr = OffsetPointer::GetNull();
+    if (size() > 0) {
+      head_ptr = head_ptr_;
+    }
+    length_ = 0;
+    head_ptr_.SetNull();
+    tail_ptr_.SetNull();
+    return head_ptr;
+  }
+
+  /**
+   * Link an existing entry at the front of the slist. The entry must have
+   * been allocated by this slist's allocator and must not belong to any
+   * other slist.
+   * */
+  void link_front(OffsetPointer entry_ptr, slist_entry<T> *entry) {
+    if (size() == 0) {
+      entry->next_ptr_.SetNull();
+      tail_ptr_ = entry_ptr;
+    } else {
+      entry->next_ptr_ = head_ptr_;
+    }
+    head_ptr_ = entry_ptr;
+    ++length_;
+  }
+
   /** Find the element prior to an slist_entry */
   iterator_t find_prior(iterator_t pos) {
     if (pos.is_end()) {
@@ -404,7 +463,7 @@ class slist : public ShmContainer {
     while (pos != last) {
       auto next = pos + 1;
       HSHM_DESTROY_AR(pos.entry_->data_)
-      GetAllocator()->Free(pos.entry_ptr_);
+      _free_entry(pos.entry_ptr_, pos.entry_);
       --length_;
       pos = next;
     }
@@ -418,6 +477,10 @@ class slist : public ShmContainer {
     if (last.entry_ptr_.IsNull()) {
       tail_ptr_ = first_prior.entry_ptr_;
     }
+
+    if (length_ == 0 && !pool_ptr_.IsNull()) {
+      _node_pool()->Trim(GetAllocator());
+    }
   }
 
   /** Destroy all elements in the slist */
@@ -455,8 +518,7 @@ class slist : public ShmContainer {
   /** Forward iterator begin */
   iterator_t begin() {
     if (size() == 0) { return end(); }
-    auto head = GetAllocator()->template
-      Convert<slist_entry<T>>(head_ptr_);
+    auto head = ConvertPtr<slist_entry<T>>(head_ptr_);
     return iterator_t(*this, head, head_ptr_);
   }
 
@@ -469,16 +531,14 @@ class slist : public ShmContainer {
   /** Forward iterator to last entry of list */
   iterator_t last() {
     if (size() == 0) { return end(); }
-    auto tail = GetAllocator()->template
-      Convert<slist_entry<T>>(tail_ptr_);
+    auto tail = ConvertPtr<slist_entry<T>>(tail_ptr_);
     return iterator_t(*this, tail, tail_ptr_);
   }
 
   /** Constant forward iterator begin */
   citerator_t cbegin() const {
     if (size() == 0) { return cend(); }
-    auto head = GetAllocator()->template
-      Convert<slist_entry<T>>(head_ptr_);
+    auto head = ConvertPtr<slist_entry<T>>(head_ptr_);
     return citerator_t(const_cast<slist&>(*this), head, head_ptr_);
   }
 
@@ -495,27 +555,64 @@ class slist : public ShmContainer {
   /** Serialize */
   template <typename Ar>
   void save(Ar &ar) const {
-    save_list<Ar, hipc::slist<T>, T>(ar, *this);
+    save_list<Ar, slist, T>(ar, *this);
   }
 
   /** Deserialize */
   template <typename Ar>
   void load(Ar &ar) {
-    load_list<Ar, hipc::slist<T>, T>(ar, *this);
+    load_list<Ar, slist, T>(ar, *this);
   }
 
  private:
   template<typename ...Args>
   slist_entry<T>* _create_entry(OffsetPointer &p, Args&& ...args) {
-    auto entry = GetAllocator()->template
-      AllocateObjs<slist_entry<T>>(1, p);
+    slist_entry<T> *entry;
+    if (pool_ptr_.IsNull()) {
+      entry = GetAllocator()->template AllocateObjs<slist_entry<T>>(1, p);
+    } else {
+      entry = _node_pool()->AllocateEntry(GetAllocator(), p);
+    }
     HSHM_MAKE_AR(entry->data_, GetAllocator(), std::forward<Args>(args)...)
     return entry;
   }
+
+  /** Release the memory of an entry whose data was already destroyed */
+  HSHM_ALWAYS_INLINE void _free_entry(OffsetPointer p,
+                                      slist_entry<T> *entry) {
+    if (pool_ptr_.IsNull()) {
+      GetAllocator()->Free(p);
+    } else {
+      _node_pool()->FreeEntry(GetAllocator(), p, entry);
+    }
+  }
+
+  /** Get the node pool of this slist */
+  HSHM_ALWAYS_INLINE node_pool<slist_entry<T>>* _node_pool() {
+    return ConvertPtr<node_pool<slist_entry<T>>>(pool_ptr_);
+  }
+
+  /** Free the node pool and every node it holds */
+  void _destroy_node_pool() {
+    if (pool_ptr_.IsNull()) {
+      return;
+    }
+    _node_pool()->shm_destroy(GetAllocator());
+    GetAllocator()->Free(pool_ptr_);
+    pool_ptr_.SetNull();
+  }
 };
 
 }  // namespace hshm::ipc
 
+namespace hshm {
+
+/** A singly-linked list in private memory */
+template<typename T>
+using slist = ipc::slist<T, true>;
+
+}  // namespace hshm
+
 #undef CLASS_NAME
 #undef TYPED_CLASS
 #undef TYPED_HEADER
@@ -15,6 +15,7 @@
 
 #include "hermes_shm/data_structures/ipc/internal/shm_internal.h"
 #include "hermes_shm/thread/lock.h"
+#include "hermes_shm/types/sharded_counter.h"
 #include "vector.h"
 #include "ticket_queue.h"
 
@@ -35,6 +36,13 @@ class split_ticket_queue;
 /**
  * A MPMC queue for allocating tickets. Handles concurrency
  * without blocking.
+ *
+ * By default, each operation picks its starting lane round-robin. In
+ * affine mode, each thread has a home lane and only visits other lanes
+ * when its own is full (emplace) or empty (pop). A pop that finds its
+ * home lane empty steals a batch of tickets from the first non-empty
+ * lane, so the following pops are served locally. Stealing does not
+ * preserve the order of tickets within a lane.
  * */
 template<typename T>
 class split_ticket_queue : public ShmContainer {
@@ -42,6 +50,9 @@ class split_ticket_queue : public ShmContainer {
   SHM_CONTAINER_TEMPLATE((CLASS_NAME), (TYPED_CLASS))
   ShmArchive<vector<ticket_queue<T>>> splits_;
   std::atomic<uint16_t> rr_tail_, rr_head_;
+  bool affine_;
+  /** The number of tickets moved to the home lane per steal */
+  static const size_t steal_batch_ = 16;
 
  public:
   /**====================================
@@ -51,13 +62,15 @@ class split_ticket_queue : public ShmContainer {
   /** SHM constructor. Default. */
   explicit split_ticket_queue(Allocator *alloc,
                               size_t depth_per_split = 1024,
-                              size_t split = 0) {
+                              size_t split = 0,
+                              bool affine = false) {
     shm_init_container(alloc);
     if (split == 0) {
       split = HERMES_SYSTEM_INFO->ncpu_;
     }
     HSHM_MAKE_AR(splits_, GetAllocator(), split, depth_per_split);
     SetNull();
+    affine_ = affine;
   }
 
   /**====================================
@@ -84,6 +97,7 @@ class split_ticket_queue : public ShmContainer {
   /** SHM copy constructor + operator main */
   void shm_strong_copy_construct_and_op(const split_ticket_queue &other) {
     (*splits_) = (*other.splits_);
+    affine_ = other.affine_;
   }
 
   /**====================================
@@ -96,6 +110,7 @@ class split_ticket_queue : public ShmContainer {
     shm_init_container(alloc);
     if (GetAllocator() == other.GetAllocator()) {
       (*splits_) = std::move(*other.splits_);
+      affine_ = other.affine_;
       other.SetNull();
     } else {
       shm_strong_copy_construct_and_op(other);
@@ -109,6 +124,7 @@ class split_ticket_queue : public ShmContainer {
       shm_destroy();
       if (GetAllocator() == other.GetAllocator()) {
         (*splits_) = std::move(*other.splits_);
+        affine_ = other.affine_;
         other.SetNull();
       } else {
         shm_strong_copy_construct_and_op(other);
@@ -136,6 +152,7 @@ class split_ticket_queue : public ShmContainer {
   void SetNull() {
     rr_tail_ = 0;
     rr_head_ = 0;
+    affine_ = false;
   }
 
   /**====================================
@@ -145,10 +162,14 @@ class split_ticket_queue : public ShmContainer {
   /** Construct an element at \a pos position in the queue */
   template<typename ...Args>
   qtok_t emplace(T &tkt) {
-    uint16_t rr = rr_tail_.fetch_add(1);
     auto &splits = (*splits_);
     size_t num_splits = splits.size();
-    uint16_t qid_start = rr % num_splits;
+    size_t qid_start;
+    if (affine_) {
+      qid_start = GetHomeLane(num_splits);
+    } else {
+      qid_start = rr_tail_.fetch_add(1) % num_splits;
+    }
     for (size_t i = 0; i < num_splits; ++i) {
       uint32_t qid = (qid_start + i) % num_splits;
       ticket_queue<T> &queue = (*splits_)[qid];
@@ -163,9 +184,12 @@ class split_ticket_queue : public ShmContainer {
  public:
   /** Pop an element from the queue */
   qtok_t pop(T &tkt) {
-    uint16_t rr = rr_head_.fetch_add(1);
     auto &splits = (*splits_);
     size_t num_splits = splits.size();
+    if (affine_) {
+      return AffinePop(tkt, num_splits);
+    }
+    uint16_t rr = rr_head_.fetch_add(1);
     uint16_t qid_start = rr % num_splits;
     for (size_t i = 0; i < num_splits; ++i) {
       uint32_t qid = (qid_start + i) % num_splits;
@@ -177,6 +201,34 @@ class split_ticket_queue : public ShmContainer {
     }
     return qtok_t::GetNull();
   }
+
+ private:
+  /** The lane of the calling thread */
+  HSHM_ALWAYS_INLINE static size_t GetHomeLane(size_t num_splits) {
+    return GetThreadShardIdx() % num_splits;
+  }
+
+  /**
+   * Pop from the home lane, stealing a batch from another lane if empty.
+   * As in round-robin mode, the token is that of the lane which
+   * produced \a tkt.
+   * */
+  qtok_t AffinePop(T &tkt, size_t num_splits) {
+    auto &splits = (*splits_);
+    size_t home = GetHomeLane(num_splits);
+    qtok_t qtok = splits[home].pop(tkt);
+    if (!qtok.IsNull() || num_splits == 1) {
+      return qtok;
+    }
+    for (size_t i = 1; i < num_splits; ++i) {
+      ticket_queue<T> &victim = splits[(home + i) % num_splits];
+      qtok = splits[home].steal(victim, tkt, steal_batch_);
+      if (!qtok.IsNull()) {
+        return qtok;
+      }
+    }
+    return qtok_t::GetNull();
+  }
 };
 
 }  // namespace hshm::ipc
@@ -35,16 +35,28 @@ class spsc_queue_templ;
 #define TYPED_HEADER ShmHeader<spsc_queue_templ<T, EXTENSIBLE>>
 
 /**
- * A queue optimized for multiple producers (emplace) with a single
- * consumer (pop).
+ * A queue optimized for a single producer (emplace) with a single
+ * consumer (pop). tail_ and head_ are padded onto separate cache lines.
+ *
+ * The producer keeps a private copy of head_ and the consumer a private
+ * copy of tail_. Each only reloads the other's index when the queue
+ * looks full (or empty) by its copy, so the common case touches no cache
+ * line the other side writes. The depth is rounded up to a power of two
+ * so that slots are found with a mask.
  * */
 template<typename T, bool EXTENSIBLE>
 class spsc_queue_templ : public ShmContainer {
  public:
   SHM_CONTAINER_TEMPLATE((CLASS_NAME), (TYPED_CLASS))
   ShmArchive<vector<T>> queue_;
-  _qtok_t tail_;
-  _qtok_t head_;
+  _qtok_t mask_;
+  char pad0_[HSHM_CACHE_LINE_SIZE];
+  std::atomic<_qtok_t> tail_;
+  _qtok_t head_cache_;  /**< The producer's copy of head_ */
+  char pad1_[HSHM_CACHE_LINE_SIZE];
+  std::atomic<_qtok_t> head_;
+  _qtok_t tail_cache_;  /**< The consumer's copy of tail_ */
+  char pad2_[HSHM_CACHE_LINE_SIZE];
 
  public:
   /**====================================
@@ -55,7 +67,12 @@ class spsc_queue_templ : public ShmContainer {
   explicit spsc_queue_templ(Allocator *alloc,
                             size_t depth = 1024) {
     shm_init_container(alloc);
-    HSHM_MAKE_AR(queue_, GetAllocator(), depth)
+    size_t slot_count = 1;
+    while (slot_count < depth) {
+      slot_count <<= 1;
+    }
+    HSHM_MAKE_AR(queue_, GetAllocator(), slot_count)
+    mask_ = slot_count - 1;
     SetNull();
   }
 
@@ -82,11 +99,19 @@ class spsc_queue_templ : public ShmContainer {
 
   /** SHM copy constructor + operator main */
   void shm_strong_copy_construct_and_op(const spsc_queue_templ &other) {
-    head_ = other.head_;
-    tail_ = other.tail_;
+    strong_copy_indices(other);
     (*queue_) = (*other.queue_);
   }
 
+  /** Copy the indices of another queue with the same depth */
+  void strong_copy_indices(const spsc_queue_templ &other) {
+    mask_ = other.mask_;
+    head_ = other.head_.load();
+    tail_ = other.tail_.load();
+    head_cache_ = head_.load();
+    tail_cache_ = tail_.load();
+  }
+
   /**====================================
    * Move Constructors
    * ===================================*/
@@ -96,8 +121,7 @@ class spsc_queue_templ : public ShmContainer {
                    spsc_queue_templ &&other) noexcept {
     shm_init_container(alloc);
     if (GetAllocator() == other.GetAllocator()) {
-      head_ = other.head_;
-      tail_ = other.tail_;
+      strong_copy_indices(other);
       (*queue_) = std::move(*other.queue_);
       other.SetNull();
     } else {
@@ -111,8 +135,7 @@ class spsc_queue_templ : public ShmContainer {
     if (this != &other) {
       shm_destroy();
       if (GetAllocator() == other.GetAllocator()) {
-        head_ = other.head_;
-        tail_ = other.tail_;
+        strong_copy_indices(other);
         (*queue_) = std::move(*other.queue_);
         other.SetNull();
       } else {
@@ -141,6 +164,8 @@ class spsc_queue_templ : public ShmContainer {
   void SetNull() {
     head_ = 0;
     tail_ = 0;
+    head_cache_ = 0;
+    tail_cache_ = 0;
   }
 
   /**====================================
@@ -151,39 +176,91 @@ class spsc_queue_templ : public ShmContainer {
   template<typename ...Args>
   qtok_t emplace(Args&&... args) {
     // Don't emplace if there is no space
-    _qtok_t entry_tok = tail_;
-    size_t size = tail_ - head_;
-    auto &queue = (*queue_);
-    if (size >= queue.size()) {
-      return qtok_t::GetNull();
+    _qtok_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_cache_ > mask_) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+      if (tail - head_cache_ > mask_) {
+        return qtok_t::GetNull();
+      }
     }
 
     // Do the emplace
-    _qtok_t idx = entry_tok % queue.size();
-    auto iter = queue.begin() + idx;
+    auto &queue = (*queue_);
+    auto iter = queue.begin() + (tail & mask_);
     queue.replace(iter, std::forward<Args>(args)...);
-    tail_ += 1;
-    return qtok_t(entry_tok);
+    tail_.store(tail + 1, std::memory_order_release);
+    return qtok_t(tail);
+  }
+
+  /**
+   * Copy up to \a count objects from \a vals to the tail of the queue,
+   * publishing them with a single update of tail_.
+   *
+   * @return the number of objects emplaced before the queue became full
+   * */
+  size_t emplace_n(const T *vals, size_t count) {
+    _qtok_t tail = tail_.load(std::memory_order_relaxed);
+    if (mask_ + 1 - (tail - head_cache_) < count) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+      count = std::min<size_t>(count, mask_ + 1 - (tail - head_cache_));
+    }
+    auto &queue = (*queue_);
+    for (size_t i = 0; i < count; ++i) {
+      auto iter = queue.begin() + ((tail + i) & mask_);
+      queue.replace(iter, vals[i]);
+    }
+    tail_.store(tail + count, std::memory_order_release);
+    return count;
   }
 
  public:
   /** Consumer pops the head object */
   qtok_t pop(T &val) {
     // Don't pop if there's no entries
-    _qtok_t head = head_;
-    _qtok_t tail = tail_;
-    if (head >= tail) {
-      return qtok_t::GetNull();
+    _qtok_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_cache_) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+      if (head == tail_cache_) {
+        return qtok_t::GetNull();
+      }
     }
 
     // Pop the element
-    auto &queue = (*queue_);
-    _qtok_t idx = head % queue.size();
-    T &entry = queue[idx];
+    T &entry = (*queue_)[head & mask_];
     (val) = std::move(entry);
-    head_ += 1;
+    head_.store(head + 1, std::memory_order_release);
     return qtok_t(head);
   }
+
+  /**
+   * Pop up to \a count objects into \a vals, consuming them with a
+   * single update of head_.
+   *
+   * @return the number of objects popped
+   * */
+  size_t pop_n(T *vals, size_t count) {
+    _qtok_t head = head_.load(std::memory_order_relaxed);
+    if (tail_cache_ - head < count) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+      count = std::min<size_t>(count, tail_cache_ - head);
+    }
+    auto &queue = (*queue_);
+    for (size_t i = 0; i < count; ++i) {
+      vals[i] = std::move(queue[(head + i) & mask_]);
+    }
+    head_.store(head + count, std::memory_order_release);
+    return count;
+  }
+
+  /** Get size at this moment */
+  size_t GetSize() const {
+    return tail_.load() - head_.load();
+  }
+
+  /** Get the number of slots in the queue */
+  size_t GetDepth() const {
+    return mask_ + 1;
+  }
 };
 
 template<typename T>
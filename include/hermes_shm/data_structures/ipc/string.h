@@ -22,7 +22,7 @@
 namespace hshm::ipc {
 
 /** forward declaration for string */
-template<size_t SSO>
+template<size_t SSO, bool PRIVATE = false>
 class string_templ;
 
 /**
@@ -30,12 +30,12 @@ class string_templ;
  * Used as inputs to the SHM_CONTAINER_TEMPLATE
  * */
 #define CLASS_NAME string_templ
-#define TYPED_CLASS string_templ<SSO>
-#define TYPED_HEADER ShmHeader<string_templ<SSO>>
+#define TYPED_CLASS string_templ<SSO, PRIVATE>
+#define TYPED_HEADER ShmHeader<string_templ<SSO, PRIVATE>>
 
 /** string shared-memory header */
-template<size_t SSO>
-struct ShmHeader<string_templ<SSO>> {
+template<size_t SSO, bool PRIVATE>
+struct ShmHeader<string_templ<SSO, PRIVATE>> {
   SHM_CONTAINER_HEADER_TEMPLATE(ShmHeader)
   size_t length_;
   char sso_[SSO];
@@ -52,12 +52,13 @@ struct ShmHeader<string_templ<SSO>> {
 };
 
 /**
- * A string of characters.
+ * A string of characters. A PRIVATE string lives in process memory and
+ * stores native pointers (see ShmAllocRef).
  * */
-template<size_t SSO>
+template<size_t SSO, bool PRIVATE>
 class string_templ : public ShmContainer {
  public:
-  SHM_CONTAINER_TEMPLATE((CLASS_NAME), (TYPED_CLASS))
+  SHM_CONTAINER_PRIVATE_TEMPLATE((CLASS_NAME), (TYPED_CLASS), (PRIVATE))
 
  public:
   size_t length_;
@@ -245,7 +246,7 @@ class string_templ : public ShmContainer {
     if (length_ < SSO) {
       return sso_;
     } else {
-      return GetAllocator()->template Convert<char, Pointer>(text_);
+      return ConvertPtr<char, Pointer>(text_);
     }
   }
 
@@ -254,7 +255,7 @@ class string_templ : public ShmContainer {
     if (length_ < SSO) {
       return sso_;
     } else {
-      return GetAllocator()->template Convert<char, Pointer>(text_);
+      return ConvertPtr<char, Pointer>(text_);
     }
   }
 
@@ -347,14 +348,17 @@ typedef string_templ<32> string;
 /** Consider the string as an uniterpreted set of bytes */
 typedef string charbuf;
 
+/** A string in private memory. hshm::string is the heap charbuf. */
+typedef string_templ<32, true> private_string;
+
 }  // namespace hshm::ipc
 
 namespace std {
 
 /** Hash function for string */
-template<size_t SSO>
-struct hash<hshm::ipc::string_templ<SSO>> {
-  size_t operator()(const hshm::ipc::string_templ<SSO> &text) const {
+template<size_t SSO, bool PRIVATE>
+struct hash<hshm::ipc::string_templ<SSO, PRIVATE>> {
+  size_t operator()(const hshm::ipc::string_templ<SSO, PRIVATE> &text) const {
     size_t sum = 0;
     for (size_t i = 0; i < text.size(); ++i) {
       auto shift = static_cast<size_t>(i % sizeof(size_t));
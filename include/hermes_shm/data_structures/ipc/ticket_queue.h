@@ -153,6 +153,40 @@ class ticket_queue : public ShmContainer {
     lock_.Unlock();
     return qtok;
   }
+
+  /**
+   * Pop a ticket from \a victim and move up to \a count - 1 more of its
+   * tickets into this queue. The victim is only try-locked, so two queues
+   * stealing from each other cannot deadlock.
+   *
+   * @return the token of the victim pop which produced \a tkt, or null
+   * */
+  qtok_t steal(ticket_queue &victim, T &tkt, size_t count) {
+    lock_.Lock(0);
+    if (!victim.lock_.TryLock(0)) {
+      lock_.Unlock();
+      return victim.pop(tkt);
+    }
+    qtok_t qtok = victim.queue_->pop(tkt);
+    if (!qtok.IsNull()) {
+      T moved;
+      for (size_t i = 1; i < count; ++i) {
+        if (victim.queue_->pop(moved).IsNull()) {
+          break;
+        }
+        if (queue_->emplace(moved).IsNull()) {
+          // This queue is full. The pop above freed a slot in the victim,
+          // so this cannot fail, but the ticket is appended at the
+          // victim's tail rather than returned to its old position.
+          victim.queue_->emplace(moved);
+          break;
+        }
+      }
+    }
+    victim.lock_.Unlock();
+    lock_.Unlock();
+    return qtok;
+  }
 };
 
 }  // namespace hshm::ipc
@@ -19,6 +19,7 @@
 #include "hermes_shm/data_structures/ipc/slist.h"
 #include "pair.h"
 #include "hermes_shm/types/atomic.h"
+#include "hermes_shm/types/sharded_counter.h"
 #include "hermes_shm/data_structures/ipc/internal/shm_internal.h"
 
 namespace hshm::ipc {
@@ -27,13 +28,48 @@ namespace hshm::ipc {
 template<typename Key, typename T, class Hash = std::hash<Key>>
 class unordered_map;
 
+/** forward pointer for concurrent_unordered_map */
+template<typename Key, typename T, class Hash>
+class concurrent_unordered_map;
+
+/**
+ * A (key, value) pair stored in an unordered_map bucket, along with the
+ * full hash of its key. Lookups reject most non-matching entries by
+ * comparing hashes, and rehashing does not need to rehash keys.
+ * */
+template<typename Key, typename T>
+struct unordered_map_collision : public pair<Key, T> {
+  size_t hash_;
+
+  /** Construct the pair from \a args */
+  template<typename ...Args>
+  explicit unordered_map_collision(Allocator *alloc, size_t hash,
+                                   Args&& ...args)
+  : pair<Key, T>(alloc, std::forward<Args>(args)...), hash_(hash) {}
+
+  /** SHM copy constructor */
+  explicit unordered_map_collision(Allocator *alloc,
+                                   const unordered_map_collision &other)
+  : pair<Key, T>(alloc, other), hash_(other.hash_) {}
+
+  /** SHM move constructor */
+  explicit unordered_map_collision(Allocator *alloc,
+                                   unordered_map_collision &&other)
+  : pair<Key, T>(alloc, std::move(other)), hash_(other.hash_) {}
+};
+
+/** Relocatable if the underlying pair is */
+template<typename Key, typename T>
+struct is_trivially_relocatable<unordered_map_collision<Key, T>>
+  : is_trivially_relocatable<pair<Key, T>> {};
+
 /**
  * The unordered map iterator (bucket_iter, slist_iter)
  * */
 template<typename Key, typename T, class Hash>
 struct unordered_map_iterator {
  public:
-  using COLLISION_T = hipc::pair<Key, T>;
+  using COLLISION_T = unordered_map_collision<Key, T>;
   using BUCKET_T = hipc::slist<COLLISION_T>;
 
  public:
@@ -49,6 +85,13 @@ struct unordered_map_iterator {
     unordered_map<Key, T, Hash> &map)
   : map_(&map) {}
 
+  /** Construct the iterator at \a collision of \a bucket */
+  HSHM_ALWAYS_INLINE explicit unordered_map_iterator(
+    unordered_map<Key, T, Hash> &map,
+    const typename vector<BUCKET_T>::iterator_t &bucket,
+    const typename slist<COLLISION_T>::iterator_t &collision)
+  : map_(&map), bucket_(bucket), collision_(collision) {}
+
   /** Copy constructor  */
   HSHM_ALWAYS_INLINE unordered_map_iterator(
     const unordered_map_iterator &other) {
@@ -156,7 +199,8 @@ struct unordered_map_iterator {
 #define TYPED_HEADER ShmHeader<unordered_map<Key, T, Hash>>
 
 /**
- * The unordered map implementation
+ * The unordered map implementation. Iteration visits every bucket, so
+ * maps which are iterated often should use dense_unordered_map instead.
  * */
 template<typename Key, typename T, class Hash>
 class unordered_map : public ShmContainer {
@@ -168,7 +212,8 @@ class unordered_map : public ShmContainer {
    * ===================================*/
   typedef unordered_map_iterator<Key, T, Hash> iterator_t;
   friend iterator_t;
-  using COLLISION_T = hipc::pair<Key, T>;
+  friend concurrent_unordered_map<Key, T, Hash>;
+  using COLLISION_T = unordered_map_collision<Key, T>;
   using BUCKET_T = hipc::slist<COLLISION_T>;
 
   /**====================================
@@ -177,7 +222,15 @@ class unordered_map : public ShmContainer {
   ShmArchive<vector<BUCKET_T>> buckets_;
   RealNumber max_capacity_;
   RealNumber growth_;
-  hipc::atomic<size_t> length_;
+  hipc::sharded_counter<size_t, 4> length_;  /**< Few shards to bound map size */
+  size_t old_num_buckets_;  /**< Bucket count before an unfinished rehash */
+  size_t rehash_pos_;  /**< The next old bucket to migrate during a rehash */
+  bool incremental_;  /**< Whether growth migrates buckets incrementally */
+
+  /** The number of buckets migrated per operation during a rehash */
+  static const size_t rehash_batch_ = 8;
+  /** The number of keys whose buckets are prefetched at once */
+  static const size_t prefetch_batch_ = 16;
 
  public:
   /**====================================
@@ -192,16 +245,20 @@ class unordered_map : public ShmContainer {
    * @param max_capacity the maximum number of elements before a growth is
    * triggered
    * @param growth the multiplier to grow the bucket vector size
+   * @param incremental whether a growth migrates a few buckets per
+   * modification instead of all buckets at once
    * */
   explicit unordered_map(Allocator *alloc,
                          int num_buckets = 20,
                          RealNumber max_capacity = RealNumber(4, 5),
-                         RealNumber growth = RealNumber(5, 4)) {
+                         RealNumber growth = RealNumber(5, 4),
+                         bool incremental = false) {
     shm_init_container(alloc);
     HSHM_MAKE_AR(buckets_, GetAllocator(), num_buckets)
     max_capacity_ = max_capacity;
     growth_ = growth;
-    length_ = 0;
+    incremental_ = incremental;
+    SetNull();
   }
 
   /**====================================
@@ -218,7 +275,7 @@ class unordered_map : public ShmContainer {
   /** SHM copy constructor main */
   void shm_strong_copy_construct(const unordered_map &other) {
     SetNull();
-    HSHM_MAKE_AR(buckets_, GetAllocator(), other.GetBuckets())
+    HSHM_MAKE_AR(buckets_, GetAllocator(), other.get_num_buckets())
     shm_strong_copy_construct_and_op(other);
   }
 
@@ -242,6 +299,7 @@ class unordered_map : public ShmContainer {
   void shm_strong_copy_construct_and_op(const unordered_map &other) {
     max_capacity_ = other.max_capacity_;
     growth_ = other.growth_;
+    incremental_ = other.incremental_;
     for (hipc::pair<Key, T> &entry : other) {
       emplace_templ<false, true>(
         entry.GetKey(), entry.GetVal());
@@ -271,6 +329,9 @@ class unordered_map : public ShmContainer {
     max_capacity_ = other.max_capacity_;
     growth_ = other.growth_;
     length_ = other.length_.load();
+    old_num_buckets_ = other.old_num_buckets_;
+    rehash_pos_ = other.rehash_pos_;
+    incremental_ = other.incremental_;
   }
 
   /** SHM move assignment operator. */
@@ -293,14 +354,16 @@ class unordered_map : public ShmContainer {
    * Destructor
    * ===================================*/
 
-  /** Check if the pair is empty */
+  /** Check if the map is empty (has no bucket vector) */
   HSHM_ALWAYS_INLINE bool IsNull() {
-    return length_.load() == 0;
+    return GetBuckets().IsNull();
   }
 
   /** Sets this pair as empty */
   HSHM_ALWAYS_INLINE void SetNull() {
     length_ = 0;
+    old_num_buckets_ = 0;
+    rehash_pos_ = 0;
   }
 
   /** Destroy the unordered_map buckets */
@@ -339,6 +402,30 @@ class unordered_map : public ShmContainer {
     return emplace_templ<true, false>(key, std::forward<Args>(args)...);
   }
 
+  /**
+   * Emplace many (key, value) pairs. Overrides existing keys. The keys of
+   * each batch are hashed and their buckets prefetched before any is
+   * inserted, so cache misses overlap across keys.
+   *
+   * @param keys the keys to insert
+   * @param vals the values to insert
+   * @param n the number of keys and values
+   * */
+  template<typename ValT>
+  void emplace_batch(const Key *keys, const ValT *vals, size_t n) {
+    size_t hashes[prefetch_batch_];
+    for (size_t off = 0; off < n; off += prefetch_batch_) {
+      size_t count = n - off;
+      if (count > prefetch_batch_) {
+        count = prefetch_batch_;
+      }
+      prefetch_buckets(keys + off, count, hashes, nullptr);
+      for (size_t i = 0; i < count; ++i) {
+        emplace_hashed<true, true>(keys[off + i], hashes[i], vals[off + i]);
+      }
+    }
+  }
+
  private:
   /**
    * Insert a serialized (key, value) pair in the map
@@ -350,13 +437,24 @@ class unordered_map : public ShmContainer {
    * */
   template<bool growth, bool modify_existing, typename ...Args>
   HSHM_ALWAYS_INLINE bool emplace_templ(const Key &key, Args&& ...args) {
-    // Hash the key to a bucket
+    return emplace_hashed<growth, modify_existing>(
+      key, Hash{}(key), std::forward<Args>(args)...);
+  }
+
+  /** Insert a (key, value) pair whose key hashes to \a hash */
+  template<bool growth, bool modify_existing, typename ...Args>
+  HSHM_ALWAYS_INLINE bool emplace_hashed(const Key &key, size_t hash,
+                                         Args&& ...args) {
+    // Continue an unfinished rehash
+    rehash_step(rehash_batch_);
+
+    // Find the bucket of the key
     vector<BUCKET_T>& buckets = GetBuckets();
-    size_t bkt_id = Hash{}(key) % buckets.size();
+    size_t bkt_id = get_bucket_id(hash, buckets);
     BUCKET_T& bkt = (buckets)[bkt_id];
 
     // Insert into the map
-    auto has_key_iter = find_collision(key, bkt);
+    auto has_key_iter = find_collision(key, hash, bkt);
     if (!has_key_iter.is_end()) {
       if constexpr(!modify_existing) {
         return false;
@@ -365,15 +463,102 @@ class unordered_map : public ShmContainer {
         --length_;
       }
     }
-    bkt.emplace_back(PiecewiseConstruct(),
+    bkt.emplace_back(hash, PiecewiseConstruct(),
                      make_argpack(key),
                      make_argpack(std::forward<Args>(args)...));
 
     // Increment the size of the map
     ++length_;
+
+    // Grow the bucket vector if the map is too full
+    if constexpr(growth) {
+      grow_if_needed();
+    }
     return true;
   }
 
+  /**
+   * Get the bucket which holds (or will hold) a key with \a hash. During
+   * a rehash, keys from old buckets which have not been migrated yet remain
+   * in their old bucket.
+   * */
+  HSHM_ALWAYS_INLINE size_t get_bucket_id(size_t hash,
+                                          vector<BUCKET_T> &buckets) const {
+    if (old_num_buckets_ > 0) {
+      size_t old_bkt_id = hash % old_num_buckets_;
+      if (old_bkt_id >= rehash_pos_) {
+        return old_bkt_id;
+      }
+    }
+    return hash % buckets.size();
+  }
+
+  /** Grow the bucket vector if the load factor exceeds max_capacity_ */
+  void grow_if_needed() {
+    size_t num_buckets = get_num_buckets();
+    if (length_.load() <= (max_capacity_ * num_buckets).as_int()) {
+      return;
+    }
+    size_t new_num_buckets = (growth_ * num_buckets).as_int();
+    if (new_num_buckets <= num_buckets) {
+      new_num_buckets = num_buckets + 1;
+    }
+    rehash_templ(new_num_buckets, incremental_);
+  }
+
+  /**
+   * Grow the bucket vector to \a num_buckets buckets. Any unfinished
+   * rehash is completed first.
+   *
+   * @param num_buckets the new number of buckets
+   * @param incremental whether to leave the migration of old buckets to
+   * future modifications
+   * */
+  void rehash_templ(size_t num_buckets, bool incremental) {
+    rehash_step(old_num_buckets_);
+    vector<BUCKET_T>& buckets = GetBuckets();
+    size_t old_num_buckets = buckets.size();
+    if (num_buckets <= old_num_buckets) {
+      return;
+    }
+    buckets.resize(num_buckets);
+    old_num_buckets_ = old_num_buckets;
+    rehash_pos_ = 0;
+    if (!incremental) {
+      rehash_step(old_num_buckets_);
+    }
+  }
+
+  /**
+   * Migrate at most \a count old buckets of an unfinished rehash. Entries
+   * are relinked into their new bucket, so no (key, value) pair is copied.
+   * */
+  void rehash_step(size_t count) {
+    if (old_num_buckets_ == 0) {
+      return;
+    }
+    vector<BUCKET_T>& buckets = GetBuckets();
+    size_t num_buckets = buckets.size();
+    Allocator *alloc = GetAllocator();
+    for (; count > 0 && rehash_pos_ < old_num_buckets_;
+         --count, ++rehash_pos_) {
+      OffsetPointer entry_ptr = buckets[rehash_pos_].unlink_all();
+      while (!entry_ptr.IsNull()) {
+        auto entry = alloc->template
+          Convert<slist_entry<COLLISION_T>>(entry_ptr);
+        OffsetPointer next_ptr = entry->next_ptr_;
+        COLLISION_T &collision = entry->data_.get_ref();
+        size_t bkt_id = collision.hash_ % num_buckets;
+        buckets[bkt_id].link_front(entry_ptr, entry);
+        entry_ptr = next_ptr;
+      }
+    }
+    if (rehash_pos_ == old_num_buckets_) {
+      old_num_buckets_ = 0;
+      rehash_pos_ = 0;
+    }
+  }
+
  public:
   /**====================================
    * Erase Methods
@@ -383,13 +568,17 @@ class unordered_map : public ShmContainer {
    * Erase an object indexable by \a key key
    * */
   void erase(const Key &key) {
+    // Continue an unfinished rehash
+    rehash_step(rehash_batch_);
+
     // Get the bucket the key belongs to
     vector<BUCKET_T>& buckets = GetBuckets();
-    size_t bkt_id = Hash{}(key) % buckets.size();
+    size_t hash = Hash{}(key);
+    size_t bkt_id = get_bucket_id(hash, buckets);
     BUCKET_T& bkt = (buckets)[bkt_id];
 
     // Find and remove key from collision slist
-    auto iter = find_collision(key, bkt);
+    auto iter = find_collision(key, hash, bkt);
     if (iter.is_end()) {
       return;
     }
@@ -404,7 +593,7 @@ class unordered_map : public ShmContainer {
    * */
   void erase(iterator_t &iter) {
     if (iter == end()) return;
-    // Acquire the bucket lock for a write (modifying collisions)
+    // Get the bucket containing the entry
     BUCKET_T& bkt = *iter.bucket_;
 
     // Erase the element from the collision slist
@@ -422,7 +611,20 @@ class unordered_map : public ShmContainer {
     size_t num_buckets = buckets.size();
     buckets.clear();
     buckets.resize(num_buckets);
-    length_ = 0;
+    SetNull();
+  }
+
+  /**
+   * Grow the map to \a num_buckets buckets, migrating every entry
+   * immediately. Requests to shrink the map are ignored.
+   * */
+  void rehash(size_t num_buckets) {
+    rehash_templ(num_buckets, false);
+  }
+
+  /** Whether an incremental rehash is still migrating old buckets */
+  HSHM_ALWAYS_INLINE bool is_rehashing() const {
+    return old_num_buckets_ > 0;
   }
 
   /**====================================
@@ -449,26 +651,88 @@ class unordered_map : public ShmContainer {
 
     // Determine the bucket corresponding to the key
     vector<BUCKET_T>& buckets = GetBuckets();
-    size_t bkt_id = Hash{}(key) % buckets.size();
+    size_t hash = Hash{}(key);
+    size_t bkt_id = get_bucket_id(hash, buckets);
     iter.bucket_ = buckets.begin() + bkt_id;
     BUCKET_T& bkt = (*iter.bucket_);
 
     // Get the specific collision iterator
-    iter.collision_ = find_collision(key, bkt);
+    iter.collision_ = find_collision(key, hash, bkt);
     if (iter.collision_.is_end()) {
       iter.set_end();
     }
     return iter;
   }
 
-  /** Find a key in the collision slist */
+  /**
+   * Find many keys. The keys of each batch are hashed and their buckets
+   * prefetched, then the first entry of every bucket is prefetched, and
+   * only then are the collision chains walked. This overlaps the cache
+   * misses of different keys instead of serializing them.
+   *
+   * @param keys the keys to find
+   * @param n the number of keys
+   * @param out n iterators. Set to end() for keys which are not found.
+   * */
+  void find_batch(const Key *keys, size_t n, iterator_t *out) {
+    size_t hashes[prefetch_batch_];
+    BUCKET_T *bkts[prefetch_batch_];
+    vector<BUCKET_T>& buckets = GetBuckets();
+    for (size_t off = 0; off < n; off += prefetch_batch_) {
+      size_t count = n - off;
+      if (count > prefetch_batch_) {
+        count = prefetch_batch_;
+      }
+      prefetch_buckets(keys + off, count, hashes, bkts);
+      for (size_t i = 0; i < count; ++i) {
+        BUCKET_T &bkt = *bkts[i];
+        if (bkt.size() > 0) {
+          __builtin_prefetch(GetAllocator()->template
+            Convert<slist_entry<COLLISION_T>>(bkt.head_ptr_));
+        }
+      }
+      for (size_t i = 0; i < count; ++i) {
+        iterator_t &iter = out[off + i];
+        iter = iterator_t(*this,
+                          buckets.begin() + (bkts[i] - &buckets[0]),
+                          find_collision(keys[off + i], hashes[i], *bkts[i]));
+        if (iter.collision_.is_end()) {
+          iter.set_end();
+        }
+      }
+    }
+  }
+
+  /**
+   * Hash \a count keys and prefetch their buckets
+   *
+   * @param keys the keys to hash
+   * @param count the number of keys (at most prefetch_batch_)
+   * @param hashes the output hash of each key
+   * @param bkts the output bucket of each key. May be null.
+   * */
+  HSHM_ALWAYS_INLINE void prefetch_buckets(const Key *keys, size_t count,
+                                           size_t *hashes, BUCKET_T **bkts) {
+    vector<BUCKET_T>& buckets = GetBuckets();
+    for (size_t i = 0; i < count; ++i) {
+      hashes[i] = Hash{}(keys[i]);
+      BUCKET_T *bkt = &buckets[get_bucket_id(hashes[i], buckets)];
+      __builtin_prefetch(bkt);
+      if (bkts) {
+        bkts[i] = bkt;
+      }
+    }
+  }
+
+  /** Find a key with \a hash in the collision slist */
   typename BUCKET_T::iterator_t
-  HSHM_ALWAYS_INLINE find_collision(const Key &key, BUCKET_T &bkt) {
+  HSHM_ALWAYS_INLINE find_collision(const Key &key, size_t hash,
+                                    BUCKET_T &bkt) {
     auto iter = bkt.begin();
     auto iter_end = bkt.end();
     for (; iter != iter_end; ++iter) {
       COLLISION_T &collision = *iter;
-      if (collision.GetKey() == key) {
+      if (collision.hash_ == hash && collision.GetKey() == key) {
         return iter;
       }
     }
@@ -0,0 +1,602 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HERMES_DATA_STRUCTURES_UNROLLED_LIST_H_
+#define HERMES_DATA_STRUCTURES_UNROLLED_LIST_H_
+
+#include "hermes_shm/data_structures/ipc/internal/shm_internal.h"
+#include "hermes_shm/data_structures/containers/functional.h"
+#include "hermes_shm/data_structures/serialization/serialize_common.h"
+
+#include <list>
+
+namespace hshm::ipc {
+
+/** forward pointer for unrolled_list */
+template<typename T, size_t NODE_SIZE = 256>
+class unrolled_list;
+
+/**
+ * A node of an unrolled_list. The live elements of a node are always the
+ * contiguous range [begin_, end_) of data_.
+ * */
+template<typename T, size_t CAP>
+struct unrolled_list_node {
+  OffsetPointer next_ptr_, prior_ptr_;
+  uint32_t begin_;  /**< The first live element */
+  uint32_t end_;    /**< One past the last live element */
+  ShmArchive<T> data_[CAP];
+
+  /** The number of live elements in this node */
+  HSHM_ALWAYS_INLINE size_t size() const {
+    return end_ - begin_;
+  }
+};
+
+/**
+ * The unrolled_list iterator
+ * */
+template<typename T, size_t NODE_SIZE>
+struct unrolled_list_iterator_templ {
+ public:
+  typedef unrolled_list<T, NODE_SIZE> LIST_T;
+  typedef typename LIST_T::NODE_T NODE_T;
+
+  /**< The containing list */
+  LIST_T *list_;
+  /**< The current node. Null for the end iterator. */
+  NODE_T *node_;
+  /**< The offset of the current node */
+  OffsetPointer node_ptr_;
+  /**< The index of the element within the node */
+  uint32_t i_;
+
+  /** Default constructor */
+  unrolled_list_iterator_templ() = default;
+
+  /** Construct an iterator */
+  explicit unrolled_list_iterator_templ(LIST_T &list, NODE_T *node,
+                                        OffsetPointer node_ptr, uint32_t i)
+  : list_(&list), node_(node), node_ptr_(node_ptr), i_(i) {}
+
+  /** Get the object the iterator points to */
+  HSHM_ALWAYS_INLINE T& operator*() {
+    return node_->data_[i_].get_ref();
+  }
+
+  /** Get the object the iterator points to */
+  HSHM_ALWAYS_INLINE const T& operator*() const {
+    return node_->data_[i_].get_ref();
+  }
+
+  /** Get the next iterator (in place) */
+  HSHM_ALWAYS_INLINE unrolled_list_iterator_templ& operator++() {
+    if (is_end()) { return *this; }
+    if (++i_ == node_->end_) {
+      Goto(node_->next_ptr_, true);
+    }
+    return *this;
+  }
+
+  /** Get the prior iterator (in place) */
+  HSHM_ALWAYS_INLINE unrolled_list_iterator_templ& operator--() {
+    if (is_end() || is_begin()) { return *this; }
+    if (i_ == node_->begin_) {
+      Goto(node_->prior_ptr_, false);
+    } else {
+      --i_;
+    }
+    return *this;
+  }
+
+  /** Return the next iterator */
+  unrolled_list_iterator_templ operator++(int) const {
+    unrolled_list_iterator_templ next_iter(*this);
+    ++next_iter;
+    return next_iter;
+  }
+
+  /** Return the prior iterator */
+  unrolled_list_iterator_templ operator--(int) const {
+    unrolled_list_iterator_templ prior_iter(*this);
+    --prior_iter;
+    return prior_iter;
+  }
+
+  /** Return the iterator at count after this one. Skips whole nodes. */
+  unrolled_list_iterator_templ operator+(size_t count) const {
+    unrolled_list_iterator_templ pos(*this);
+    pos += count;
+    return pos;
+  }
+
+  /** Get the iterator at count after this one (in-place) */
+  void operator+=(size_t count) {
+    while (!is_end() && count >= node_->end_ - i_) {
+      count -= node_->end_ - i_;
+      Goto(node_->next_ptr_, true);
+    }
+    if (!is_end()) {
+      i_ += static_cast<uint32_t>(count);
+    }
+  }
+
+  /** Determine if two iterators are equal */
+  friend bool operator==(const unrolled_list_iterator_templ &a,
+                         const unrolled_list_iterator_templ &b) {
+    return (a.is_end() && b.is_end()) ||
+      (a.node_ == b.node_ && a.i_ == b.i_);
+  }
+
+  /** Determine if two iterators are inequal */
+  friend bool operator!=(const unrolled_list_iterator_templ &a,
+                         const unrolled_list_iterator_templ &b) {
+    return !(a == b);
+  }
+
+  /** Determine whether this iterator is the end iterator */
+  HSHM_ALWAYS_INLINE bool is_end() const {
+    return node_ == nullptr;
+  }
+
+  /** Determine whether this iterator is the begin iterator */
+  bool is_begin() const {
+    if (node_) {
+      return node_->prior_ptr_.IsNull() && i_ == node_->begin_;
+    } else {
+      return false;
+    }
+  }
+
+ private:
+  /** Move to the first (or last) element of another node */
+  HSHM_ALWAYS_INLINE void Goto(OffsetPointer node_ptr, bool first) {
+    node_ptr_ = node_ptr;
+    if (node_ptr.IsNull()) {
+      node_ = nullptr;
+      i_ = 0;
+      return;
+    }
+    node_ = list_->GetAllocator()->template Convert<NODE_T>(node_ptr);
+    i_ = first ? node_->begin_ : node_->end_ - 1;
+  }
+};
+
+/**
+ * MACROS used to simplify the unrolled_list namespace
+ * Used as inputs to the SHM_CONTAINER_TEMPLATE
+ * */
+#define CLASS_NAME unrolled_list
+#define TYPED_CLASS unrolled_list<T, NODE_SIZE>
+#define TYPED_HEADER ShmHeader<unrolled_list<T, NODE_SIZE>>
+
+/**
+ * A doubly linked list which packs several elements into each node.
+ * Iteration touches one node per NODE_SIZE bytes of elements instead of
+ * one node per element, and pushing or popping at either end is O(1).
+ * Erasing in the middle shifts the remainder of a single node.
+ * */
+template<typename T, size_t NODE_SIZE>
+class unrolled_list : public ShmContainer {
+ public:
+  SHM_CONTAINER_TEMPLATE((CLASS_NAME), (TYPED_CLASS))
+
+  /**====================================
+   * Node capacity
+   * ===================================*/
+  /** The number of elements per node */
+  static const size_t node_cap_ =
+    (NODE_SIZE - 2 * sizeof(OffsetPointer) - 2 * sizeof(uint32_t)) /
+    sizeof(ShmArchive<T>) < 1 ? 1 :
+    (NODE_SIZE - 2 * sizeof(OffsetPointer) - 2 * sizeof(uint32_t)) /
+    sizeof(ShmArchive<T>);
+
+  /**====================================
+   * Typedefs
+   * ===================================*/
+  typedef unrolled_list_node<T, node_cap_> NODE_T;
+  /** forward iterator typedef */
+  typedef unrolled_list_iterator_templ<T, NODE_SIZE> iterator_t;
+  /** const forward iterator typedef */
+  typedef unrolled_list_iterator_templ<T, NODE_SIZE> citerator_t;
+
+  /**====================================
+   * Variables
+   * ===================================*/
+  OffsetPointer head_ptr_, tail_ptr_;
+  size_t length_;
+
+ public:
+  /**====================================
+   * Default Constructor
+   * ===================================*/
+
+  /** SHM constructor. Default. */
+  explicit unrolled_list(Allocator *alloc) {
+    shm_init_container(alloc);
+    SetNull();
+  }
+
+  /**====================================
+   * Copy Constructors
+   * ===================================*/
+
+  /** SHM copy constructor */
+  explicit unrolled_list(Allocator *alloc, const unrolled_list &other) {
+    shm_init_container(alloc);
+    SetNull();
+    shm_strong_copy_construct_and_op<unrolled_list>(other);
+  }
+
+  /** SHM copy assignment operator */
+  unrolled_list& operator=(const unrolled_list &other) {
+    if (this != &other) {
+      shm_destroy();
+      shm_strong_copy_construct_and_op<unrolled_list>(other);
+    }
+    return *this;
+  }
+
+  /** SHM copy constructor. From std::list */
+  explicit unrolled_list(Allocator *alloc, std::list<T> &other) {
+    shm_init_container(alloc);
+    SetNull();
+    shm_strong_copy_construct_and_op<std::list<T>>(other);
+  }
+
+  /** SHM copy assignment operator. From std::list. */
+  unrolled_list& operator=(const std::list<T> &other) {
+    shm_destroy();
+    shm_strong_copy_construct_and_op<std::list<T>>(other);
+    return *this;
+  }
+
+  /** SHM copy constructor + operator main */
+  template<typename ListT>
+  void shm_strong_copy_construct_and_op(const ListT &other) {
+    for (auto iter = other.cbegin(); iter != other.cend(); ++iter) {
+      emplace_back(*iter);
+    }
+  }
+
+  /**====================================
+   * Move Constructors
+   * ===================================*/
+
+  /** SHM move constructor. */
+  unrolled_list(Allocator *alloc, unrolled_list &&other) noexcept {
+    shm_init_container(alloc);
+    if (GetAllocator() == other.GetAllocator()) {
+      memcpy((void*) this, (void *) &other, sizeof(*this));
+      other.SetNull();
+    } else {
+      shm_strong_copy_construct_and_op<unrolled_list>(other);
+      other.shm_destroy();
+    }
+  }
+
+  /** SHM move assignment operator. */
+  unrolled_list& operator=(unrolled_list &&other) noexcept {
+    if (this != &other) {
+      shm_destroy();
+      if (GetAllocator() == other.GetAllocator()) {
+        memcpy((void *) this, (void *) &other, sizeof(*this));
+        other.SetNull();
+      } else {
+        shm_strong_copy_construct_and_op<unrolled_list>(other);
+        other.shm_destroy();
+      }
+    }
+    return *this;
+  }
+
+  /**====================================
+   * Destructor
+   * ===================================*/
+
+  /** SHM destructor.  */
+  void shm_destroy_main() {
+    clear();
+  }
+
+  /** Check if the list is empty */
+  bool IsNull() const {
+    return length_ == 0;
+  }
+
+  /** Sets this list as empty */
+  void SetNull() {
+    length_ = 0;
+    head_ptr_.SetNull();
+    tail_ptr_.SetNull();
+  }
+
+  /**====================================
+   * unrolled_list Methods
+   * ===================================*/
+
+  /** Construct an element at the back of the list */
+  template<typename... Args>
+  void emplace_back(Args&&... args) {
+    NODE_T *tail = nullptr;
+    if (!tail_ptr_.IsNull()) {
+      tail = GetAllocator()->template Convert<NODE_T>(tail_ptr_);
+    }
+    if (tail == nullptr || tail->end_ == node_cap_) {
+      tail = _link_node(tail_ptr_, tail, 0, true);
+    }
+    HSHM_MAKE_AR(tail->data_[tail->end_], GetAllocator(),
+                 std::forward<Args>(args)...)
+    ++tail->end_;
+    ++length_;
+  }
+
+  /** Construct an element at the front of the list */
+  template<typename... Args>
+  void emplace_front(Args&&... args) {
+    NODE_T *head = nullptr;
+    if (!head_ptr_.IsNull()) {
+      head = GetAllocator()->template Convert<NODE_T>(head_ptr_);
+    }
+    if (head == nullptr || head->begin_ == 0) {
+      head = _link_node(head_ptr_, head, node_cap_, false);
+    }
+    HSHM_MAKE_AR(head->data_[head->begin_ - 1], GetAllocator(),
+                 std::forward<Args>(args)...)
+    --head->begin_;
+    ++length_;
+  }
+
+  /** Destroy the element at the front of the list */
+  void pop_front() {
+    if (length_ == 0) { return; }
+    auto head = GetAllocator()->template Convert<NODE_T>(head_ptr_);
+    HSHM_DESTROY_AR(head->data_[head->begin_])
+    ++head->begin_;
+    --length_;
+    if (head->size() == 0) {
+      _unlink_node(head_ptr_, head);
+    }
+  }
+
+  /** Destroy the element at the back of the list */
+  void pop_back() {
+    if (length_ == 0) { return; }
+    auto tail = GetAllocator()->template Convert<NODE_T>(tail_ptr_);
+    --tail->end_;
+    HSHM_DESTROY_AR(tail->data_[tail->end_])
+    --length_;
+    if (tail->size() == 0) {
+      _unlink_node(tail_ptr_, tail);
+    }
+  }
+
+  /**
+   * Erase the element at pos. Shifts the shorter side of pos's node.
+   *
+   * @return an iterator to the element following pos
+   * */
+  iterator_t erase(iterator_t pos) {
+    if (pos.is_end()) { return pos; }
+    NODE_T *node = pos.node_;
+    HSHM_DESTROY_AR(node->data_[pos.i_])
+    --length_;
+    if (pos.i_ - node->begin_ < node->end_ - pos.i_ - 1) {
+      // Shift the front half of the node right
+      _move_range(node, node->begin_ + 1, node->begin_,
+                  pos.i_ - node->begin_);
+      ++node->begin_;
+      ++pos.i_;
+    } else {
+      // Shift the back half of the node left
+      _move_range(node, pos.i_, pos.i_ + 1, node->end_ - pos.i_ - 1);
+      --node->end_;
+    }
+    if (node->size() == 0) {
+      OffsetPointer next_ptr = node->next_ptr_;
+      _unlink_node(pos.node_ptr_, node);
+      return _node_begin(next_ptr);
+    }
+    if (pos.i_ == node->end_) {
+      return _node_begin(node->next_ptr_);
+    }
+    return pos;
+  }
+
+  /** Erase all elements between first and last */
+  iterator_t erase(iterator_t first, iterator_t last) {
+    size_t count = 0;
+    for (auto iter = first; iter != last; ++iter) {
+      ++count;
+    }
+    for (; count > 0; --count) {
+      first = erase(first);
+    }
+    return first;
+  }
+
+  /** Erase element with ID */
+  void erase(const T &entry) {
+    erase(find(entry));
+  }
+
+  /** Destroy all elements in the list */
+  void clear() {
+    OffsetPointer node_ptr = head_ptr_;
+    while (!node_ptr.IsNull()) {
+      auto node = GetAllocator()->template Convert<NODE_T>(node_ptr);
+      for (uint32_t i = node->begin_; i < node->end_; ++i) {
+        HSHM_DESTROY_AR(node->data_[i])
+      }
+      OffsetPointer next_ptr = node->next_ptr_;
+      GetAllocator()->Free(node_ptr);
+      node_ptr = next_ptr;
+    }
+    SetNull();
+  }
+
+  /** Get the object at the front of the list */
+  HSHM_ALWAYS_INLINE T& front() {
+    return *begin();
+  }
+
+  /** Get the object at the back of the list */
+  HSHM_ALWAYS_INLINE T& back() {
+    return *last();
+  }
+
+  /** Get the number of elements in the list */
+  HSHM_ALWAYS_INLINE size_t size() const {
+    return length_;
+  }
+
+  /** Find an element in this list */
+  iterator_t find(const T &entry) {
+    return hshm::find(begin(), end(), entry);
+  }
+
+  /**====================================
+   * Iterators
+   * ===================================*/
+
+  /** Forward iterator begin */
+  HSHM_ALWAYS_INLINE iterator_t begin() {
+    return _node_begin(head_ptr_);
+  }
+
+  /** Last iterator begin */
+  iterator_t last() {
+    if (size() == 0) { return end(); }
+    auto tail = GetAllocator()->template Convert<NODE_T>(tail_ptr_);
+    return iterator_t(*this, tail, tail_ptr_, tail->end_ - 1);
+  }
+
+  /** Forward iterator end */
+  HSHM_ALWAYS_INLINE iterator_t end() {
+    return iterator_t(*this, nullptr, OffsetPointer::GetNull(), 0);
+  }
+
+  /** Constant forward iterator begin */
+  HSHM_ALWAYS_INLINE citerator_t cbegin() const {
+    return const_cast<unrolled_list*>(this)->begin();
+  }
+
+  /** Constant forward iterator end */
+  HSHM_ALWAYS_INLINE citerator_t cend() const {
+    return const_cast<unrolled_list*>(this)->end();
+  }
+
+  /**====================================
+  * Serialization
+  * ===================================*/
+
+  /** Serialize */
+  template <typename Ar>
+  void save(Ar &ar) const {
+    save_list<Ar, unrolled_list, T>(ar, *this);
+  }
+
+  /** Deserialize */
+  template <typename Ar>
+  void load(Ar &ar) {
+    load_list<Ar, unrolled_list, T>(ar, *this);
+  }
+
+ private:
+  /** The iterator at the first element of a node */
+  HSHM_ALWAYS_INLINE iterator_t _node_begin(OffsetPointer node_ptr) {
+    if (node_ptr.IsNull()) { return end(); }
+    auto node = GetAllocator()->template Convert<NODE_T>(node_ptr);
+    return iterator_t(*this, node, node_ptr, node->begin_);
+  }
+
+  /**
+   * Move count live elements of a node from src to the free slots at dst.
+   * The ranges may overlap.
+   * */
+  void _move_range(NODE_T *node, uint32_t dst, uint32_t src,
+                   uint32_t count) {
+    if constexpr(is_trivially_relocatable_v<T>) {
+      memmove((void*)(node->data_ + dst), (void*)(node->data_ + src),
+              count * sizeof(ShmArchive<T>));
+    } else if (dst < src) {
+      for (uint32_t i = 0; i < count; ++i) {
+        HSHM_MAKE_AR(node->data_[dst + i], GetAllocator(),
+                     std::move(node->data_[src + i].get_ref()))
+        HSHM_DESTROY_AR(node->data_[src + i])
+      }
+    } else {
+      for (uint32_t i = count; i > 0; --i) {
+        HSHM_MAKE_AR(node->data_[dst + i - 1], GetAllocator(),
+                     std::move(node->data_[src + i - 1].get_ref()))
+        HSHM_DESTROY_AR(node->data_[src + i - 1])
+      }
+    }
+  }
+
+  /**
+   * Allocate an empty node and link it after the tail or before the head.
+   *
+   * @param end_ptr head_ptr_ or tail_ptr_
+   * @param end_node the node at end_ptr, or null if the list is empty
+   * @param off where the empty range of the new node begins
+   * @param back whether to link the node after the tail
+   * */
+  NODE_T* _link_node(OffsetPointer &end_ptr, NODE_T *end_node,
+                     uint32_t off, bool back) {
+    OffsetPointer node_ptr;
+    auto node = GetAllocator()->template AllocateObjs<NODE_T>(1, node_ptr);
+    node->begin_ = off;
+    node->end_ = off;
+    node->next_ptr_.SetNull();
+    node->prior_ptr_.SetNull();
+    if (end_node == nullptr) {
+      head_ptr_ = node_ptr;
+      tail_ptr_ = node_ptr;
+      return node;
+    }
+    if (back) {
+      node->prior_ptr_ = end_ptr;
+      end_node->next_ptr_ = node_ptr;
+    } else {
+      node->next_ptr_ = end_ptr;
+      end_node->prior_ptr_ = node_ptr;
+    }
+    end_ptr = node_ptr;
+    return node;
+  }
+
+  /** Unlink an empty node from the list and free it */
+  void _unlink_node(OffsetPointer node_ptr, NODE_T *node) {
+    if (node->prior_ptr_.IsNull()) {
+      head_ptr_ = node->next_ptr_;
+    } else {
+      GetAllocator()->template Convert<NODE_T>(node->prior_ptr_)
+        ->next_ptr_ = node->next_ptr_;
+    }
+    if (node->next_ptr_.IsNull()) {
+      tail_ptr_ = node->prior_ptr_;
+    } else {
+      GetAllocator()->template Convert<NODE_T>(node->next_ptr_)
+        ->prior_ptr_ = node->prior_ptr_;
+    }
+    GetAllocator()->Free(node_ptr);
+  }
+};
+
+}  // namespace hshm::ipc
+
+#undef CLASS_NAME
+#undef TYPED_CLASS
+#undef TYPED_HEADER
+
+#endif  // HERMES_DATA_STRUCTURES_UNROLLED_LIST_H_
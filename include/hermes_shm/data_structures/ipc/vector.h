@@ -17,21 +17,42 @@
 #include "hermes_shm/data_structures/ipc/internal/shm_internal.h"
 #include "hermes_shm/data_structures/serialization/serialize_common.h"
 
+#include <iterator>
 #include <vector>
 
 namespace hshm::ipc {
 
+/**
+ * Whether InputIt can only be traversed once. The hipc iterators have no
+ * iterator_traits, but they can all be copied and walked more than once.
+ * */
+template<typename InputIt, typename = void>
+struct is_single_pass_iter : std::false_type {};
+
+/** Iterators with traits are single-pass unless they are forward */
+template<typename InputIt>
+struct is_single_pass_iter<InputIt, std::void_t<
+  typename std::iterator_traits<InputIt>::iterator_category>>
+  : std::integral_constant<bool, !std::is_base_of_v<
+      std::forward_iterator_tag,
+      typename std::iterator_traits<InputIt>::iterator_category>> {};
+
+/** Shorthand for is_single_pass_iter<InputIt>::value */
+template<typename InputIt>
+inline constexpr bool is_single_pass_iter_v =
+  is_single_pass_iter<InputIt>::value;
+
 /** forward pointer for vector */
-template<typename T>
+template<typename T, bool PRIVATE = false>
 class vector;
 
 /**
  * The vector iterator implementation
  * */
-template<typename T, bool FORWARD_ITER>
+template<typename T, bool FORWARD_ITER, bool PRIVATE>
 struct vector_iterator_templ {
  public:
-  vector<T> *vec_;
+  vector<T, PRIVATE> *vec_;
   off64_t i_;
 
   /** Default constructor */
@@ -39,11 +60,13 @@ struct vector_iterator_templ {
 
   /** Construct an iterator (called from vector class) */
   template<typename SizeT>
-  HSHM_ALWAYS_INLINE explicit vector_iterator_templ(vector<T> *vec, SizeT i)
+  HSHM_ALWAYS_INLINE explicit vector_iterator_templ(vector<T, PRIVATE> *vec,
+                                                    SizeT i)
   : vec_(vec), i_(static_cast<off64_t>(i)) {}
 
   /** Construct an iterator (called from iterator) */
-  HSHM_ALWAYS_INLINE explicit vector_iterator_templ(vector<T> *vec, off64_t i)
+  HSHM_ALWAYS_INLINE explicit vector_iterator_templ(vector<T, PRIVATE> *vec,
+                                                    off64_t i)
   : vec_(vec), i_(i) {}
 
   /** Copy constructor */
@@ -211,16 +234,17 @@ struct vector_iterator_templ {
  * Used as inputs to the SHM_CONTAINER_TEMPLATE
  * */
 #define CLASS_NAME vector
-#define TYPED_CLASS vector<T>
-#define TYPED_HEADER ShmHeader<vector<T>>
+#define TYPED_CLASS vector<T, PRIVATE>
+#define TYPED_HEADER ShmHeader<vector<T, PRIVATE>>
 
 /**
- * The vector class
+ * The vector class. A PRIVATE vector lives in process memory and
+ * stores native pointers (see ShmAllocRef).
  * */
-template<typename T>
+template<typename T, bool PRIVATE>
 class vector : public ShmContainer {
  public:
-  SHM_CONTAINER_TEMPLATE((CLASS_NAME), (TYPED_CLASS))
+  SHM_CONTAINER_PRIVATE_TEMPLATE((CLASS_NAME), (TYPED_CLASS), (PRIVATE))
 
  public:
   /**====================================
@@ -228,13 +252,13 @@ class vector : public ShmContainer {
    * ===================================*/
 
   /** forwrard iterator */
-  typedef vector_iterator_templ<T, true>  iterator_t;
+  typedef vector_iterator_templ<T, true, PRIVATE>  iterator_t;
   /** reverse iterator */
-  typedef vector_iterator_templ<T, false> riterator_t;
+  typedef vector_iterator_templ<T, false, PRIVATE> riterator_t;
   /** const iterator */
-  typedef vector_iterator_templ<T, true>  citerator_t;
+  typedef vector_iterator_templ<T, true, PRIVATE>  citerator_t;
   /** const reverse iterator */
-  typedef vector_iterator_templ<T, false> criterator_t;
+  typedef vector_iterator_templ<T, false, PRIVATE> criterator_t;
 
  public:
   /**====================================
@@ -270,7 +294,7 @@ class vector : public ShmContainer {
   explicit vector(Allocator *alloc, const vector &other) {
     shm_init_container(alloc);
     SetNull();
-    shm_strong_copy_main<vector<T>>(other);
+    shm_strong_copy_main<vector>(other);
   }
 
   /** SHM copy assignment operator. From vector. */
@@ -481,6 +505,71 @@ class vector : public ShmContainer {
                  std::forward<Args>(args)...)
   }
 
+  /**
+   * Insert the elements in [first, last) before \a pos. The vector grows
+   * at most once and POD elements from a contiguous range of T are
+   * memcpy'd. Single-pass input ranges are emplaced one at a time.
+   * The source range must not alias *this, since growing and shifting
+   * the vector invalidates its iterators.
+   *
+   * @param pos the position to insert before
+   * @param first the beginning of the range to copy
+   * @param last the end of the range to copy
+   * */
+  template<typename InputIt>
+  void insert(iterator_t pos, InputIt first, InputIt last) {
+    size_t off = pos.is_end() ? size() : static_cast<size_t>(pos.i_);
+    if constexpr(is_single_pass_iter_v<InputIt>) {
+      for (; first != last; ++first, ++off) {
+        emplace(iterator_t(this, off), *first);
+      }
+      return;
+    } else {
+      size_t count = 0;
+      if constexpr(std::is_pointer_v<InputIt>) {
+        count = static_cast<size_t>(last - first);
+      } else {
+        for (InputIt it = first; it != last; ++it) {
+          ++count;
+        }
+      }
+      if (count == 0) {
+        return;
+      }
+      grow_to_fit(count);
+      shift_right(iterator_t(this, off), count);
+      ShmArchive<T> *vec = data_ar();
+      if constexpr(std::is_pod<T>() && !IS_SHM_ARCHIVEABLE(T) &&
+                   std::is_pointer_v<InputIt> &&
+                   std::is_same_v<
+                     std::remove_cv_t<std::remove_pointer_t<InputIt>>, T>) {
+        memcpy((void*)(vec + off), (void*)first, count * sizeof(T));
+      } else {
+        for (size_t i = off; first != last; ++first, ++i) {
+          HSHM_MAKE_AR(vec[i], GetAllocator(), *first)
+        }
+      }
+      length_ += count;
+    }
+  }
+
+  /** Copy \a count elements from a C-style array to the back of the vector */
+  HSHM_ALWAYS_INLINE void append(const T *first, size_t count) {
+    insert(end(), first, first + count);
+  }
+
+  /** Replace the contents of the vector with the range [first, last) */
+  template<typename InputIt>
+  HSHM_ALWAYS_INLINE void assign(InputIt first, InputIt last) {
+    clear();
+    insert(end(), first, last);
+  }
+
+  /** Replace the contents of the vector with a C-style array */
+  HSHM_ALWAYS_INLINE void assign(const T *first, size_t count) {
+    assign(first, first + count);
+  }
+
   /** Delete the element at \a pos position */
   HSHM_ALWAYS_INLINE void erase(iterator_t pos) {
     if (pos.is_end()) return;
@@ -526,12 +615,12 @@ class vector : public ShmContainer {
 
   /** Retreives a pointer to the internal array */
   HSHM_ALWAYS_INLINE ShmArchive<T>* data_ar() {
-    return GetAllocator()->template Convert<ShmArchive<T>>(vec_ptr_);
+    return ConvertPtr<ShmArchive<T>>(vec_ptr_);
   }
 
   /** Retreives a pointer to the array */
   HSHM_ALWAYS_INLINE ShmArchive<T>* data_ar() const {
-    return GetAllocator()->template Convert<ShmArchive<T>>(vec_ptr_);
+    return ConvertPtr<ShmArchive<T>>(vec_ptr_);
   }
 
   /**====================================
@@ -562,8 +651,8 @@ class vector : public ShmContainer {
 
     // Allocate new shared-memory vec
     ShmArchive<T> *new_vec;
-    if constexpr(std::is_pod<T>() && !IS_SHM_ARCHIVEABLE(T)) {
-      // Use reallocate for well-behaved objects
+    if constexpr(is_trivially_relocatable_v<T>) {
+      // Use reallocate for objects which can be moved by copying bytes
       new_vec = GetAllocator()->template
         ReallocateObjs<ShmArchive<T>>(vec_ptr_, max_length);
     } else {
@@ -575,6 +664,7 @@ class vector : public ShmContainer {
         T& old_entry = (*this)[i];
         HSHM_MAKE_AR(new_vec[i], GetAllocator(),
                      std::move(old_entry))
+        HSHM_DESTROY_AR(vec[i])
       }
       if (!vec_ptr_.IsNull()) {
         GetAllocator()->Free(vec_ptr_);
@@ -598,6 +688,21 @@ class vector : public ShmContainer {
     return new_vec;
   }
 
+  /**
+   * Make room for \a count more elements with a single growth. Grows by
+   * at least 25% so repeated bulk appends stay amortized.
+   *
+   * @param count the number of elements about to be added
+   * */
+  HSHM_ALWAYS_INLINE void grow_to_fit(size_t count) {
+    size_t need = length_ + count;
+    if (need <= max_length_) {
+      return;
+    }
+    size_t max_length = 5 * max_length_ / 4;
+    grow_vector(data_ar(), need < max_length ? max_length : need, false);
+  }
+
   /**
    * Shift every element starting at "pos" to the left by count. Any element
    * who would be shifted before "pos" will be deleted.
@@ -610,11 +715,15 @@ class vector : public ShmContainer {
     for (size_t i = 0; i < count; ++i) {
       HSHM_DESTROY_AR(vec[pos.i_ + i])
     }
-    auto dst = vec + pos.i_;
-    auto src = dst + count;
-    for (auto i = pos.i_ + count; i < size(); ++i) {
-      memcpy((void*)dst, (void*)src, sizeof(ShmArchive<T>));
-      dst += 1; src += 1;
+    if constexpr(is_trivially_relocatable_v<T>) {
+      memmove((void*)(vec + pos.i_), (void*)(vec + pos.i_ + count),
+              (size() - pos.i_ - count) * sizeof(ShmArchive<T>));
+    } else {
+      for (size_t i = pos.i_ + count; i < size(); ++i) {
+        HSHM_MAKE_AR(vec[i - count], GetAllocator(),
+                     std::move(vec[i].get_ref()))
+        HSHM_DESTROY_AR(vec[i])
+      }
     }
   }
 
@@ -627,12 +736,17 @@ class vector : public ShmContainer {
    * @param count the amount to shift right by
    * */
   HSHM_ALWAYS_INLINE void shift_right(const iterator_t pos, size_t count = 1) {
-    auto src = data_ar() + size() - 1;
-    auto dst = src + count;
-    auto sz = static_cast<off64_t>(size());
-    for (auto i = sz - 1; i >= pos.i_; --i) {
-      memcpy((void*)dst, (void*)src, sizeof(ShmArchive<T>));
-      dst -= 1; src -= 1;
+    ShmArchive<T> *vec = data_ar();
+    if constexpr(is_trivially_relocatable_v<T>) {
+      memmove((void*)(vec + pos.i_ + count), (void*)(vec + pos.i_),
+              (size() - pos.i_) * sizeof(ShmArchive<T>));
+    } else {
+      auto sz = static_cast<off64_t>(size());
+      for (auto i = sz - 1; i >= pos.i_; --i) {
+        HSHM_MAKE_AR(vec[i + count], GetAllocator(),
+                     std::move(vec[i].get_ref()))
+        HSHM_DESTROY_AR(vec[i])
+      }
     }
   }
 
@@ -683,18 +797,26 @@ class vector : public ShmContainer {
   /** Lets Thallium know how to serialize an hipc::vector. */
   template <typename Ar>
   void save(Ar &ar) const {
-    save_vec<Ar, hipc::vector<T>, T>(ar, *this);
+    save_vec<Ar, vector, T>(ar, *this);
   }
 
   /** Lets Thallium know how to deserialize an hipc::vector. */
   template <typename Ar>
   void load(Ar &ar) {
-    load_vec<Ar, hipc::vector<T>, T>(ar, *this);
+    load_vec<Ar, vector, T>(ar, *this);
   }
 };
 
 }  // namespace hshm::ipc
 
+namespace hshm {
+
+/** A vector in private memory */
+template<typename T>
+using vector = ipc::vector<T, true>;
+
+}  // namespace hshm
+
 #undef CLASS_NAME
 #undef TYPED_CLASS
 #undef TYPED_HEADER
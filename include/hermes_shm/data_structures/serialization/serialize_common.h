@@ -14,6 +14,8 @@
 #define HERMES_SHM_SERIALIZE_COMMON_H_
 
 #include <stddef.h>
+#include <algorithm>
+#include <type_traits>
 #include <cereal/archives/binary.hpp>
 
 template<typename Ar, typename T>
@@ -58,10 +60,31 @@ template <typename Ar, typename ContainerT, typename T>
 void load_vec(Ar &ar, ContainerT &obj) {
   size_t size;
   ar >> size;
-  obj.resize(size);
-  if constexpr(std::is_same_v<char, T>) {
-    read_binary(ar, (char*)obj.data(), obj.size() * sizeof(T));
+  if constexpr(std::is_same_v<char, T> ||
+               (std::is_arithmetic_v<T> &&
+                std::is_same_v<Ar, cereal::BinaryInputArchive>)) {
+    // The elements are stored as raw bytes, so read them in place
+    obj.clear();
+    obj.resize(size);
+    read_binary(ar, (char*)obj.data(), size * sizeof(T));
+  } else if constexpr(std::is_trivially_copyable_v<T> &&
+                      std::is_default_constructible_v<T> &&
+                      sizeof(T) <= 4096) {
+    // Stage POD elements in a small buffer and bulk-insert them, so the
+    // container grows once and never default-constructs the elements
+    constexpr size_t chunk_size = 4096 / sizeof(T);
+    T buf[chunk_size];
+    obj.clear();
+    obj.reserve(size);
+    for (size_t i = 0; i < size; i += chunk_size) {
+      size_t count = std::min(chunk_size, size - i);
+      for (size_t j = 0; j < count; ++j) {
+        ar >> buf[j];
+      }
+      obj.insert(obj.end(), buf, buf + count);
+    }
   } else {
+    obj.resize(size);
     for (size_t i = 0; i < size; ++i) {
       ar >> (obj[i]);
     }
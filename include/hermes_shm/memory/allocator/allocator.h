@@ -14,8 +14,12 @@
 #define HERMES_MEMORY_ALLOCATOR_ALLOCATOR_H_
 
 #include <cstdint>
+#include <cstring>
 #include <hermes_shm/memory/memory.h>
 #include <hermes_shm/util/errors.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace hshm::ipc {
 
@@ -60,6 +64,9 @@ class Allocator {
   char *custom_header_;
 
  public:
+  /** The buffer size at which ClearMemory switches to streaming stores */
+  static const size_t non_temporal_clear_size_ = KILOBYTES(256);
+
   /**
    * Constructor
    * */
@@ -99,6 +106,33 @@ class Allocator {
     return PointerT(GetId(), AllocateOffset(size).load());
   }
 
+  /**
+   * Allocate a region of memory of \a size size which is filled with
+   * zeros. Allocators which know that the region has never been handed
+   * out before may skip clearing it.
+   * */
+  virtual OffsetPointer ClearAllocateOffset(size_t size) {
+    OffsetPointer p = AllocateOffset(size);
+    if (!p.IsNull()) {
+      ClearMemory(buffer_ + p.load(), size);
+    }
+    return p;
+  }
+
+  /**
+   * Allocate a zeroed region of memory to a specific pointer type
+   * */
+  template<typename PointerT = Pointer>
+  HSHM_ALWAYS_INLINE PointerT ClearAllocate(size_t size) {
+    return PointerT(GetId(), ClearAllocateOffset(size).load());
+  }
+
+  /**
+   * Indicate that the memory this allocator has not yet handed out is
+   * filled with zeros (e.g., it was freshly mapped from the kernel).
+   * */
+  virtual void SetUntouchedZeroed() {}
+
   /**
    * Allocate a region of memory of \a size size
    * and \a alignment alignment. Assumes that
@@ -257,11 +291,16 @@ class Allocator {
   template<typename T, typename PointerT = Pointer>
   HSHM_ALWAYS_INLINE T* ClearAllocatePtr(size_t size,
                                          PointerT &p, size_t alignment = 0) {
-    p = Allocate<PointerT>(size, alignment);
+    if (alignment == 0) {
+      p = ClearAllocate<PointerT>(size);
+      if (p.IsNull()) { return nullptr; }
+      return reinterpret_cast<T*>(buffer_ + p.off_.load());
+    }
+    p = AlignedAllocate<PointerT>(size, alignment);
     if (p.IsNull()) { return nullptr; }
     auto ptr = reinterpret_cast<T*>(buffer_ + p.off_.load());
     if (ptr) {
-      memset(ptr, 0, size);
+      ClearMemory(ptr, size);
     }
     return ptr;
   }
@@ -838,6 +877,33 @@ class Allocator {
   * Helpers
   * ===================================*/
 
+  /**
+   * Set \a size bytes of \a ptr to zero. Buffers larger than
+   * non_temporal_clear_size_ use non-temporal stores (when SSE2 is available)
+   * so that clearing them does not evict the rest of the cache.
+   * */
+  HSHM_ALWAYS_INLINE static void ClearMemory(void *ptr, size_t size) {
+#ifdef __SSE2__
+    if (size >= non_temporal_clear_size_) {
+      char *cur = reinterpret_cast<char*>(ptr);
+      size_t head = (16 - (reinterpret_cast<size_t>(cur) & 15)) & 15;
+      memset(cur, 0, head);
+      cur += head;
+      size -= head;
+      size_t nvec = size / sizeof(__m128i);
+      __m128i *vec = reinterpret_cast<__m128i*>(cur);
+      __m128i zero = _mm_setzero_si128();
+      for (size_t i = 0; i < nvec; ++i) {
+        _mm_stream_si128(vec + i, zero);
+      }
+      _mm_sfence();
+      memset(vec + nvec, 0, size - nvec * sizeof(__m128i));
+      return;
+    }
+#endif
+    memset(ptr, 0, size);
+  }
+
   /**
    * Get the custom header of the shared-memory allocator
    *
@@ -874,6 +940,14 @@ class Allocator {
                          reinterpret_cast<size_t>(buffer_));
   }
 
+  /**
+   * Whether offsets of this allocator are process addresses, i.e., the
+   * allocator has no buffer base (e.g., MallocAllocator)
+   * */
+  HSHM_ALWAYS_INLINE bool HasNativeOffsets() const {
+    return buffer_ == nullptr;
+  }
+
   /**
    * Determine whether or not this allocator contains a process-specific
    * pointer
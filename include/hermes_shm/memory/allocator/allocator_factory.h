@@ -39,6 +39,7 @@ class AllocatorFactory {
                       backend->data_,
                       backend->data_size_,
                       std::forward<Args>(args)...);
+      ClaimZeroedBackend(alloc.get(), backend);
       return alloc;
     } else if constexpr(std::is_same_v<MallocAllocator, AllocT>) {
       // Malloc Allocator
@@ -56,6 +57,7 @@ class AllocatorFactory {
                       backend->data_,
                       backend->data_size_,
                       std::forward<Args>(args)...);
+      ClaimZeroedBackend(alloc.get(), backend);
       return alloc;
     } else {
       // Default
@@ -63,6 +65,18 @@ class AllocatorFactory {
     }
   }
 
+  /**
+   * Let \a alloc skip clearing memory it hands out for the first time
+   * if \a backend was freshly mapped. Only the first allocator created
+   * over a backend may assume the backend is zeroed.
+   * */
+  static void ClaimZeroedBackend(Allocator *alloc, MemoryBackend *backend) {
+    if (backend->IsZeroed()) {
+      alloc->SetUntouchedZeroed();
+      backend->UnsetZeroed();
+    }
+  }
+
   /**
    * Deserialize the allocator managing this backend.
    * */
@@ -43,6 +43,28 @@ struct HeapAllocator {
     }
     return OffsetPointer(off);
   }
+
+  /**
+   * Allocate off heap only if \a size bytes fit. Unlike AllocateOffset,
+   * a failed attempt leaves the heap untouched.
+   *
+   * @return a null offset if the heap cannot fit \a size bytes
+   * */
+  HSHM_ALWAYS_INLINE OffsetPointer TryAllocateOffset(size_t size) {
+    size_t off = heap_off_.load();
+    do {
+      if (off + size > heap_size_) {
+        return OffsetPointer::GetNull();
+      }
+    } while (!heap_off_.compare_exchange_weak(off, off + size));
+    return OffsetPointer(off);
+  }
+
+  /** Get the number of bytes which have not been handed out yet */
+  HSHM_ALWAYS_INLINE size_t GetRemainingSize() const {
+    size_t off = heap_off_.load();
+    return off < heap_size_ ? heap_size_ - off : 0;
+  }
 };
 
 }  // namespace hshm::ipc
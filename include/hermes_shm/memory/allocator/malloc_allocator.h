@@ -16,11 +16,12 @@
 
 #include "allocator.h"
 #include "hermes_shm/thread/lock.h"
+#include "hermes_shm/types/sharded_counter.h"
 
 namespace hshm::ipc {
 
 struct MallocAllocatorHeader : public AllocatorHeader {
-  std::atomic<size_t> total_alloc_size_;
+  sharded_counter<size_t> total_alloc_size_;
 
   MallocAllocatorHeader() = default;
 
@@ -69,6 +70,12 @@ class MallocAllocator : public Allocator {
    * */
   OffsetPointer AllocateOffset(size_t size) override;
 
+  /**
+   * Allocate a memory of \a size size filled with zeros. Uses calloc,
+   * which avoids clearing pages that come zeroed from the kernel.
+   * */
+  OffsetPointer ClearAllocateOffset(size_t size) override;
+
   /**
    * Allocate a memory of \a size size, which is aligned to \a
    * alignment.
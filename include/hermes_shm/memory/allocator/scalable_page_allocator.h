@@ -16,6 +16,7 @@
 
 #include "allocator.h"
 #include "hermes_shm/thread/lock.h"
+#include "hermes_shm/types/sharded_counter.h"
 #include "hermes_shm/data_structures/ipc/pair.h"
 #include "hermes_shm/data_structures/ipc/vector.h"
 #include "hermes_shm/data_structures/ipc/list.h"
@@ -30,6 +31,7 @@ struct FreeListSetIpc : public ShmContainer {
   ShmArchive<vector<pair<Mutex, iqueue<MpPage>>>> lists_;
   std::atomic<uint16_t> rr_free_;
   std::atomic<uint16_t> rr_alloc_;
+  std::atomic<uint16_t> refill_;  /**< Pages to carve on the next miss */
 
   /** SHM constructor. Default. */
   explicit FreeListSetIpc(Allocator *alloc) {
@@ -74,6 +76,7 @@ struct FreeListSetIpc : public ShmContainer {
   HSHM_ALWAYS_INLINE void SetNull() {
     rr_free_ = 0;
     rr_alloc_ = 0;
+    refill_ = 1;
   }
 };
 
@@ -81,11 +84,12 @@ struct FreeListSet {
   std::vector<std::pair<Mutex*, iqueue<MpPage>*>> lists_;
   std::atomic<uint16_t> *rr_free_;
   std::atomic<uint16_t> *rr_alloc_;
+  std::atomic<uint16_t> *refill_;
 };
 
 struct ScalablePageAllocatorHeader : public AllocatorHeader {
   ShmArchive<vector<FreeListSetIpc>> free_lists_;
-  std::atomic<size_t> total_alloc_;
+  sharded_counter<size_t> total_alloc_;
   size_t coalesce_trigger_;
   size_t coalesce_window_;
 
@@ -127,6 +131,12 @@ class ScalablePageAllocator : public Allocator {
     max_cached_size_exp_ - min_cached_size_exp_ + 1;
   /** An arbitrary free list */
   static const size_t num_free_lists_ = num_caches_ + 1;
+  /** The maximum number of pages carved from the stack in one refill */
+  static const size_t max_refill_pages_ = 64;
+  /** The maximum number of bytes carved from the stack in one refill */
+  static const size_t max_refill_size_ = KILOBYTES(256);
+  /** The maximum number of sibling lanes probed before a refill */
+  static const size_t max_steal_lanes_ = 4;
 
  public:
   /**
@@ -175,6 +185,7 @@ class ScalablePageAllocator : public Allocator {
       free_list_set.lists_.reserve(free_list_set_ipc.lists_->size());
       free_list_set.rr_alloc_ = &free_list_set_ipc.rr_alloc_;
       free_list_set.rr_free_ = &free_list_set_ipc.rr_free_;
+      free_list_set.refill_ = &free_list_set_ipc.refill_;
       // Iterate over single page cache lane
       for (pair<Mutex, iqueue<MpPage>> &free_list_pair_ipc : lists_ipc) {
         Mutex &lock_ipc = free_list_pair_ipc.GetFirst();
@@ -190,7 +201,29 @@ class ScalablePageAllocator : public Allocator {
    * */
   OffsetPointer AllocateOffset(size_t size) override;
 
+  /**
+   * Allocate a memory of \a size size filled with zeros. Pages taken
+   * directly from the untouched part of the stack are not cleared again.
+   * */
+  OffsetPointer ClearAllocateOffset(size_t size) override;
+
+  /**
+   * Indicate that the memory beyond the stack's heap offset is zeroed
+   * */
+  void SetUntouchedZeroed() override {
+    alloc_.SetUntouchedZeroed();
+  }
+
  private:
+  /**
+   * Allocate a page for \a size bytes of data. \a is_zeroed is set
+   * if the page came from the untouched part of the stack. Cached pages
+   * are never considered zeroed, since the free lists store their links
+   * in the page header.
+   * */
+  OffsetPointer AllocatePage(size_t size, bool &is_zeroed);
+
+
   /** Check if a cached page on this core can be re-used */
   HSHM_ALWAYS_INLINE MpPage* CheckLocalCaches(size_t size_mp, size_t exp) {
     MpPage *page;
@@ -211,9 +244,14 @@ class ScalablePageAllocator : public Allocator {
       if (free_list.size()) {
         page = free_list.dequeue();
         return page;
-      } else {
-        return nullptr;
       }
+
+      // Check sibling buffer caches before going to the stack
+      page = StealFromSiblingLanes(free_list_set, free_list, conc);
+      if (page) {
+        return page;
+      }
+      return RefillLocalCache(free_list_set, free_list, size_mp);
     } else {
       // Get buffer cache at exp
       FreeListSet &free_list_set = free_lists_[num_caches_];
@@ -232,6 +270,100 @@ class ScalablePageAllocator : public Allocator {
     }
   }
 
+  /**
+   * Probe up to max_steal_lanes_ sibling lanes of \a free_list_set. The
+   * first non-empty lane gives half of its pages to \a free_list, whose
+   * lock must be held. Busy siblings are skipped instead of waited on.
+   *
+   * @return a page from the migrated pages, or nullptr if none were found
+   * */
+  HSHM_ALWAYS_INLINE MpPage* StealFromSiblingLanes(FreeListSet &free_list_set,
+                                                   iqueue<MpPage> &free_list,
+                                                   uint16_t conc) {
+    size_t num_lanes = free_list_set.lists_.size();
+    size_t num_probes = num_lanes - 1;
+    if (num_probes > max_steal_lanes_) {
+      num_probes = max_steal_lanes_;
+    }
+    for (size_t i = 1; i <= num_probes; ++i) {
+      std::pair<Mutex*, iqueue<MpPage>*> sibling_pair =
+        free_list_set.lists_[(conc + i) % num_lanes];
+      Mutex &lock = *sibling_pair.first;
+      iqueue<MpPage> &sibling = *sibling_pair.second;
+      if (!lock.TryLock(0)) {
+        continue;
+      }
+      size_t count = (sibling.size() + 1) / 2;
+      for (size_t j = 0; j < count; ++j) {
+        free_list.enqueue(sibling.dequeue());
+      }
+      lock.Unlock();
+      if (count) {
+        return free_list.dequeue();
+      }
+    }
+    return nullptr;
+  }
+
+  /**
+   * Carve a batch of pages of size \a size_mp from the stack allocator.
+   * One page is returned and the rest are cached in \a free_list, whose
+   * lock must be held. Each miss doubles the batch size of the size class,
+   * so frequently-allocated classes go to the stack less often.
+   * DecayRefill shrinks it again once cached pages stop being used.
+   *
+   * @return nullptr if only a single page should be allocated, or if the
+   * batch no longer fits in the stack
+   * */
+  HSHM_ALWAYS_INLINE MpPage* RefillLocalCache(FreeListSet &free_list_set,
+                                              iqueue<MpPage> &free_list,
+                                              size_t size_mp) {
+    // Determine the number of pages to carve
+    size_t num_pages = free_list_set.refill_->load();
+    if (num_pages < max_refill_pages_) {
+      free_list_set.refill_->store(num_pages * 2);
+    }
+    if (num_pages * size_mp > max_refill_size_) {
+      num_pages = max_refill_size_ / size_mp;
+    }
+    size_t rem_size = alloc_.GetRemainingSize();
+    if (rem_size < num_pages * size_mp + sizeof(MpPage)) {
+      num_pages = (rem_size - std::min(rem_size, sizeof(MpPage))) / size_mp;
+    }
+    if (num_pages <= 1) {
+      return nullptr;
+    }
+
+    // Carve the pages. Refills in other lanes may have taken the space
+    // since it was checked, in which case a single page is tried instead.
+    auto off = alloc_.TryAllocateOffset(num_pages * size_mp);
+    if (off.IsNull()) {
+      return nullptr;
+    }
+    MpPage *page = alloc_.Convert<MpPage>(off - sizeof(MpPage));
+    MpPage *rem_page;
+    page->page_size_ = num_pages * size_mp;
+    DividePage(free_list, page, rem_page, size_mp, num_pages);
+    if (rem_page) {
+      free_list.enqueue(rem_page);
+    }
+    return page;
+  }
+
+  /**
+   * Halve the batch size of \a free_list_set when \a free_list, whose
+   * lock must be held, already caches a full batch of unused pages.
+   * Frees are then satisfying the allocations, so the next refill
+   * should not carve as much.
+   * */
+  HSHM_ALWAYS_INLINE void DecayRefill(FreeListSet &free_list_set,
+                                      iqueue<MpPage> &free_list) {
+    uint16_t num_pages = free_list_set.refill_->load();
+    if (num_pages > 1 && free_list.size() >= num_pages) {
+      free_list_set.refill_->store(num_pages / 2);
+    }
+  }
+
   /** Find the first fit of an element in a free list */
   HSHM_ALWAYS_INLINE MpPage* FindFirstFit(size_t size_mp,
                                           iqueue<MpPage> &free_list) {
@@ -321,6 +453,19 @@ class ScalablePageAllocator : public Allocator {
    * */
   size_t GetCurrentlyAllocatedSize() override;
 
+  /**
+   * Get the number of free pages cached in the size class of \a size
+   * across all of its lanes
+   * */
+  size_t GetCachedPageCount(size_t size);
+
+  /**
+   * Get the number of bytes which have not been carved from the stack
+   * */
+  HSHM_ALWAYS_INLINE size_t GetRemainingSize() {
+    return alloc_.GetRemainingSize();
+  }
+
  private:
   /** Round a number up to the nearest page size. */
   HSHM_ALWAYS_INLINE size_t RoundUp(size_t num, size_t &exp) {
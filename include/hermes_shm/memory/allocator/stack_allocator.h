@@ -17,12 +17,14 @@
 #include "allocator.h"
 #include "heap.h"
 #include "hermes_shm/thread/lock.h"
+#include "hermes_shm/types/sharded_counter.h"
 
 namespace hshm::ipc {
 
 struct StackAllocatorHeader : public AllocatorHeader {
   HeapAllocator heap_;
-  std::atomic<size_t> total_alloc_;
+  sharded_counter<size_t> total_alloc_;
+  bool zeroed_;  /**< Memory beyond the heap offset is filled with zeros */
 
   StackAllocatorHeader() = default;
 
@@ -34,6 +36,7 @@ struct StackAllocatorHeader : public AllocatorHeader {
                                custom_header_size);
     heap_.shm_init(region_off, region_size);
     total_alloc_ = 0;
+    zeroed_ = false;
   }
 };
 
@@ -76,6 +79,33 @@ class StackAllocator : public Allocator {
    * */
   OffsetPointer AllocateOffset(size_t size) override;
 
+  /**
+   * Allocate a memory of \a size size only if it fits in the stack.
+   *
+   * @return a null offset instead of throwing when the stack is exhausted
+   * */
+  OffsetPointer TryAllocateOffset(size_t size);
+
+  /**
+   * Allocate a memory of \a size size filled with zeros. The stack never
+   * re-uses memory, so the memset is skipped if the region was zeroed.
+   * */
+  OffsetPointer ClearAllocateOffset(size_t size) override;
+
+  /**
+   * Indicate that the memory beyond the heap offset is filled with zeros
+   * */
+  void SetUntouchedZeroed() override {
+    header_->zeroed_ = true;
+  }
+
+  /**
+   * Whether memory newly allocated from the stack is filled with zeros
+   * */
+  HSHM_ALWAYS_INLINE bool IsUntouchedZeroed() {
+    return header_->zeroed_;
+  }
+
   /**
    * Allocate a memory of \a size size, which is aligned to \a
    * alignment.
@@ -100,6 +130,17 @@ class StackAllocator : public Allocator {
    * checking.
    * */
   size_t GetCurrentlyAllocatedSize() override;
+
+  /**
+   * Get the number of bytes which can still be allocated from the stack
+   * */
+  HSHM_ALWAYS_INLINE size_t GetRemainingSize() {
+    return heap_->GetRemainingSize();
+  }
+
+ private:
+  /** Write the page header of \a size bytes carved at \a p */
+  OffsetPointer MarkAllocated(OffsetPointer p, size_t size);
 };
 
 }  // namespace hshm::ipc
@@ -35,6 +35,7 @@ enum class MemoryBackendType {
 
 #define MEMORY_BACKEND_INITIALIZED 0x1
 #define MEMORY_BACKEND_OWNED 0x2
+#define MEMORY_BACKEND_ZEROED 0x4
 
 class MemoryBackend {
  public:
@@ -78,6 +79,21 @@ class MemoryBackend {
     flags_.UnsetBits(MEMORY_BACKEND_OWNED);
   }
 
+  /** Mark data as freshly mapped and filled with zeros */
+  void SetZeroed() {
+    flags_.SetBits(MEMORY_BACKEND_ZEROED);
+  }
+
+  /** Check if data is known to be filled with zeros */
+  bool IsZeroed() {
+    return flags_.Any(MEMORY_BACKEND_ZEROED);
+  }
+
+  /** Mark data as possibly containing non-zero bytes */
+  void UnsetZeroed() {
+    flags_.UnsetBits(MEMORY_BACKEND_ZEROED);
+  }
+
   /// Each allocator must define its own shm_init.
   // virtual bool shm_init(size_t size, ...) = 0;
   virtual bool shm_deserialize(std::string url) = 0;
@@ -51,6 +51,7 @@ class PosixMmap : public MemoryBackend {
   /** Initialize backend */
   bool shm_init(size_t size) {
     SetInitialized();
+    SetZeroed();
     Own();
     total_size_ = sizeof(MemoryBackendHeader) + size;
     char *ptr = _Map(total_size_);
@@ -53,6 +53,7 @@ class PosixShmMmap : public MemoryBackend {
   /** Initialize backend */
   bool shm_init(size_t size, std::string url) {
     SetInitialized();
+    SetZeroed();
     Own();
     url_ = std::move(url);
     shm_unlink(url_.c_str());
@@ -16,6 +16,7 @@
 
 #include "lock/mutex.h"
 #include "lock/rwlock.h"
+#include "lock/futex.h"
 #include "thread_model_manager.h"
 
 #endif  // HERMES_THREAD_LOCK_H_
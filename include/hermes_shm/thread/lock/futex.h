@@ -0,0 +1,124 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HERMES_THREAD_FUTEX_H_
+#define HERMES_THREAD_FUTEX_H_
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <ctime>
+#include "hermes_shm/constants/macros.h"
+
+/** A timeout for Futex::WaitFor that never expires */
+#define HSHM_WAIT_FOREVER SIZE_MAX
+
+namespace hshm {
+
+/**
+ * A word to sleep on until some condition holds, e.g., a queue becoming
+ * non-empty. The futex is process-shared, so a Futex placed in shared
+ * memory lets a thread in one process wake a thread in another.
+ *
+ * Wake only enters the kernel when a thread is registered as sleeping,
+ * so notifying costs a fence and a load while nobody is waiting.
+ * */
+struct Futex {
+  std::atomic<uint32_t> seq_;      /**< Bumped by each Wake with sleepers */
+  std::atomic<uint32_t> waiters_;  /**< The number of threads about to sleep */
+
+  /** Default constructor */
+  HSHM_ALWAYS_INLINE Futex() : seq_(0), waiters_(0) {}
+
+  /** Copy constructor. Waiters are never copied. */
+  HSHM_ALWAYS_INLINE Futex(const Futex &) : seq_(0), waiters_(0) {}
+
+  /** Explicit initialization */
+  HSHM_ALWAYS_INLINE void Init() {
+    seq_ = 0;
+    waiters_ = 0;
+  }
+
+  /**
+   * Spin, then sleep, until \a try_op returns true or \a timeout_us
+   * microseconds pass. try_op is retried after registering as a waiter,
+   * so a Wake that races with falling asleep is never lost.
+   *
+   * @return true if try_op succeeded
+   * */
+  template<typename FUNC>
+  bool WaitFor(FUNC &&try_op, size_t timeout_us, size_t spin = 64) {
+    for (size_t i = 0; i < spin; ++i) {
+      if (try_op()) {
+        return true;
+      }
+    }
+    auto start = std::chrono::steady_clock::now();
+    while (true) {
+      waiters_.fetch_add(1);
+      uint32_t seq = seq_.load();
+      if (try_op()) {
+        waiters_.fetch_sub(1);
+        return true;
+      }
+      size_t waited = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+      if (waited >= timeout_us) {
+        waiters_.fetch_sub(1);
+        return false;
+      }
+      if (timeout_us == HSHM_WAIT_FOREVER) {
+        Sleep(seq, HSHM_WAIT_FOREVER);
+      } else {
+        Sleep(seq, timeout_us - waited);
+      }
+      waiters_.fetch_sub(1);
+    }
+  }
+
+  /**
+   * Wake every thread sleeping in WaitFor. The caller must have made
+   * the condition true before calling this.
+   * */
+  HSHM_ALWAYS_INLINE void Wake() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters_.load(std::memory_order_relaxed) == 0) {
+      return;
+    }
+    seq_.fetch_add(1);
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&seq_),
+            FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+  }
+
+ private:
+  /** Sleep while seq_ equals \a seq, for at most \a timeout_us */
+  void Sleep(uint32_t seq, size_t timeout_us) {
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t));
+    struct timespec ts;
+    struct timespec *tsp = nullptr;
+    if (timeout_us != HSHM_WAIT_FOREVER) {
+      ts.tv_sec = static_cast<time_t>(timeout_us / 1000000);
+      ts.tv_nsec = static_cast<long>(timeout_us % 1000000) * 1000;  // NOLINT
+      tsp = &ts;
+    }
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&seq_),
+            FUTEX_WAIT, seq, tsp, nullptr, 0);
+  }
+};
+
+}  // namespace hshm
+
+#endif  // HERMES_THREAD_FUTEX_H_
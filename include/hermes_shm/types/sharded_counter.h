@@ -0,0 +1,134 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef HERMES_INCLUDE_HERMES_TYPES_SHARDED_COUNTER_H_
+#define HERMES_INCLUDE_HERMES_TYPES_SHARDED_COUNTER_H_
+
+#include <unistd.h>
+#include <atomic>
+#include <hermes_shm/constants/macros.h>
+
+namespace hshm::ipc {
+
+/**
+ * Get the shard index of the calling thread. Threads are assigned shards
+ * round-robin, starting from an offset derived from the process id so
+ * that threads of different processes tend to use different shards.
+ * */
+HSHM_ALWAYS_INLINE size_t GetThreadShardIdx() {
+  static std::atomic<size_t> next_shard(static_cast<size_t>(getpid()));
+  static thread_local size_t shard = next_shard.fetch_add(1);
+  return shard;
+}
+
+/**
+ * A counter which is split into cache-line-sized shards. Each thread
+ * updates its own shard, so concurrent updates do not contend on a
+ * single cache line. Reading the counter sums every shard.
+ *
+ * The counter contains no pointers, so it can be placed in shared memory.
+ * Loads are not a snapshot: updates made during a load may be missed.
+ * */
+template<typename T, size_t NUM_SHARDS = 16>
+struct sharded_counter {
+  static_assert(sizeof(std::atomic<T>) < HSHM_CACHE_LINE_SIZE,
+                "sharded_counter elements must fit in a cache line");
+
+  /** A single shard, padded to occupy a cache line */
+  struct shard {
+    std::atomic<T> x_;
+    char pad_[HSHM_CACHE_LINE_SIZE - sizeof(std::atomic<T>)];
+  };
+  shard shards_[NUM_SHARDS];
+
+  /** Constructor */
+  HSHM_ALWAYS_INLINE sharded_counter() {
+    store(0);
+  }
+
+  /** Full constructor */
+  HSHM_ALWAYS_INLINE explicit sharded_counter(T def) {
+    store(def);
+  }
+
+  /** Get the shard of the calling thread */
+  HSHM_ALWAYS_INLINE std::atomic<T>& local() {
+    return shards_[GetThreadShardIdx() % NUM_SHARDS].x_;
+  }
+
+  /** Add \a count to the calling thread's shard */
+  HSHM_ALWAYS_INLINE void add(T count) {
+    local().fetch_add(count, std::memory_order_relaxed);
+  }
+
+  /** Subtract \a count from the calling thread's shard */
+  HSHM_ALWAYS_INLINE void sub(T count) {
+    local().fetch_sub(count, std::memory_order_relaxed);
+  }
+
+  /** Sum all shards */
+  HSHM_ALWAYS_INLINE T load() const {
+    T sum = 0;
+    for (size_t i = 0; i < NUM_SHARDS; ++i) {
+      sum += shards_[i].x_.load(std::memory_order_relaxed);
+    }
+    return sum;
+  }
+
+  /** Set the counter. Not atomic with respect to concurrent updates. */
+  HSHM_ALWAYS_INLINE void store(T count) {
+    shards_[0].x_.store(count, std::memory_order_relaxed);
+    for (size_t i = 1; i < NUM_SHARDS; ++i) {
+      shards_[i].x_.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  /** Implicit conversion to the summed value */
+  HSHM_ALWAYS_INLINE operator T() const {
+    return load();
+  }
+
+  /** Pre-increment operator */
+  HSHM_ALWAYS_INLINE sharded_counter& operator++() {
+    add(1);
+    return *this;
+  }
+
+  /** Pre-decrement operator */
+  HSHM_ALWAYS_INLINE sharded_counter& operator--() {
+    sub(1);
+    return *this;
+  }
+
+  /** Add assign operator */
+  HSHM_ALWAYS_INLINE sharded_counter& operator+=(T count) {
+    add(count);
+    return *this;
+  }
+
+  /** Subtract assign operator */
+  HSHM_ALWAYS_INLINE sharded_counter& operator-=(T count) {
+    sub(count);
+    return *this;
+  }
+
+  /** Assign operator */
+  HSHM_ALWAYS_INLINE sharded_counter& operator=(T count) {
+    store(count);
+    return *this;
+  }
+};
+
+}  // namespace hshm::ipc
+
+#endif  // HERMES_INCLUDE_HERMES_TYPES_SHARDED_COUNTER_H_
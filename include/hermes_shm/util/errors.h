@@ -61,6 +61,12 @@ namespace hshm {
   const Error IPC_ARGS_NOT_SHM_COMPATIBLE("Args are not compatible with SHM");
 
   const Error UNORDERED_MAP_CANT_FIND("Could not find key in unordered_map");
+  const Error LRU_CACHE_INVALID_CAPACITY("lru_cache cannot hold {} entries");
+  const Error PRIVATE_CONTAINER_ALLOCATOR(
+    "Private containers need an allocator whose offsets are addresses");
+  const Error NODE_POOL_IN_USE("{}: the node pool can only change while empty");
+  const Error BYTE_RING_MESSAGE_TOO_LARGE(
+    "byte_ring: a message of {} bytes does not fit a ring of {} bytes");
 }  // namespace hshm
 
 #endif
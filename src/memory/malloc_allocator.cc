@@ -36,7 +36,7 @@ void MallocAllocator::shm_deserialize(char *buffer,
 }
 
 size_t MallocAllocator::GetCurrentlyAllocatedSize() {
-  return header_->total_alloc_size_;
+  return header_->total_alloc_size_.load();
 }
 
 OffsetPointer MallocAllocator::AllocateOffset(size_t size) {
@@ -47,6 +47,14 @@ OffsetPointer MallocAllocator::AllocateOffset(size_t size) {
   return OffsetPointer((size_t)(page + 1));
 }
 
+OffsetPointer MallocAllocator::ClearAllocateOffset(size_t size) {
+  auto page = reinterpret_cast<MallocPage*>(
+    calloc(1, sizeof(MallocPage) + size));
+  page->page_size_ = size;
+  header_->total_alloc_size_ += size;
+  return OffsetPointer((size_t)(page + 1));
+}
+
 OffsetPointer MallocAllocator::AlignedAllocateOffset(size_t size,
                                                      size_t alignment) {
   auto page = reinterpret_cast<MallocPage*>(
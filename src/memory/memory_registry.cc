@@ -22,6 +22,7 @@ MemoryRegistry::MemoryRegistry() {
   root_allocator_.shm_init(root_allocator_id_, 0,
                            root_backend_.data_,
                            root_backend_.data_size_);
+  root_allocator_.SetUntouchedZeroed();
   default_allocator_ = &root_allocator_;
   memset(allocators_, 0, sizeof(allocators_));
   RegisterAllocator(&root_allocator_);
@@ -53,12 +53,42 @@ void ScalablePageAllocator::shm_deserialize(char *buffer,
 }
 
 size_t ScalablePageAllocator::GetCurrentlyAllocatedSize() {
-  return header_->total_alloc_;
+  return header_->total_alloc_.load();
+}
+
+size_t ScalablePageAllocator::GetCachedPageCount(size_t size) {
+  size_t exp;
+  size_t size_mp = RoundUp(size + sizeof(MpPage), exp);
+  FreeListSet &free_list_set =
+    free_lists_[size_mp <= max_cached_size_ ? exp : num_caches_];
+  size_t count = 0;
+  for (std::pair<Mutex*, iqueue<MpPage>*> &free_list_pair :
+       free_list_set.lists_) {
+    ScopedMutex scoped_lock(*free_list_pair.first, 0);
+    count += free_list_pair.second->size();
+  }
+  return count;
 }
 
 OffsetPointer ScalablePageAllocator::AllocateOffset(size_t size) {
+  bool is_zeroed;
+  return AllocatePage(size, is_zeroed);
+}
+
+OffsetPointer ScalablePageAllocator::ClearAllocateOffset(size_t size) {
+  bool is_zeroed;
+  OffsetPointer p = AllocatePage(size, is_zeroed);
+  if (!is_zeroed) {
+    ClearMemory(Convert<void>(p), size);
+  }
+  return p;
+}
+
+OffsetPointer ScalablePageAllocator::AllocatePage(size_t size,
+                                                  bool &is_zeroed) {
   MpPage *page = nullptr;
   size_t exp;
+  is_zeroed = false;
   size_t size_mp = RoundUp(size + sizeof(MpPage), exp);
 
   // Case 1: Can we re-use an existing page?
@@ -72,6 +102,7 @@ OffsetPointer ScalablePageAllocator::AllocateOffset(size_t size) {
     auto off = alloc_.AllocateOffset(size_mp);
     if (!off.IsNull()) {
       page = alloc_.Convert<MpPage>(off - sizeof(MpPage));
+      is_zeroed = alloc_.IsUntouchedZeroed();
     }
   }
 
@@ -82,7 +113,7 @@ OffsetPointer ScalablePageAllocator::AllocateOffset(size_t size) {
 
   // Mark as allocated
   page->page_size_ = size_mp;
-  header_->total_alloc_.fetch_add(page->page_size_);
+  header_->total_alloc_ += page->page_size_;
   auto p = Convert<MpPage, OffsetPointer>(page);
   page->SetAllocated();
   return p + sizeof(MpPage);
@@ -112,7 +143,7 @@ void ScalablePageAllocator::FreeOffsetNoNullCheck(OffsetPointer p) {
     throw DOUBLE_FREE.format();
   }
   hdr->UnsetAllocated();
-  header_->total_alloc_.fetch_sub(hdr->page_size_);
+  header_->total_alloc_ -= hdr->page_size_;
   size_t exp;
   RoundUp(hdr->page_size_, exp);
 
@@ -128,6 +159,7 @@ void ScalablePageAllocator::FreeOffsetNoNullCheck(OffsetPointer p) {
     iqueue<MpPage> &free_list = *free_list_pair.second;
     ScopedMutex scoped_lock(lock, 0);
     free_list.enqueue(hdr);
+    DecayRefill(free_list_set, free_list);
   } else {
     // Get buffer cache at exp
     FreeListSet &free_list_set = free_lists_[num_caches_];
@@ -40,20 +40,41 @@ void StackAllocator::shm_deserialize(char *buffer,
 }
 
 size_t StackAllocator::GetCurrentlyAllocatedSize() {
-  return header_->total_alloc_;
+  return header_->total_alloc_.load();
 }
 
 OffsetPointer StackAllocator::AllocateOffset(size_t size) {
   size += sizeof(MpPage);
   OffsetPointer p = heap_->AllocateOffset(size);
+  return MarkAllocated(p, size);
+}
+
+OffsetPointer StackAllocator::TryAllocateOffset(size_t size) {
+  size += sizeof(MpPage);
+  OffsetPointer p = heap_->TryAllocateOffset(size);
+  if (p.IsNull()) {
+    return p;
+  }
+  return MarkAllocated(p, size);
+}
+
+OffsetPointer StackAllocator::MarkAllocated(OffsetPointer p, size_t size) {
   auto hdr = Convert<MpPage>(p);
   hdr->SetAllocated();
   hdr->page_size_ = size;
   hdr->off_ = 0;
-  header_->total_alloc_.fetch_add(hdr->page_size_);
+  header_->total_alloc_ += hdr->page_size_;
   return p + sizeof(MpPage);
 }
 
+OffsetPointer StackAllocator::ClearAllocateOffset(size_t size) {
+  OffsetPointer p = AllocateOffset(size);
+  if (!header_->zeroed_) {
+    ClearMemory(Convert<void>(p), size);
+  }
+  return p;
+}
+
 OffsetPointer StackAllocator::AlignedAllocateOffset(size_t size,
                                                     size_t alignment) {
   throw ALIGNED_ALLOC_NOT_SUPPORTED.format();
@@ -77,7 +98,7 @@ void StackAllocator::FreeOffsetNoNullCheck(OffsetPointer p) {
     throw DOUBLE_FREE.format();
   }
   hdr->UnsetAllocated();
-  header_->total_alloc_.fetch_sub(hdr->page_size_);
+  header_->total_alloc_ -= hdr->page_size_;
 }
 
 }  // namespace hshm::ipc
@@ -103,6 +103,27 @@ void ReallocationTest(Allocator *alloc) {
   }
 }
 
+void ClearAllocationTest(Allocator *alloc) {
+  std::vector<size_t> alloc_sizes = {
+    64, KILOBYTES(4), MEGABYTES(1)
+  };
+
+  // Dirty pages, free them, and verify they are zeroed when re-used
+  for (size_t size : alloc_sizes) {
+    for (size_t r = 0; r < 2; ++r) {
+      Pointer ps[16];
+      for (size_t j = 0; j < 16; ++j) {
+        char *ptr = alloc->ClearAllocatePtr<char>(size, ps[j]);
+        REQUIRE(VerifyBuffer(ptr, size, 0));
+        memset(ptr, 10, size);
+      }
+      for (size_t j = 0; j < 16; ++j) {
+        alloc->Free(ps[j]);
+      }
+    }
+  }
+}
+
 void AlignedAllocationTest(Allocator *alloc) {
   std::vector<std::pair<size_t, size_t>> sizes = {
       {KILOBYTES(4), KILOBYTES(4)},
@@ -125,6 +146,11 @@ TEST_CASE("StackAllocator") {
   REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
   PageAllocationTest(alloc);
   REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  ClearAllocationTest(alloc);
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+
   Posttest();
 }
 
@@ -138,6 +164,10 @@ TEST_CASE("MallocAllocator") {
   MultiPageAllocationTest(alloc);
   REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
 
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  ClearAllocationTest(alloc);
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+
   Posttest();
 }
 
@@ -155,6 +185,112 @@ TEST_CASE("ScalablePageAllocator") {
   ReallocationTest(alloc);
   REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
 
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  ClearAllocationTest(alloc);
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+
+  Posttest();
+}
+
+/**
+ * Create a ScalablePageAllocator with \a nlanes lanes per size class,
+ * so the lane selected by each allocation and free is predictable.
+ * */
+hipc::ScalablePageAllocator* ScalablePretest(int nlanes) {
+  int ncpu = HERMES_SYSTEM_INFO->ncpu_;
+  HERMES_SYSTEM_INFO->ncpu_ = nlanes;
+  auto alloc = Pretest<hipc::PosixShmMmap, hipc::ScalablePageAllocator>();
+  HERMES_SYSTEM_INFO->ncpu_ = ncpu;
+  return static_cast<hipc::ScalablePageAllocator*>(alloc);
+}
+
+TEST_CASE("ScalablePageAllocatorRefill") {
+  auto alloc = ScalablePretest(1);
+  size_t size = 64;
+  size_t size_mp = size + sizeof(hipc::MpPage);
+  std::vector<Pointer> ps;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+
+  // The batch doubles on each miss: 1 page, then 2, then 4
+  ps.emplace_back(alloc->Allocate(size));
+  REQUIRE(alloc->GetCachedPageCount(size) == 0);
+  ps.emplace_back(alloc->Allocate(size));
+  REQUIRE(alloc->GetCachedPageCount(size) == 1);
+  ps.emplace_back(alloc->Allocate(size));
+  REQUIRE(alloc->GetCachedPageCount(size) == 0);
+  size_t rem_size = alloc->GetRemainingSize();
+  ps.emplace_back(alloc->Allocate(size));
+  REQUIRE(alloc->GetCachedPageCount(size) == 3);
+  REQUIRE(rem_size - alloc->GetRemainingSize() ==
+          4 * size_mp + sizeof(hipc::MpPage));
+
+  // Cached pages are not counted as allocated
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 4 * size_mp);
+
+  // Grow the batch to its maximum
+  for (size_t i = 0; i < 256; ++i) {
+    ps.emplace_back(alloc->Allocate(size));
+  }
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == ps.size() * size_mp);
+  REQUIRE(alloc->GetCachedPageCount(size) < 64);
+
+  // Freed pages satisfy the allocations, so the batch decays to 1
+  size_t num_pages = ps.size();
+  for (Pointer &p : ps) {
+    alloc->Free(p);
+  }
+  ps.clear();
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  size_t cached = alloc->GetCachedPageCount(size);
+  REQUIRE(cached >= num_pages);
+  for (size_t i = 0; i < cached; ++i) {
+    ps.emplace_back(alloc->Allocate(size));
+  }
+  REQUIRE(alloc->GetCachedPageCount(size) == 0);
+  rem_size = alloc->GetRemainingSize();
+  ps.emplace_back(alloc->Allocate(size));
+  REQUIRE(alloc->GetCachedPageCount(size) == 0);
+  REQUIRE(rem_size - alloc->GetRemainingSize() ==
+          size_mp + sizeof(hipc::MpPage));
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == ps.size() * size_mp);
+  for (Pointer &p : ps) {
+    alloc->Free(p);
+  }
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  Posttest();
+}
+
+TEST_CASE("ScalablePageAllocatorSteal") {
+  // Pages of this size are never carved in batches, so every page in
+  // a lane got there through a free
+  auto alloc = ScalablePretest(4);
+  size_t size = KILOBYTES(200);
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+
+  // Lanes 0 and 1 miss and allocate from the stack
+  Pointer p0 = alloc->Allocate(size);
+  Pointer p1 = alloc->Allocate(size);
+  REQUIRE(alloc->GetCachedPageCount(size) == 0);
+
+  // Free into lane 0, then allocate from lane 2
+  alloc->Free(p0);
+  REQUIRE(alloc->GetCachedPageCount(size) == 1);
+  size_t rem_size = alloc->GetRemainingSize();
+  Pointer p2 = alloc->Allocate(size);
+  REQUIRE(p2 == p0);
+  REQUIRE(alloc->GetRemainingSize() == rem_size);
+  REQUIRE(alloc->GetCachedPageCount(size) == 0);
+
+  // Free into lanes 1 and 2, then allocate from lanes 3 and 0
+  alloc->Free(p1);
+  alloc->Free(p2);
+  Pointer p3 = alloc->Allocate(size);
+  Pointer p4 = alloc->Allocate(size);
+  REQUIRE(alloc->GetRemainingSize() == rem_size);
+  REQUIRE(alloc->GetCachedPageCount(size) == 0);
+  alloc->Free(p3);
+  alloc->Free(p4);
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
   Posttest();
 }
 
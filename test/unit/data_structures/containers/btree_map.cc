@@ -0,0 +1,340 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+* Distributed under BSD 3-Clause license.                                   *
+* Copyright by The HDF Group.                                               *
+* Copyright by the Illinois Institute of Technology.                        *
+* All rights reserved.                                                      *
+*                                                                           *
+* This file is part of Hermes. The full Hermes copyright notice, including  *
+* terms governing use, modification, and redistribution, is contained in    *
+* the COPYING file, which can be found at the top directory. If you do not  *
+* have access to the file, you may request a copy from help@hdfgroup.org.   *
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "basic_test.h"
+#include "test_init.h"
+#include "omp.h"
+#include "hermes_shm/data_structures/ipc/btree_map.h"
+
+using hshm::ipc::Allocator;
+using hshm::ipc::btree_map;
+using hshm::ipc::btree_map_entry;
+
+template<typename Key, typename Val>
+void BtreeMapOpTest() {
+  Allocator *alloc = alloc_g;
+  auto map_p = hipc::make_uptr<btree_map<Key, Val>>(alloc);
+  auto &map = *map_p;
+  Key count = 10000;
+
+  // Insert entries out of order, forcing several splits
+  PAGE_DIVIDE("Insert entries") {
+    for (Key i = 0; i < count; ++i) {
+      Key key = (i * 7919) % count;
+      REQUIRE(map.try_emplace(key, static_cast<Val>(key)));
+    }
+    REQUIRE(map.size() == (size_t)count);
+    REQUIRE(map.height() > 2);
+  }
+
+  // Find and index every entry
+  PAGE_DIVIDE("Find entries") {
+    for (Key i = 0; i < count; ++i) {
+      auto iter = map.find(i);
+      REQUIRE(!iter.is_end());
+      REQUIRE((*iter).GetKey() == i);
+      REQUIRE(map[i] == static_cast<Val>(i));
+      Val val;
+      REQUIRE(map.lookup(i, val));
+      REQUIRE(val == static_cast<Val>(i));
+    }
+    Val val;
+    REQUIRE(map.find(count).is_end());
+    REQUIRE(!map.lookup(count, val));
+    REQUIRE_THROWS(map[count]);
+  }
+
+  // Iterate over the map in order
+  PAGE_DIVIDE("Forward iterate") {
+    Key i = 0;
+    for (auto &entry : map) {
+      REQUIRE(entry.GetKey() == i);
+      REQUIRE(entry.GetVal() == static_cast<Val>(i));
+      ++i;
+    }
+    REQUIRE(i == count);
+  }
+
+  // Modify entries
+  PAGE_DIVIDE("Modify entries") {
+    for (Key i = 0; i < count; ++i) {
+      REQUIRE(!map.try_emplace(i, static_cast<Val>(i + 1)));
+      REQUIRE(map.emplace(i, static_cast<Val>(i + 1)));
+      REQUIRE(map[i] == static_cast<Val>(i + 1));
+    }
+    REQUIRE(map.size() == (size_t)count);
+  }
+
+  // Erase the even entries and check the bounds around them
+  PAGE_DIVIDE("Erase entries") {
+    for (Key i = 0; i < count; i += 2) {
+      REQUIRE(map.erase(i));
+    }
+    REQUIRE(!map.erase(0));
+    REQUIRE(map.size() == (size_t)count / 2);
+    for (Key i = 0; i < count; i += 2) {
+      REQUIRE(map.find(i).is_end());
+      REQUIRE((*map.lower_bound(i)).GetKey() == i + 1);
+      REQUIRE((*map.upper_bound(i)).GetKey() == i + 1);
+      REQUIRE((*map.lower_bound(i + 1)).GetKey() == i + 1);
+      if (i + 3 < count) {
+        REQUIRE((*map.upper_bound(i + 1)).GetKey() == i + 3);
+      }
+    }
+    REQUIRE(map.upper_bound(count - 1).is_end());
+  }
+
+  // Scan ranges of the map
+  PAGE_DIVIDE("Scan ranges") {
+    std::vector<btree_map_entry<Key, Val>> out(count);
+    size_t n = map.scan(100, 200, out.data(), out.size());
+    REQUIRE(n == 50);
+    for (size_t i = 0; i < n; ++i) {
+      REQUIRE(out[i].GetKey() == static_cast<Key>(101 + 2 * i));
+    }
+    n = map.scan(0, count, out.data(), 10);
+    REQUIRE(n == 10);
+    REQUIRE(out[9].GetKey() == 19);
+    n = map.scan(0, count, out.data(), out.size());
+    REQUIRE(n == (size_t)count / 2);
+  }
+
+  // Copy the map
+  PAGE_DIVIDE("Copy the map") {
+    auto cpy = hipc::make_uptr<btree_map<Key, Val>>(alloc, map);
+    REQUIRE(cpy->size() == (size_t)count / 2);
+    for (Key i = 1; i < count; i += 2) {
+      REQUIRE((*cpy)[i] == static_cast<Val>(i + 1));
+    }
+  }
+
+  // Move the map
+  PAGE_DIVIDE("Move the map") {
+    auto cpy = hipc::make_uptr<btree_map<Key, Val>>(alloc);
+    (*cpy) = std::move(map);
+    REQUIRE(map.size() == 0);
+    REQUIRE(map.find(1).is_end());
+    for (Key i = 1; i < count; i += 2) {
+      REQUIRE((*cpy)[i] == static_cast<Val>(i + 1));
+    }
+    map = std::move(*cpy);
+  }
+
+  // Bulk load the map from sorted input
+  PAGE_DIVIDE("Bulk load") {
+    std::vector<Key> keys(count);
+    std::vector<Val> vals(count);
+    for (Key i = 0; i < count; ++i) {
+      keys[i] = 2 * i;
+      vals[i] = static_cast<Val>(i);
+    }
+    map.bulk_load(keys.data(), vals.data(), keys.size());
+    REQUIRE(map.size() == (size_t)count);
+    Key i = 0;
+    for (auto &entry : map) {
+      REQUIRE(entry.GetKey() == 2 * i);
+      ++i;
+    }
+    REQUIRE(i == count);
+    REQUIRE(map.try_emplace(1, 0));
+    REQUIRE((*map.upper_bound(0)).GetKey() == 1);
+  }
+
+  // Clear the map
+  PAGE_DIVIDE("Clear the map") {
+    map.clear();
+    REQUIRE(map.size() == 0);
+    REQUIRE(map.begin() == map.end());
+    REQUIRE(map.find(0).is_end());
+  }
+}
+
+TEST_CASE("BtreeMapOfIntInt") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  BtreeMapOpTest<int, int>();
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
+TEST_CASE("BtreeMapOfSizetDouble") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  BtreeMapOpTest<size_t, double>();
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
+TEST_CASE("BtreeMapOptimisticReaders") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  {
+    auto map_p = hipc::make_uptr<btree_map<size_t, size_t>>(alloc);
+    auto &map = *map_p;
+    size_t count = 20000;
+    std::atomic<size_t> errors = 0;
+
+    // Thread 0 inserts while the others read the keys already inserted
+    std::atomic<size_t> inserted = 0;
+    omp_set_dynamic(0);
+#pragma omp parallel shared(map, errors, inserted) num_threads(4)
+    {
+      int rank = omp_get_thread_num();
+      if (rank == 0) {
+        for (size_t i = 0; i < count; ++i) {
+          map.emplace(i, i * 3);
+          inserted.store(i + 1);
+        }
+      } else {
+        std::vector<btree_map_entry<size_t, size_t>> out(64);
+        while (inserted.load() < count) {
+          size_t hi = inserted.load();
+          if (hi == 0) { continue; }
+          size_t key = (hi * 31 + rank) % hi;
+          size_t val;
+          if (!map.lookup(key, val) || val != key * 3) {
+            errors.fetch_add(1);
+          }
+          size_t lo = key > 32 ? key - 32 : 0;
+          size_t n = map.scan(lo, key + 1, out.data(), out.size());
+          if (n != key + 1 - lo) {
+            errors.fetch_add(1);
+          }
+          for (size_t i = 0; i < n; ++i) {
+            if (out[i].key_ != lo + i || out[i].val_ != (lo + i) * 3) {
+              errors.fetch_add(1);
+            }
+          }
+        }
+      }
+    }
+    REQUIRE(errors.load() == 0);
+    REQUIRE(map.size() == count);
+  }
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
+TEST_CASE("BtreeMapSlidingWindow") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  {
+    auto map_p = hipc::make_uptr<btree_map<size_t, size_t>>(alloc);
+    auto &map = *map_p;
+    size_t window = 2048;
+    size_t steps = 40 * window;
+
+    // Insert new keys at the right while erasing the oldest at the left
+    for (size_t i = 0; i < window; ++i) {
+      map.emplace(i, i);
+    }
+    size_t steady_size = 0;
+    for (size_t i = 0; i < steps; ++i) {
+      REQUIRE(map.emplace(i + window, i + window));
+      REQUIRE(map.erase(i));
+      if (i + 1 == 2 * window) {
+        steady_size = alloc->GetCurrentlyAllocatedSize();
+      }
+    }
+    REQUIRE(map.size() == window);
+
+    // Drained nodes are reused, so memory stops growing
+    REQUIRE(alloc->GetCurrentlyAllocatedSize() <= steady_size * 3 / 2);
+    size_t i = steps;
+    for (auto &entry : map) {
+      REQUIRE(entry.GetKey() == i);
+      ++i;
+    }
+    REQUIRE(i == steps + window);
+    std::vector<btree_map_entry<size_t, size_t>> out(2 * window);
+    REQUIRE(map.scan(0, SIZE_MAX, out.data(), out.size()) == window);
+    REQUIRE(out[0].GetKey() == steps);
+
+    // Erasing everything leaves a single empty root leaf
+    for (size_t i = steps; i < steps + window; ++i) {
+      REQUIRE(map.erase(i));
+    }
+    REQUIRE(map.size() == 0);
+    REQUIRE(map.height() == 1);
+    REQUIRE(map.begin() == map.end());
+    REQUIRE(map.scan(0, SIZE_MAX, out.data(), out.size()) == 0);
+    REQUIRE(map.try_emplace(5, 5));
+    REQUIRE((*map.begin()).GetKey() == 5);
+  }
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
+TEST_CASE("BtreeMapOptimisticReadersDuringErase") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  {
+    auto map_p = hipc::make_uptr<btree_map<size_t, size_t>>(alloc);
+    auto &map = *map_p;
+    size_t window = 512;
+    size_t steps = 20000;
+    size_t perm = (size_t)1 << 40;
+    size_t num_perm = 64;
+    std::atomic<size_t> errors = 0;
+    std::atomic<bool> done = false;
+
+    // Keys past perm are never erased. A scan that reaches them crosses
+    // every leaf unlinked at the left of the window.
+    for (size_t i = 0; i < num_perm; ++i) {
+      map.emplace(perm + i, (perm + i) * 3);
+    }
+    for (size_t i = 0; i < window; ++i) {
+      map.emplace(i, i * 3);
+    }
+    omp_set_dynamic(0);
+#pragma omp parallel shared(map, errors, done) num_threads(4)
+    {
+      int rank = omp_get_thread_num();
+      if (rank == 0) {
+        for (size_t i = 0; i < steps; ++i) {
+          map.emplace(i + window, (i + window) * 3);
+          map.erase(i);
+        }
+        done.store(true);
+      } else {
+        // A scan is not a snapshot: it may see keys erased behind it and
+        // keys inserted ahead of it
+        std::vector<btree_map_entry<size_t, size_t>> out(
+          steps + window + num_perm);
+        size_t iter = 0;
+        while (!done.load()) {
+          size_t key = (iter++ * 7919 + rank) % (steps + window);
+          size_t val;
+          if (map.lookup(key, val) && val != key * 3) {
+            errors.fetch_add(1);
+          }
+          size_t n = map.scan(key, perm + num_perm, out.data(), out.size());
+          if (n < num_perm) {
+            errors.fetch_add(1);
+            continue;
+          }
+          for (size_t i = 0; i < n; ++i) {
+            if (out[i].val_ != out[i].key_ * 3 ||
+                (i > 0 && !(out[i - 1].key_ < out[i].key_))) {
+              errors.fetch_add(1);
+            }
+          }
+          for (size_t i = 0; i < num_perm; ++i) {
+            if (out[n - num_perm + i].key_ != perm + i) {
+              errors.fetch_add(1);
+            }
+          }
+        }
+      }
+    }
+    REQUIRE(errors.load() == 0);
+    REQUIRE(map.size() == window + num_perm);
+  }
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
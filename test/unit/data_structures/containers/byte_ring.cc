@@ -0,0 +1,215 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+* Distributed under BSD 3-Clause license.                                   *
+* Copyright by The HDF Group.                                               *
+* Copyright by the Illinois Institute of Technology.                        *
+* All rights reserved.                                                      *
+*                                                                           *
+* This file is part of Hermes. The full Hermes copyright notice, including  *
+* terms governing use, modification, and redistribution, is contained in    *
+* the COPYING file, which can be found at the top directory. If you do not  *
+* have access to the file, you may request a copy from help@hdfgroup.org.   *
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "basic_test.h"
+#include "test_init.h"
+#include "omp.h"
+#include "hermes_shm/data_structures/ipc/byte_ring.h"
+
+/** The length of the \a i-th message of a producer */
+static size_t MessageLength(size_t i) {
+  return 2 * sizeof(uint32_t) + (i * 37) % 200;
+}
+
+/**
+ * Producers push messages of varying length, tagged with their rank and
+ * sequence number, while one consumer checks them in place.
+ * */
+template<typename RingT>
+void ProduceAndConsumeBytes(size_t nproducers,
+                            size_t count_per_rank,
+                            size_t capacity) {
+  auto ring = hipc::make_uptr<RingT>(capacity);
+  std::vector<uint32_t> next_seq(nproducers, 0);
+
+  omp_set_dynamic(0);
+#pragma omp parallel shared(ring, next_seq) num_threads(nproducers + 1)  // NOLINT
+  {  // NOLINT
+    size_t rank = omp_get_thread_num();
+    if (rank < nproducers) {
+      // Producer
+      for (size_t i = 0; i < count_per_rank; ++i) {
+        size_t len = MessageLength(i);
+        char *data;
+        while ((data = ring->reserve(len)) == nullptr) {
+          HERMES_THREAD_MODEL->Yield();
+        }
+        auto hdr = reinterpret_cast<uint32_t*>(data);
+        hdr[0] = static_cast<uint32_t>(rank);
+        hdr[1] = static_cast<uint32_t>(i);
+        memset(data + 2 * sizeof(uint32_t), static_cast<char>(rank + i),
+               len - 2 * sizeof(uint32_t));
+        ring->commit(data);
+      }
+    } else {
+      // Consumer
+      size_t count = 0;
+      while (count < nproducers * count_per_rank) {
+        size_t len;
+        char *data = ring->peek(len);
+        if (data == nullptr) {
+          HERMES_THREAD_MODEL->Yield();
+          continue;
+        }
+        auto hdr = reinterpret_cast<uint32_t*>(data);
+        uint32_t src = hdr[0], seq = hdr[1];
+        REQUIRE(src < nproducers);
+        REQUIRE(seq == next_seq[src]);
+        REQUIRE(len == MessageLength(seq));
+        for (size_t j = 2 * sizeof(uint32_t); j < len; ++j) {
+          REQUIRE(data[j] == static_cast<char>(src + seq));
+        }
+        ring->release();
+        ++next_seq[src];
+        ++count;
+      }
+      size_t len;
+      REQUIRE(ring->peek(len) == nullptr);
+      REQUIRE(ring->GetSize() == 0);
+    }
+  }
+  for (size_t i = 0; i < nproducers; ++i) {
+    REQUIRE(next_seq[i] == count_per_rank);
+  }
+}
+
+/**
+ * TEST BYTE RING
+ * */
+
+TEST_CASE("TestByteRingWrap") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  {
+    // The capacity is rounded up to a power of two
+    auto ring = hipc::make_uptr<hipc::spsc_byte_ring>(200);
+    REQUIRE(ring->GetCapacity() == 256);
+    REQUIRE(ring->GetMaxMessageSize() == 120);
+
+    // Messages take their length rounded up to 8, plus an 8-byte header
+    for (int i = 0; i < 3; ++i) {
+      REQUIRE(ring->push(&i, sizeof(i)));
+    }
+    REQUIRE(ring->GetSize() == 48);
+    char buf[256];
+    for (int i = 0; i < 3; ++i) {
+      size_t len;
+      char *data = ring->peek(len);
+      REQUIRE(data != nullptr);
+      REQUIRE(len == sizeof(int));
+      REQUIRE(*reinterpret_cast<int*>(data) == i);
+      ring->release();
+    }
+    size_t len;
+    REQUIRE(ring->peek(len) == nullptr);
+
+    // A message that would cross the end of the ring starts over at 0
+    memset(buf, 1, 100);
+    REQUIRE(ring->push(buf, 100));
+    memset(buf, 2, 120);
+    REQUIRE(!ring->push(buf, 120));
+    REQUIRE(ring->pop(buf, sizeof(buf), len));
+    REQUIRE(len == 100);
+    REQUIRE(buf[99] == 1);
+    memset(buf, 2, 120);
+    REQUIRE(ring->push(buf, 120));
+    REQUIRE(ring->GetSize() == 96 + 128);
+    REQUIRE(ring->pop(buf, sizeof(buf), len));
+    REQUIRE(len == 120);
+    REQUIRE(buf[0] == 2);
+    REQUIRE(buf[119] == 2);
+    REQUIRE(!ring->pop(buf, sizeof(buf), len));
+    REQUIRE(ring->GetSize() == 0);
+  }
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
+TEST_CASE("TestByteRingFull") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  {
+    auto ring = hipc::make_uptr<hipc::byte_ring>(256);
+    char buf[64] = {0};
+    for (int i = 0; i < 4; ++i) {
+      REQUIRE(ring->push(buf, 56));
+    }
+    REQUIRE(ring->GetSize() == 256);
+    REQUIRE(ring->reserve(1) == nullptr);
+
+    // Uncommitted messages hold back the consumer
+    size_t len;
+    REQUIRE(ring->pop(buf, sizeof(buf), len));
+    REQUIRE(len == 56);
+    char *data = ring->reserve(8);
+    REQUIRE(data != nullptr);
+    for (int i = 0; i < 3; ++i) {
+      REQUIRE(ring->pop(buf, sizeof(buf), len));
+      REQUIRE(len == 56);
+    }
+    REQUIRE(ring->peek(len) == nullptr);
+    ring->commit(data);
+    REQUIRE(ring->peek(len) == data);
+    REQUIRE(len == 8);
+    ring->release();
+
+    // Messages beyond half the capacity are rejected
+    REQUIRE_THROWS(ring->reserve(ring->GetMaxMessageSize() + 1));
+
+    // Zero-length messages are distinct from an empty ring
+    REQUIRE(ring->push(buf, 0));
+    len = 1;
+    REQUIRE(ring->pop(buf, sizeof(buf), len));
+    REQUIRE(len == 0);
+    REQUIRE(!ring->pop(buf, sizeof(buf), len));
+    REQUIRE(ring->GetSize() == 0);
+  }
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
+TEST_CASE("TestByteRingMove") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  {
+    auto ring = hipc::make_uptr<hipc::byte_ring>(256);
+    for (int i = 0; i < 4; ++i) {
+      REQUIRE(ring->push(&i, sizeof(i)));
+    }
+    int val;
+    size_t len;
+    REQUIRE(ring->pop(&val, sizeof(val), len));
+    REQUIRE(len == sizeof(val));
+    auto copy = hipc::make_uptr<hipc::byte_ring>(*ring);
+    auto moved = hipc::make_uptr<hipc::byte_ring>(std::move(*ring));
+    REQUIRE(ring->IsNull());
+    for (int i = 1; i < 4; ++i) {
+      REQUIRE(copy->pop(&val, sizeof(val), len));
+      REQUIRE(val == i);
+      REQUIRE(moved->pop(&val, sizeof(val), len));
+      REQUIRE(val == i);
+    }
+  }
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
+TEST_CASE("TestByteRingSpscMultiThreaded") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  ProduceAndConsumeBytes<hipc::spsc_byte_ring>(1, 8192, 1024);
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
+TEST_CASE("TestByteRingMpscMultiThreaded") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  ProduceAndConsumeBytes<hipc::byte_ring>(4, 4096, 1024);
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
@@ -0,0 +1,164 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+* Distributed under BSD 3-Clause license.                                   *
+* Copyright by The HDF Group.                                               *
+* Copyright by the Illinois Institute of Technology.                        *
+* All rights reserved.                                                      *
+*                                                                           *
+* This file is part of Hermes. The full Hermes copyright notice, including  *
+* terms governing use, modification, and redistribution, is contained in    *
+* the COPYING file, which can be found at the top directory. If you do not  *
+* have access to the file, you may request a copy from help@hdfgroup.org.   *
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "basic_test.h"
+#include "test_init.h"
+#include "hermes_shm/data_structures/ipc/dense_unordered_map.h"
+#include "hermes_shm/data_structures/ipc/string.h"
+
+using hshm::ipc::Allocator;
+using hshm::ipc::dense_unordered_map;
+using hshm::ipc::string;
+
+#define GET_INT_FROM_KEY(VAR) CREATE_GET_INT_FROM_VAR(Key, key_ret, VAR)
+#define GET_INT_FROM_VAL(VAR) CREATE_GET_INT_FROM_VAR(Val, val_ret, VAR)
+
+#define CREATE_KV_PAIR(KEY_NAME, KEY, VAL_NAME, VAL)\
+  CREATE_SET_VAR_TO_INT_OR_STRING(Key, KEY_NAME, KEY); \
+  CREATE_SET_VAR_TO_INT_OR_STRING(Val, VAL_NAME, VAL);
+
+template<typename Key, typename Val>
+void DenseUnorderedMapOpTest() {
+  Allocator *alloc = alloc_g;
+  auto map_p = hipc::make_uptr<dense_unordered_map<Key, Val>>(alloc, 5);
+  auto &map = *map_p;
+
+  // Insert 100 entries into the map (triggers growth)
+  PAGE_DIVIDE("Insert entries") {
+    for (int i = 0; i < 100; ++i) {
+      CREATE_KV_PAIR(key, i, val, i);
+      REQUIRE(map.try_emplace(key, val));
+    }
+    REQUIRE(map.size() == 100);
+    REQUIRE(map.get_num_buckets() > 100);
+  }
+
+  // Iteration follows insertion order
+  PAGE_DIVIDE("Forward iterate") {
+    int i = 0;
+    for (auto &entry : map) {
+      GET_INT_FROM_KEY(entry.GetKey());
+      GET_INT_FROM_VAL(entry.GetVal());
+      REQUIRE(key_ret == i);
+      REQUIRE(val_ret == i);
+      ++i;
+    }
+    REQUIRE(i == 100);
+  }
+
+  // Find and modify entries
+  PAGE_DIVIDE("Modify entries") {
+    for (int i = 0; i < 100; ++i) {
+      CREATE_KV_PAIR(key, i, val, i + 1);
+      REQUIRE(!map.try_emplace(key, val));
+      REQUIRE(map.emplace(key, val));
+      GET_INT_FROM_VAL(map[key]);
+      REQUIRE(val_ret == i + 1);
+    }
+    REQUIRE(map.size() == 100);
+    CREATE_KV_PAIR(key, 100, val, 0);
+    REQUIRE(map.find(key) == map.end());
+    REQUIRE_THROWS(map[key]);
+  }
+
+  // Erase the even entries; the odd ones stay findable
+  PAGE_DIVIDE("Erase entries") {
+    for (int i = 0; i < 100; i += 2) {
+      CREATE_KV_PAIR(key, i, val, 0);
+      map.erase(key);
+    }
+    REQUIRE(map.size() == 50);
+    for (int i = 0; i < 100; ++i) {
+      CREATE_KV_PAIR(key, i, val, 0);
+      auto iter = map.find(key);
+      REQUIRE(iter.is_end() == (i % 2 == 0));
+      if (!iter.is_end()) {
+        GET_INT_FROM_VAL((*iter).GetVal());
+        REQUIRE(val_ret == i + 1);
+      }
+    }
+  }
+
+  // Erase through an iterator
+  PAGE_DIVIDE("Erase with iterators") {
+    size_t count = 0;
+    for (auto iter = map.begin(); !iter.is_end();) {
+      GET_INT_FROM_KEY((*iter).GetKey());
+      if (key_ret % 4 == 1) {
+        map.erase(iter);
+      } else {
+        ++iter;
+      }
+      ++count;
+    }
+    REQUIRE(count == 50);
+    REQUIRE(map.size() == 25);
+    for (auto &entry : map) {
+      GET_INT_FROM_KEY(entry.GetKey());
+      REQUIRE(key_ret % 4 == 3);
+      REQUIRE(map.find(entry.GetKey()) != map.end());
+    }
+  }
+
+  // Copy the map
+  PAGE_DIVIDE("Copy the map") {
+    auto cpy = hipc::make_uptr<dense_unordered_map<Key, Val>>(alloc, map);
+    REQUIRE(cpy->size() == 25);
+    for (int i = 3; i < 100; i += 4) {
+      CREATE_KV_PAIR(key, i, val, 0);
+      GET_INT_FROM_VAL((*cpy)[key]);
+      REQUIRE(val_ret == i + 1);
+    }
+  }
+
+  // Move the map
+  PAGE_DIVIDE("Move the map") {
+    auto cpy = hipc::make_uptr<dense_unordered_map<Key, Val>>(alloc);
+    (*cpy) = std::move(map);
+    REQUIRE(cpy->size() == 25);
+    map = std::move(*cpy);
+    REQUIRE(map.size() == 25);
+  }
+
+  // Clear the map
+  PAGE_DIVIDE("Clear the map") {
+    map.clear();
+    REQUIRE(map.size() == 0);
+    REQUIRE(map.begin() == map.end());
+    CREATE_KV_PAIR(key, 3, val, 0);
+    REQUIRE(map.find(key).is_end());
+    REQUIRE(map.emplace(key, val));
+    REQUIRE(map.size() == 1);
+  }
+}
+
+TEST_CASE("DenseUnorderedMapOfIntInt") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  DenseUnorderedMapOpTest<int, int>();
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
+TEST_CASE("DenseUnorderedMapOfIntString") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  DenseUnorderedMapOpTest<int, string>();
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
+TEST_CASE("DenseUnorderedMapOfStringString") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  DenseUnorderedMapOpTest<string, string>();
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
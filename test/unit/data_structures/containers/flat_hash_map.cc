@@ -0,0 +1,136 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+* Distributed under BSD 3-Clause license.                                   *
+* Copyright by The HDF Group.                                               *
+* Copyright by the Illinois Institute of Technology.                        *
+* All rights reserved.                                                      *
+*                                                                           *
+* This file is part of Hermes. The full Hermes copyright notice, including  *
+* terms governing use, modification, and redistribution, is contained in    *
+* the COPYING file, which can be found at the top directory. If you do not  *
+* have access to the file, you may request a copy from help@hdfgroup.org.   *
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "basic_test.h"
+#include "test_init.h"
+#include "hermes_shm/data_structures/ipc/flat_hash_map.h"
+
+using hshm::ipc::Allocator;
+using hshm::ipc::flat_hash_map;
+
+template<typename Key, typename Val>
+void FlatHashMapOpTest() {
+  Allocator *alloc = alloc_g;
+  auto map_p = hipc::make_uptr<flat_hash_map<Key, Val>>(alloc);
+  auto &map = *map_p;
+  Key count = 10000;
+
+  // Insert entries, forcing several growths
+  PAGE_DIVIDE("Insert entries") {
+    for (Key i = 0; i < count; ++i) {
+      REQUIRE(map.emplace(i, static_cast<Val>(i)));
+    }
+    REQUIRE(map.size() == (size_t)count);
+    REQUIRE(map.capacity() >= (size_t)count);
+  }
+
+  // Find and index every entry
+  PAGE_DIVIDE("Find entries") {
+    for (Key i = 0; i < count; ++i) {
+      auto iter = map.find(i);
+      REQUIRE(!iter.is_end());
+      REQUIRE((*iter).GetKey() == i);
+      REQUIRE(map[i] == static_cast<Val>(i));
+    }
+    REQUIRE(map.find(count).is_end());
+    REQUIRE_THROWS(map[count]);
+  }
+
+  // Iterate over the map
+  PAGE_DIVIDE("Forward iterate") {
+    std::vector<Key> keys;
+    for (auto &entry : map) {
+      REQUIRE(entry.GetVal() == static_cast<Val>(entry.GetKey()));
+      keys.emplace_back(entry.GetKey());
+    }
+    std::sort(keys.begin(), keys.end());
+    REQUIRE(keys.size() == (size_t)count);
+    for (Key i = 0; i < count; ++i) {
+      REQUIRE(keys[i] == i);
+    }
+  }
+
+  // Modify entries
+  PAGE_DIVIDE("Modify entries") {
+    for (Key i = 0; i < count; ++i) {
+      REQUIRE(!map.try_emplace(i, static_cast<Val>(i + 1)));
+      REQUIRE(map.emplace(i, static_cast<Val>(i + 1)));
+      REQUIRE(map[i] == static_cast<Val>(i + 1));
+    }
+    REQUIRE(map.size() == (size_t)count);
+  }
+
+  // Erase half of the entries, then insert them again
+  PAGE_DIVIDE("Erase and reinsert entries") {
+    size_t capacity = map.capacity();
+    for (int round = 0; round < 4; ++round) {
+      for (Key i = 0; i < count; i += 2) {
+        map.erase(i);
+      }
+      REQUIRE(map.size() == (size_t)count / 2);
+      for (Key i = 0; i < count; ++i) {
+        REQUIRE(map.find(i).is_end() == (i % 2 == 0));
+      }
+      for (Key i = 0; i < count; i += 2) {
+        REQUIRE(map.emplace(i, static_cast<Val>(i + 1)));
+      }
+      REQUIRE(map.size() == (size_t)count);
+    }
+    REQUIRE(map.capacity() == capacity);
+  }
+
+  // Copy the map
+  PAGE_DIVIDE("Copy the map") {
+    auto cpy = hipc::make_uptr<flat_hash_map<Key, Val>>(alloc, map);
+    REQUIRE(cpy->size() == (size_t)count);
+    for (Key i = 0; i < count; ++i) {
+      REQUIRE((*cpy)[i] == static_cast<Val>(i + 1));
+    }
+  }
+
+  // Move the map
+  PAGE_DIVIDE("Move the map") {
+    auto cpy = hipc::make_uptr<flat_hash_map<Key, Val>>(alloc);
+    (*cpy) = std::move(map);
+    REQUIRE(map.size() == 0);
+    REQUIRE(map.find(0).is_end());
+    for (Key i = 0; i < count; ++i) {
+      REQUIRE((*cpy)[i] == static_cast<Val>(i + 1));
+    }
+    map = std::move(*cpy);
+  }
+
+  // Clear the map
+  PAGE_DIVIDE("Clear the map") {
+    map.clear();
+    REQUIRE(map.size() == 0);
+    REQUIRE(map.begin() == map.end());
+    for (Key i = 0; i < count; ++i) {
+      REQUIRE(map.find(i).is_end());
+    }
+  }
+}
+
+TEST_CASE("FlatHashMapOfIntInt") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  FlatHashMapOpTest<int, int>();
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
+TEST_CASE("FlatHashMapOfSizetDouble") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  FlatHashMapOpTest<size_t, double>();
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
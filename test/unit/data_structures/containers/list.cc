@@ -61,3 +61,22 @@ TEST_CASE("ListOfStdString") {
   ListTest<std::string>();
   REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
 }
+
+template<typename T>
+void ListNodePoolTest(size_t max_free, size_t chunk_nodes) {
+  Allocator *alloc = alloc_g;
+  auto lp = hipc::make_uptr<list<T>>(alloc);
+  lp->enable_node_pool(max_free, chunk_nodes);
+  ListTestSuite<T, list<T>> test(*lp, alloc);
+  test.NodePoolTest(chunk_nodes);
+}
+
+TEST_CASE("ListNodePool") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  ListNodePoolTest<int>(8, 1);
+  ListNodePoolTest<int>(8, 32);
+  ListNodePoolTest<hipc::string>(8, 1);
+  ListNodePoolTest<hipc::string>(128, 32);
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
@@ -142,6 +142,50 @@ class ListTestSuite {
     REQUIRE(obj_.size() == 0);
   }
 
+  /// Recycle nodes through the node pool. The list must start out empty.
+  void NodePoolTest(size_t chunk_nodes) {
+    EmplaceTest(64);
+    ForwardIteratorTest();
+    REQUIRE_THROWS(obj_.enable_node_pool(8, chunk_nodes));
+
+    // Nodes carved from one chunk are adjacent
+    if (chunk_nodes > 1) {
+      auto iter = obj_.begin();
+      for (size_t i = 1; i < chunk_nodes && i < 64; ++i) {
+        auto next = iter + 1;
+        REQUIRE((char*)next.entry_ - (char*)iter.entry_ ==
+                sizeof(*iter.entry_));
+        iter = next;
+      }
+    }
+
+    // Queue-like usage does not touch the allocator once every entry
+    // holds a value of the same size
+    size_t alloc_size = 0;
+    for (size_t i = 0; i < 320; ++i) {
+      if (i == 64) {
+        alloc_size = alloc_->GetCurrentlyAllocatedSize();
+      }
+      CREATE_SET_VAR_TO_INT_OR_STRING(T, var, 10 + i % 90);
+      obj_.emplace_back(var);
+      obj_.erase(obj_.begin());
+    }
+    REQUIRE(obj_.size() == 64);
+    REQUIRE(alloc_->GetCurrentlyAllocatedSize() == alloc_size);
+
+    // Insert in the middle of the list
+    obj_.clear();
+    for (size_t i = 0; i < 3; i += 2) {
+      CREATE_SET_VAR_TO_INT_OR_STRING(T, var, i);
+      obj_.emplace_back(var);
+    }
+    CREATE_SET_VAR_TO_INT_OR_STRING(T, var, 1);
+    obj_.emplace(obj_.begin() + 1, var);
+    REQUIRE(obj_.size() == 3);
+    ForwardIteratorTest();
+    obj_.clear();
+  }
+
  private:
   /// Verify copy construct/assign worked
   void VerifyCopy(Container &obj,
@@ -0,0 +1,224 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+* Distributed under BSD 3-Clause license.                                   *
+* Copyright by The HDF Group.                                               *
+* Copyright by the Illinois Institute of Technology.                        *
+* All rights reserved.                                                      *
+*                                                                           *
+* This file is part of Hermes. The full Hermes copyright notice, including  *
+* terms governing use, modification, and redistribution, is contained in    *
+* the COPYING file, which can be found at the top directory. If you do not  *
+* have access to the file, you may request a copy from help@hdfgroup.org.   *
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "basic_test.h"
+#include "test_init.h"
+#include "omp.h"
+#include "hermes_shm/data_structures/ipc/lru_cache.h"
+#include "hermes_shm/data_structures/ipc/string.h"
+
+using hshm::ipc::Allocator;
+using hshm::ipc::lru_cache;
+using hshm::ipc::string;
+
+#define GET_INT_FROM_KEY(VAR) CREATE_GET_INT_FROM_VAR(Key, key_ret, VAR)
+#define GET_INT_FROM_VAL(VAR) CREATE_GET_INT_FROM_VAR(Val, val_ret, VAR)
+
+#define CREATE_KV_PAIR(KEY_NAME, KEY, VAL_NAME, VAL)\
+  CREATE_SET_VAR_TO_INT_OR_STRING(Key, KEY_NAME, KEY); \
+  CREATE_SET_VAR_TO_INT_OR_STRING(Val, VAL_NAME, VAL);
+
+template<typename Key, typename Val>
+void LruCacheOpTest() {
+  Allocator *alloc = alloc_g;
+  auto cache_p = hipc::make_uptr<lru_cache<Key, Val>>(alloc, 32);
+  auto &cache = *cache_p;
+
+  // Without hits, entries are evicted in insertion order
+  PAGE_DIVIDE("Insert past capacity") {
+    std::vector<int> evicted;
+    for (int i = 0; i < 100; ++i) {
+      CREATE_KV_PAIR(key, i, val, i);
+      REQUIRE(cache.put(key, val, 0, [&evicted](Key &key, Val &val) {
+        GET_INT_FROM_KEY(key);
+        GET_INT_FROM_VAL(val);
+        REQUIRE(key_ret == val_ret);
+        evicted.emplace_back(key_ret);
+      }));
+    }
+    REQUIRE(cache.size() == 32);
+    REQUIRE(evicted.size() == 68);
+    for (int i = 0; i < 68; ++i) {
+      REQUIRE(evicted[i] == i);
+    }
+  }
+
+  // Get the remaining entries
+  PAGE_DIVIDE("Get entries") {
+    for (int i = 0; i < 100; ++i) {
+      CREATE_KV_PAIR(key, i, val, -1);
+      REQUIRE(cache.get(key, val) == (i >= 68));
+      if (i >= 68) {
+        GET_INT_FROM_VAL(val);
+        REQUIRE(val_ret == i);
+      }
+    }
+  }
+
+  // Replace an entry
+  PAGE_DIVIDE("Replace entries") {
+    CREATE_KV_PAIR(key, 70, val, 700);
+    REQUIRE(cache.put(key, val));
+    REQUIRE(cache.size() == 32);
+    CREATE_KV_PAIR(key2, 70, val2, -1);
+    REQUIRE(cache.get(key2, val2));
+    GET_INT_FROM_VAL(val2);
+    REQUIRE(val_ret == 700);
+  }
+
+  // Erase an entry
+  PAGE_DIVIDE("Erase entries") {
+    CREATE_KV_PAIR(key, 70, val, 0);
+    REQUIRE(cache.erase(key));
+    REQUIRE(!cache.erase(key));
+    REQUIRE(!cache.contains(key));
+    REQUIRE(cache.size() == 31);
+  }
+
+  // Copy the cache
+  PAGE_DIVIDE("Copy the cache") {
+    auto cpy = hipc::make_uptr<lru_cache<Key, Val>>(alloc, cache);
+    REQUIRE(cpy->size() == 31);
+    REQUIRE(cpy->capacity() == 32);
+    for (int i = 68; i < 100; ++i) {
+      CREATE_KV_PAIR(key, i, val, 0);
+      REQUIRE(cpy->contains(key) == (i != 70));
+    }
+  }
+
+  // Move the cache
+  PAGE_DIVIDE("Move the cache") {
+    auto cpy = hipc::make_uptr<lru_cache<Key, Val>>(alloc);
+    (*cpy) = std::move(cache);
+    REQUIRE(cache.size() == 0);
+    REQUIRE(cpy->size() == 31);
+    cache = std::move(*cpy);
+  }
+
+  // Clear the cache
+  PAGE_DIVIDE("Clear the cache") {
+    cache.clear();
+    REQUIRE(cache.size() == 0);
+    REQUIRE(cache.begin() == cache.end());
+    CREATE_KV_PAIR(key, 99, val, 0);
+    REQUIRE(!cache.contains(key));
+  }
+}
+
+TEST_CASE("LruCacheOfIntInt") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  LruCacheOpTest<int, int>();
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
+TEST_CASE("LruCacheOfStringString") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  LruCacheOpTest<string, string>();
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
+TEST_CASE("LruCacheClock") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  {
+    auto cache_p = hipc::make_uptr<lru_cache<int, int>>(alloc, 4);
+    auto &cache = *cache_p;
+    std::vector<int> evicted;
+    auto evict = [&evicted](int &key, int &val) {
+      evicted.emplace_back(key);
+    };
+    for (int i = 0; i < 4; ++i) {
+      cache.put(i, i, 0, evict);
+    }
+
+    // Recently used entries get a second chance
+    int val;
+    REQUIRE(cache.get(0, val));
+    REQUIRE(cache.get(1, val));
+    cache.put(4, 4, 0, evict);
+    cache.put(5, 5, 0, evict);
+    REQUIRE(evicted == std::vector<int>{2, 3});
+    REQUIRE(cache.contains(0));
+    REQUIRE(cache.contains(1));
+
+    // Their bits were cleared by the sweep, so they go next
+    cache.put(6, 6, 0, evict);
+    REQUIRE(evicted == std::vector<int>{2, 3, 0});
+  }
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
+TEST_CASE("LruCacheBytes") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  {
+    auto cache_p = hipc::make_uptr<lru_cache<int, int>>(alloc, 100, 1000);
+    auto &cache = *cache_p;
+    REQUIRE(cache.capacity_bytes() == 1000);
+    for (int i = 0; i < 10; ++i) {
+      REQUIRE(cache.put(i, i, 100));
+    }
+    REQUIRE(cache.size_bytes() == 1000);
+
+    // A large entry evicts several small ones
+    REQUIRE(cache.put(10, 10, 250));
+    REQUIRE(cache.size() == 8);
+    REQUIRE(cache.size_bytes() == 950);
+    for (int i = 0; i < 3; ++i) {
+      REQUIRE(!cache.contains(i));
+    }
+
+    // Growing an entry also evicts
+    REQUIRE(cache.put(10, 10, 400));
+    REQUIRE(cache.size_bytes() == 1000);
+    REQUIRE(cache.size() == 7);
+    REQUIRE(cache.contains(10));
+
+    // An entry larger than the cache is rejected
+    REQUIRE(!cache.put(11, 11, 1001));
+    REQUIRE(!cache.contains(11));
+  }
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
+TEST_CASE("LruCacheConcurrent") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  {
+    auto cache_p = hipc::make_uptr<lru_cache<size_t, size_t>>(alloc, 256);
+    auto &cache = *cache_p;
+    int nthreads = 8;
+    size_t count = 10000;
+    std::atomic<size_t> errors = 0;
+
+    // Every thread puts and gets keys from an overlapping range
+    omp_set_dynamic(0);
+#pragma omp parallel shared(cache, errors) num_threads(nthreads)
+    {
+      size_t rank = omp_get_thread_num();
+      for (size_t i = 0; i < count; ++i) {
+        size_t key = (i * 31 + rank) % 512;
+        cache.put(key, key * 3);
+        size_t val;
+        if (cache.get(key, val) && val != key * 3) {
+          errors.fetch_add(1);
+        }
+      }
+    }
+    REQUIRE(errors.load() == 0);
+    REQUIRE(cache.size() <= 256);
+  }
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
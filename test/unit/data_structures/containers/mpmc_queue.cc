@@ -0,0 +1,84 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+* Distributed under BSD 3-Clause license.                                   *
+* Copyright by The HDF Group.                                               *
+* Copyright by the Illinois Institute of Technology.                        *
+* All rights reserved.                                                      *
+*                                                                           *
+* This file is part of Hermes. The full Hermes copyright notice, including  *
+* terms governing use, modification, and redistribution, is contained in    *
+* the COPYING file, which can be found at the top directory. If you do not  *
+* have access to the file, you may request a copy from help@hdfgroup.org.   *
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "basic_test.h"
+#include "test_init.h"
+#include "hermes_shm/data_structures/ipc/mpmc_queue.h"
+#include "queue.h"
+
+/**
+ * TEST MPMC QUEUE
+ * */
+
+TEST_CASE("TestMpmcQueueInt") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  ProduceThenConsume<hipc::mpmc_queue<int>, int>(1, 1, 32, 32);
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
+TEST_CASE("TestMpmcQueueString") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  ProduceThenConsume<hipc::mpmc_queue<hipc::string>, hipc::string>(
+    1, 1, 32, 32);
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
+TEST_CASE("TestMpmcQueueFull") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  {
+    auto queue = hipc::make_uptr<hipc::mpmc_queue<hipc::string>>(5);
+    REQUIRE(queue->GetDepth() == 8);
+    for (int i = 0; i < 8; ++i) {
+      REQUIRE(!queue->emplace(std::to_string(i)).IsNull());
+    }
+    REQUIRE(queue->emplace("full").IsNull());
+    REQUIRE(queue->GetSize() == 8);
+
+    // Copies keep the order of the live entries
+    auto copy = hipc::make_uptr<hipc::mpmc_queue<hipc::string>>(*queue);
+    auto entry_ptr = hipc::make_uptr<hipc::string>();
+    hipc::string &entry = *entry_ptr;
+    REQUIRE(!queue->pop(entry).IsNull());
+    REQUIRE(entry == "0");
+    REQUIRE(!queue->emplace("8").IsNull());
+    for (int i = 0; i < 8; ++i) {
+      REQUIRE(!copy->pop(entry).IsNull());
+      REQUIRE(entry == std::to_string(i));
+    }
+    REQUIRE(copy->pop(entry).IsNull());
+
+    // Leave entries behind for shm_destroy to clean up
+    REQUIRE(queue->GetSize() == 8);
+  }
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
+TEST_CASE("TestMpmcQueueIntMultiThreaded") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  ProduceThenConsume<hipc::mpmc_queue<int>, int>(8, 1, 8192, 8192 * 8);
+  ProduceThenConsume<hipc::mpmc_queue<int>, int>(8, 8, 8192, 8192 * 8);
+  ProduceAndConsume<hipc::mpmc_queue<int>, int>(8, 1, 8192, 64);
+  ProduceAndConsume<hipc::mpmc_queue<int>, int>(8, 8, 8192, 64);
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
+TEST_CASE("TestMpmcQueueStringMultiThreaded") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  ProduceAndConsume<hipc::mpmc_queue<hipc::string>, hipc::string>(
+    4, 4, 2048, 64);
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
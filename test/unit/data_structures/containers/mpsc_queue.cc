@@ -15,6 +15,7 @@
 #include "hermes_shm/data_structures/containers/mpsc_queue.h"
 #include "hermes_shm/data_structures/ipc/mpsc_queue.h"
 #include "hermes_shm/data_structures/ipc/mpsc_ptr_queue.h"
+#include "hermes_shm/util/timer.h"
 #include "queue.h"
 
 /**
@@ -51,6 +52,24 @@ TEST_CASE("TestMpscQueueStringMultiThreaded") {
   REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
 }
 
+TEST_CASE("TestMpscQueuePaddedSlots") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  ProduceThenConsume<hipc::mpsc_queue<hipc::string>, hipc::string>(
+    1, 1, 32, 32, true);
+  ProduceAndConsume<hipc::mpsc_queue<int>, int>(8, 1, 8192, 32, true);
+  ProduceAndConsumeBatched<hipc::mpsc_queue<int>>(8, 8192, 32, 48, true);
+  {
+    // Producer and consumer words never share a cache line
+    auto q = hipc::make_uptr<hipc::mpsc_queue<int>>(32, true);
+    REQUIRE(q->GetDepth() == 32);
+    auto tail = reinterpret_cast<char*>(&q->tail_);
+    auto head = reinterpret_cast<char*>(&q->head_);
+    REQUIRE(head - tail >= HSHM_CACHE_LINE_SIZE);
+  }
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
 TEST_CASE("TestMpscQueuePeek") {
   Allocator *alloc = alloc_g;
   REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
@@ -68,6 +87,71 @@ TEST_CASE("TestMpscQueuePeek") {
   REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
 }
 
+TEST_CASE("TestMpscQueueWait") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+
+  auto q = hipc::make_mptr<hipc::mpsc_queue<int>>(alloc, 4);
+  int val;
+
+  // Waiting on an empty queue times out
+  hshm::Timer t;
+  t.Resume();
+  REQUIRE(q->pop_wait(val, 2000).IsNull());
+  t.Pause();
+  REQUIRE(t.GetUsec() >= 2000);
+
+  // Waiting on a full queue times out without reserving a slot
+  for (int i = 0; i < 4; ++i) {
+    REQUIRE(!q->emplace_wait(HSHM_WAIT_FOREVER, i).IsNull());
+  }
+  REQUIRE(q->emplace_wait(2000, 4).IsNull());
+  REQUIRE(q->GetSize() == 4);
+  for (int i = 0; i < 4; ++i) {
+    REQUIRE(!q->pop_wait(val, 2000).IsNull());
+    REQUIRE(val == i);
+  }
+
+  // Producers and a consumer sleep on a queue much shallower than the data
+  size_t nproducers = 4, count_per_rank = 4096;
+  std::vector<size_t> seen(nproducers * count_per_rank, 0);
+  omp_set_dynamic(0);
+#pragma omp parallel shared(q, seen) num_threads(nproducers + 1)
+  {  // NOLINT
+    size_t rank = omp_get_thread_num();
+    if (rank < nproducers) {
+      for (size_t i = 0; i < count_per_rank; ++i) {
+        int entry = static_cast<int>(rank * count_per_rank + i);
+        if (i % 2) {
+          q->emplace(entry);
+        } else {
+          q->emplace_wait(HSHM_WAIT_FOREVER, entry);
+        }
+      }
+    } else {
+      int entry;
+      for (size_t i = 0; i < seen.size(); ++i) {
+        REQUIRE(!q->pop_wait(entry, HSHM_WAIT_FOREVER).IsNull());
+        seen[entry] += 1;
+      }
+    }
+  }
+  for (size_t count : seen) {
+    REQUIRE(count == 1);
+  }
+  q.shm_destroy();
+
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
+TEST_CASE("TestMpscQueueBatch") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  ProduceAndConsumeBatched<hipc::mpsc_queue<int>>(1, 8192, 32, 48);
+  ProduceAndConsumeBatched<hipc::mpsc_queue<int>>(8, 8192, 32, 48);
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
 /**
  * MPSC Pointer Queue
  * */
@@ -86,6 +170,14 @@ TEST_CASE("TestMpscPtrQueueIntMultiThreaded") {
   REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
 }
 
+TEST_CASE("TestMpscPtrQueueBatch") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  ProduceAndConsumeBatched<hipc::mpsc_ptr_queue<int>>(1, 8192, 32, 48);
+  ProduceAndConsumeBatched<hipc::mpsc_ptr_queue<int>>(8, 8192, 32, 48);
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
 TEST_CASE("TestMpscOffsetPointerQueueCompile") {
   Allocator *alloc = alloc_g;
   auto p = hipc::make_uptr<hipc::mpsc_ptr_queue<hipc::OffsetPointer>>(alloc);
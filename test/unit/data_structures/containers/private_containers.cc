@@ -0,0 +1,128 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+* Distributed under BSD 3-Clause license.                                   *
+* Copyright by The HDF Group.                                               *
+* Copyright by the Illinois Institute of Technology.                        *
+* All rights reserved.                                                      *
+*                                                                           *
+* This file is part of Hermes. The full Hermes copyright notice, including  *
+* terms governing use, modification, and redistribution, is contained in    *
+* the COPYING file, which can be found at the top directory. If you do not  *
+* have access to the file, you may request a copy from help@hdfgroup.org.   *
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "basic_test.h"
+#include "test_init.h"
+#include "vector.h"
+#include "hermes_shm/data_structures/ipc/vector.h"
+#include "hermes_shm/data_structures/ipc/list.h"
+#include "hermes_shm/data_structures/ipc/slist.h"
+#include "hermes_shm/data_structures/ipc/string.h"
+
+/**
+ * Runs a test over a MallocAllocator, whose offsets are addresses, and
+ * makes it the default allocator while the test runs.
+ * */
+template<typename FUNC>
+void PrivateTest(FUNC &&test) {
+  std::string shm_url = "test_private_containers";
+  allocator_id_t alloc_id(0, 2);
+  auto mem_mngr = HERMES_MEMORY_MANAGER;
+  mem_mngr->UnregisterAllocator(alloc_id);
+  mem_mngr->UnregisterBackend(shm_url);
+  mem_mngr->CreateBackend<hipc::NullBackend>(MEGABYTES(100), shm_url);
+  mem_mngr->CreateAllocator<hipc::MallocAllocator>(shm_url, alloc_id, 0);
+  Allocator *alloc = mem_mngr->GetAllocator(alloc_id);
+  Allocator *default_alloc = mem_mngr->GetDefaultAllocator();
+  mem_mngr->SetDefaultAllocator(alloc);
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  test(alloc);
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  mem_mngr->SetDefaultAllocator(default_alloc);
+}
+
+template<typename T, typename Container>
+void PrivateListTestRunner(ListTestSuite<T, Container> &test) {
+  test.ForwardIteratorTest();
+  test.ConstForwardIteratorTest();
+  test.CopyConstructorTest();
+  test.CopyAssignmentTest();
+  test.MoveConstructorTest();
+  test.MoveAssignmentTest();
+  test.EmplaceFrontTest();
+  test.ModifyEntryCopyIntoTest();
+  test.ModifyEntryMoveIntoTest();
+  test.EraseTest();
+}
+
+template<typename T>
+void PrivateVectorTest(Allocator *alloc) {
+  auto vec = hipc::make_uptr<hshm::vector<T>>(alloc);
+  VectorTestSuite<T, hshm::vector<T>> test(*vec, alloc);
+  test.EmplaceTest(15);
+  test.IndexTest();
+  PrivateListTestRunner(test);
+
+  // The data pointer is the offset itself
+  vec->resize(4);
+  REQUIRE(vec->data() ==
+          reinterpret_cast<void*>(vec->vec_ptr_.off_.load()));
+}
+
+template<typename ListT, typename T>
+void PrivateListTest(Allocator *alloc) {
+  auto lp = hipc::make_uptr<ListT>(alloc);
+  ListTestSuite<T, ListT> test(*lp, alloc);
+  test.EmplaceTest(15);
+  PrivateListTestRunner(test);
+}
+
+/**
+ * TEST PRIVATE CONTAINERS
+ * */
+
+TEST_CASE("PrivateVector") {
+  static_assert(std::is_same_v<decltype(hshm::vector<int>::alloc_id_),
+                               hipc::ShmAllocRef<true>>);
+  static_assert(std::is_same_v<decltype(hipc::vector<int>::alloc_id_),
+                               hipc::ShmAllocRef<false>>);
+  PrivateTest([](Allocator *alloc) {
+    PrivateVectorTest<int>(alloc);
+    PrivateVectorTest<hipc::string>(alloc);
+  });
+}
+
+TEST_CASE("PrivateList") {
+  PrivateTest([](Allocator *alloc) {
+    PrivateListTest<hshm::list<int>, int>(alloc);
+    PrivateListTest<hshm::list<hipc::string>, hipc::string>(alloc);
+    PrivateListTest<hshm::slist<int>, int>(alloc);
+    PrivateListTest<hshm::slist<hipc::string>, hipc::string>(alloc);
+  });
+}
+
+TEST_CASE("PrivateString") {
+  PrivateTest([](Allocator *alloc) {
+    auto small = hipc::make_uptr<hipc::private_string>(alloc, "hello");
+    auto large = hipc::make_uptr<hipc::private_string>(
+      alloc, std::string(100, 'a'));
+    REQUIRE(*small == "hello");
+    REQUIRE(*large == std::string(100, 'a'));
+    REQUIRE(large->data() ==
+            reinterpret_cast<char*>(large->text_.off_.load()));
+    auto vec = hipc::make_uptr<hshm::vector<hipc::private_string>>(alloc);
+    vec->emplace_back(*large);
+    REQUIRE((*vec)[0] == *large);
+    REQUIRE(std::hash<hipc::private_string>{}((*vec)[0]) ==
+            std::hash<hipc::private_string>{}(*large));
+  });
+}
+
+TEST_CASE("PrivateContainerNeedsNativeOffsets") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  REQUIRE(!alloc->HasNativeOffsets());
+  REQUIRE_THROWS([alloc]() {
+    hshm::vector<int> vec(alloc);
+  }());
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
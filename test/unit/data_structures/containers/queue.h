@@ -87,12 +87,13 @@ class QueueTestSuite {
   }
 };
 
-template<typename QueueT, typename T>
+template<typename QueueT, typename T, typename ...Args>
 void ProduceThenConsume(size_t nproducers,
                         size_t nconsumers,
                         size_t count_per_rank,
-                        size_t depth) {
-  auto queue = hipc::make_uptr<QueueT>(depth);
+                        size_t depth,
+                        Args&& ...args) {
+  auto queue = hipc::make_uptr<QueueT>(depth, std::forward<Args>(args)...);
   QueueTestSuite<QueueT, T> q(queue);
   std::atomic<size_t> count = 0;
   std::vector<size_t> entries;
@@ -117,12 +118,13 @@ void ProduceThenConsume(size_t nproducers,
   }
 }
 
-template<typename QueueT, typename T>
+template<typename QueueT, typename T, typename ...Args>
 void ProduceAndConsume(size_t nproducers,
                        size_t nconsumers,
                        size_t count_per_rank,
-                       size_t depth) {
-  auto queue = hipc::make_uptr<QueueT>(depth);
+                       size_t depth,
+                       Args&& ...args) {
+  auto queue = hipc::make_uptr<QueueT>(depth, std::forward<Args>(args)...);
   size_t nthreads = nproducers + nconsumers;
   QueueTestSuite<QueueT, T> q(queue);
   std::atomic<size_t> count = 0;
@@ -146,4 +148,53 @@ void ProduceAndConsume(size_t nproducers,
   }
 }
 
+/**
+ * Producers emplace_n batches of 1 to \a max_batch ints, some larger than
+ * the queue, while a single consumer drains it with pop_n.
+ * */
+template<typename QueueT, typename ...Args>
+void ProduceAndConsumeBatched(size_t nproducers,
+                              size_t count_per_rank,
+                              size_t depth,
+                              size_t max_batch,
+                              Args&& ...args) {
+  auto queue = hipc::make_uptr<QueueT>(depth, std::forward<Args>(args)...);
+  size_t total_count = nproducers * count_per_rank;
+  std::vector<size_t> seen(total_count, 0);
+
+  omp_set_dynamic(0);
+#pragma omp parallel shared(queue, seen) num_threads(nproducers + 1)  // NOLINT
+  {  // NOLINT
+    size_t rank = omp_get_thread_num();
+    if (rank < nproducers) {
+      // Producer
+      std::vector<int> batch(max_batch);
+      size_t i = 0, n = 0;
+      while (i < count_per_rank) {
+        size_t count = std::min(1 + n++ % max_batch, count_per_rank - i);
+        for (size_t j = 0; j < count; ++j) {
+          batch[j] = static_cast<int>(rank * count_per_rank + i + j);
+        }
+        queue->emplace_n(batch.data(), count);
+        i += count;
+      }
+    } else {
+      // Consumer
+      std::vector<int> batch(max_batch);
+      size_t count = 0;
+      while (count < total_count) {
+        size_t popped = queue->pop_n(batch.data(), max_batch);
+        for (size_t j = 0; j < popped; ++j) {
+          seen[batch[j]] += 1;
+        }
+        count += popped;
+      }
+      REQUIRE(queue->pop_n(batch.data(), max_batch) == 0);
+    }
+  }
+  for (size_t i = 0; i < total_count; ++i) {
+    REQUIRE(seen[i] == 1);
+  }
+}
+
 #endif  // HERMES_SHM_TEST_UNIT_DATA_STRUCTURES_CONTAINERS_QUEUE_H_
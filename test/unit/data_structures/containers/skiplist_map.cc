@@ -0,0 +1,274 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+* Distributed under BSD 3-Clause license.                                   *
+* Copyright by The HDF Group.                                               *
+* Copyright by the Illinois Institute of Technology.                        *
+* All rights reserved.                                                      *
+*                                                                           *
+* This file is part of Hermes. The full Hermes copyright notice, including  *
+* terms governing use, modification, and redistribution, is contained in    *
+* the COPYING file, which can be found at the top directory. If you do not  *
+* have access to the file, you may request a copy from help@hdfgroup.org.   *
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "basic_test.h"
+#include "test_init.h"
+#include "omp.h"
+#include "hermes_shm/data_structures/ipc/skiplist_map.h"
+
+using hshm::ipc::Allocator;
+using hshm::ipc::skiplist_map;
+
+template<typename Key, typename Val>
+void SkiplistMapOpTest() {
+  Allocator *alloc = alloc_g;
+  auto map_p = hipc::make_uptr<skiplist_map<Key, Val>>(alloc);
+  auto &map = *map_p;
+  Key count = 10000;
+
+  // Insert entries out of order
+  PAGE_DIVIDE("Insert entries") {
+    for (Key i = 0; i < count; ++i) {
+      Key key = (i * 7919) % count;
+      REQUIRE(map.try_emplace(key, static_cast<Val>(key)));
+    }
+    REQUIRE(map.size() == (size_t)count);
+  }
+
+  // Find every entry
+  PAGE_DIVIDE("Find entries") {
+    for (Key i = 0; i < count; ++i) {
+      Val val;
+      REQUIRE(map.find(i, val));
+      REQUIRE(val == static_cast<Val>(i));
+    }
+    REQUIRE(!map.contains(count));
+  }
+
+  // Iterate over the map in order
+  PAGE_DIVIDE("Forward iterate") {
+    Key i = 0;
+    for (auto &node : map) {
+      REQUIRE(node.GetKey() == i);
+      REQUIRE(node.GetVal() == static_cast<Val>(i));
+      ++i;
+    }
+    REQUIRE(i == count);
+  }
+
+  // Modify entries
+  PAGE_DIVIDE("Modify entries") {
+    for (Key i = 0; i < count; ++i) {
+      REQUIRE(!map.try_emplace(i, static_cast<Val>(i + 1)));
+      REQUIRE(map.emplace(i, static_cast<Val>(i + 1)));
+      Val val;
+      REQUIRE(map.find(i, val));
+      REQUIRE(val == static_cast<Val>(i + 1));
+    }
+    REQUIRE(map.size() == (size_t)count);
+  }
+
+  // Erase the even entries
+  PAGE_DIVIDE("Erase entries") {
+    for (Key i = 0; i < count; i += 2) {
+      REQUIRE(map.erase(i));
+    }
+    REQUIRE(!map.erase(0));
+    REQUIRE(!map.erase(count));
+    REQUIRE(map.size() == (size_t)count / 2);
+    for (Key i = 0; i < count; ++i) {
+      REQUIRE(map.contains(i) == (i % 2 == 1));
+    }
+    REQUIRE((*map.begin()).GetKey() == 1);
+    REQUIRE((*map.lower_bound(10)).GetKey() == 11);
+  }
+
+  // Scan ranges of the map
+  PAGE_DIVIDE("Scan ranges") {
+    std::vector<Key> keys(count);
+    std::vector<Val> vals(count);
+    size_t n = map.scan(100, 200, keys.data(), vals.data(), keys.size());
+    REQUIRE(n == 50);
+    for (size_t i = 0; i < n; ++i) {
+      REQUIRE(keys[i] == static_cast<Key>(101 + 2 * i));
+      REQUIRE(vals[i] == static_cast<Val>(102 + 2 * i));
+    }
+    n = map.scan(0, count, keys.data(), vals.data(), 10);
+    REQUIRE(n == 10);
+    REQUIRE(keys[9] == 19);
+  }
+
+  // Reinsert the erased entries
+  PAGE_DIVIDE("Reinsert entries") {
+    for (Key i = 0; i < count; i += 2) {
+      REQUIRE(map.try_emplace(i, static_cast<Val>(i + 1)));
+    }
+    REQUIRE(map.size() == (size_t)count);
+  }
+
+  // Copy the map
+  PAGE_DIVIDE("Copy the map") {
+    auto cpy = hipc::make_uptr<skiplist_map<Key, Val>>(alloc, map);
+    REQUIRE(cpy->size() == (size_t)count);
+    for (Key i = 0; i < count; ++i) {
+      Val val;
+      REQUIRE(cpy->find(i, val));
+      REQUIRE(val == static_cast<Val>(i + 1));
+    }
+  }
+
+  // Move the map
+  PAGE_DIVIDE("Move the map") {
+    auto cpy = hipc::make_uptr<skiplist_map<Key, Val>>(alloc);
+    (*cpy) = std::move(map);
+    REQUIRE(map.size() == 0);
+    REQUIRE(!map.contains(0));
+    REQUIRE(cpy->size() == (size_t)count);
+    map = std::move(*cpy);
+  }
+
+  // Clear the map
+  PAGE_DIVIDE("Clear the map") {
+    map.clear();
+    REQUIRE(map.size() == 0);
+    REQUIRE(map.begin() == map.end());
+    REQUIRE(!map.contains(0));
+  }
+}
+
+TEST_CASE("SkiplistMapOfIntInt") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  SkiplistMapOpTest<int, int>();
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
+TEST_CASE("SkiplistMapOfSizetDouble") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  SkiplistMapOpTest<size_t, double>();
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
+TEST_CASE("SkiplistMapConcurrent") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  {
+    auto map_p = hipc::make_uptr<skiplist_map<size_t, size_t>>(alloc);
+    auto &map = *map_p;
+    int nthreads = 8;
+    size_t count_per_rank = 5000;
+    std::atomic<size_t> errors = 0;
+
+    // Every thread inserts an interleaved set of keys and scans its own
+    omp_set_dynamic(0);
+#pragma omp parallel shared(map, errors) num_threads(nthreads)
+    {
+      size_t rank = omp_get_thread_num();
+      for (size_t i = 0; i < count_per_rank; ++i) {
+        size_t key = i * nthreads + rank;
+        if (!map.try_emplace(key, key * 3)) {
+          errors.fetch_add(1);
+        }
+        size_t val;
+        if (!map.find(key, val) || val != key * 3) {
+          errors.fetch_add(1);
+        }
+      }
+      size_t prior = 0;
+      bool first = true;
+      for (auto iter = map.begin(); !iter.is_end(); ++iter) {
+        if (!first && !(prior < (*iter).GetKey())) {
+          errors.fetch_add(1);
+        }
+        prior = (*iter).GetKey();
+        first = false;
+      }
+    }
+    REQUIRE(errors.load() == 0);
+    REQUIRE(map.size() == count_per_rank * nthreads);
+    size_t i = 0;
+    for (auto &node : map) {
+      REQUIRE(node.GetKey() == i);
+      ++i;
+    }
+    REQUIRE(i == count_per_rank * nthreads);
+  }
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
+TEST_CASE("SkiplistMapChurn") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  {
+    auto map_p = hipc::make_uptr<skiplist_map<size_t, size_t>>(alloc);
+    auto &map = *map_p;
+    int nthreads = 4;
+    size_t window = 1024;
+    size_t rounds = 8;
+    size_t perm = (size_t)1 << 40;
+    size_t num_perm = 64;
+    std::atomic<size_t> errors = 0;
+
+    // Keys past perm are never erased, and must stay reachable while
+    // the nodes around them are unlinked
+    for (size_t i = 0; i < num_perm; ++i) {
+      map.emplace(perm + i, perm + i);
+    }
+    for (size_t j = 0; j < window * nthreads; ++j) {
+      map.emplace(j, j);
+    }
+
+    // Every thread slides a window over its own interleaved keys. The
+    // map is quiescent between rounds, which is when it is compacted.
+    size_t steady_size = 0;
+    for (size_t round = 0; round < rounds; ++round) {
+      omp_set_dynamic(0);
+#pragma omp parallel shared(map, errors) num_threads(nthreads)
+      {
+        size_t rank = omp_get_thread_num();
+        for (size_t s = round * window; s < (round + 1) * window; ++s) {
+          size_t new_key = (s + window) * nthreads + rank;
+          size_t old_key = s * nthreads + rank;
+          if (!map.try_emplace(new_key, new_key)) {
+            errors.fetch_add(1);
+          }
+          if (!map.erase(old_key) || map.contains(old_key)) {
+            errors.fetch_add(1);
+          }
+          size_t val;
+          size_t key = perm + s % num_perm;
+          if (!map.find(key, val) || val != key) {
+            errors.fetch_add(1);
+          }
+        }
+      }
+      REQUIRE(errors.load() == 0);
+      REQUIRE(map.size() == window * nthreads + num_perm);
+      REQUIRE(map.compact() == window * nthreads);
+      REQUIRE(map.compact() == 0);
+      if (round == 0) {
+        steady_size = alloc->GetCurrentlyAllocatedSize();
+      }
+      REQUIRE(alloc->GetCurrentlyAllocatedSize() <= steady_size * 3 / 2);
+    }
+
+    // Only the live window and the permanent keys remain
+    size_t i = rounds * window * nthreads;
+    for (auto &node : map) {
+      if (node.GetKey() >= perm) {
+        REQUIRE(node.GetKey() == perm + (i - (rounds + 1) * window * nthreads));
+      } else {
+        REQUIRE(node.GetKey() == i);
+      }
+      ++i;
+    }
+    REQUIRE(i == (rounds + 1) * window * nthreads + num_perm);
+
+    // Erased nodes not yet compacted are freed with the map
+    for (size_t j = 0; j < 10; ++j) {
+      REQUIRE(map.erase(perm + j));
+    }
+  }
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
@@ -57,3 +57,22 @@ TEST_CASE("SlistOfStdString") {
   SlistTest<std::string>();
   REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
 }
+
+template<typename T>
+void SlistNodePoolTest(size_t max_free, size_t chunk_nodes) {
+  Allocator *alloc = alloc_g;
+  auto lp = hipc::make_uptr<slist<T>>(alloc);
+  lp->enable_node_pool(max_free, chunk_nodes);
+  ListTestSuite<T, slist<T>> test(*lp, alloc);
+  test.NodePoolTest(chunk_nodes);
+}
+
+TEST_CASE("SlistNodePool") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  SlistNodePoolTest<int>(8, 1);
+  SlistNodePoolTest<int>(8, 32);
+  SlistNodePoolTest<hipc::string>(8, 1);
+  SlistNodePoolTest<hipc::string>(128, 32);
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
@@ -35,6 +35,68 @@ TEST_CASE("TestSpscQueueString") {
   REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
 }
 
+TEST_CASE("TestSpscQueueIntMultiThreaded") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  ProduceAndConsume<hipc::spsc_queue<int>, int>(1, 1, 8192, 32);
+  ProduceAndConsume<hipc::spsc_queue<hipc::string>, hipc::string>(
+    1, 1, 8192, 30);
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
+TEST_CASE("TestSpscQueueDepth") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  {
+    // The depth is rounded up to a power of two
+    auto q = hipc::make_uptr<hipc::spsc_queue<int>>(10);
+    REQUIRE(q->GetDepth() == 16);
+    for (int i = 0; i < 16; ++i) {
+      REQUIRE(!q->emplace(i).IsNull());
+    }
+    REQUIRE(q->emplace(16).IsNull());
+    REQUIRE(q->GetSize() == 16);
+    int val;
+    for (int i = 0; i < 16; ++i) {
+      REQUIRE(!q->pop(val).IsNull());
+      REQUIRE(val == i);
+    }
+    REQUIRE(q->pop(val).IsNull());
+  }
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
+TEST_CASE("TestSpscQueueBatch") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  {
+    auto q = hipc::make_uptr<hipc::spsc_queue<int>>(8);
+    std::vector<int> in, out(8);
+    for (int i = 0; i < 24; ++i) {
+      in.emplace_back(i);
+    }
+
+    // A batch is cut short once the queue is full
+    REQUIRE(q->emplace_n(in.data(), 5) == 5);
+    REQUIRE(q->emplace_n(in.data() + 5, 5) == 3);
+    REQUIRE(q->emplace_n(in.data() + 8, 1) == 0);
+
+    // Batches wrap around the end of the ring in order
+    size_t next = 0, pushed = 8;
+    while (next < in.size()) {
+      size_t popped = q->pop_n(out.data(), 3);
+      REQUIRE(popped > 0);
+      for (size_t i = 0; i < popped; ++i) {
+        REQUIRE(out[i] == in[next++]);
+      }
+      pushed += q->emplace_n(in.data() + pushed,
+                             std::min<size_t>(4, in.size() - pushed));
+    }
+    REQUIRE(q->pop_n(out.data(), 8) == 0);
+  }
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
 TEST_CASE("TestSpscQueuePrivateInt") {
   Allocator *alloc = alloc_g;
   REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
@@ -69,6 +69,25 @@ TEST_CASE("TestSplitTicketQueueIntMultiThreaded") {
   REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
 }
 
+TEST_CASE("TestSplitTicketQueueAffineInt") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  // The home lane overflows, so the consumer must steal from the others
+  ProduceThenConsume<hipc::split_ticket_queue<int>, int>(
+    1, 1, 32, 8, 4, true);
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
+TEST_CASE("TestSplitTicketQueueAffineIntMultiThreaded") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  ProduceAndConsume<hipc::split_ticket_queue<int>, int>(
+    8, 1, 8192, 64, 8, true);
+  ProduceAndConsume<hipc::split_ticket_queue<int>, int>(
+    8, 8, 8192, 64, 8, true);
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
 TEST_CASE("TestTicketQueuePrivateInt") {
   Allocator *alloc = alloc_g;
   REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
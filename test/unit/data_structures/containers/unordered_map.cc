@@ -13,7 +13,9 @@
 #include "basic_test.h"
 #include "test_init.h"
 #include "hermes_shm/data_structures/ipc/unordered_map.h"
+#include "hermes_shm/data_structures/ipc/concurrent_unordered_map.h"
 #include "hermes_shm/data_structures/ipc/string.h"
+#include "omp.h"
 
 using hshm::ipc::MemoryBackendType;
 using hshm::ipc::MemoryBackend;
@@ -38,7 +40,7 @@ void UnorderedMapOpTest() {
   auto map_p = hipc::make_uptr<unordered_map<Key, Val>>(alloc, 5);
   auto &map = *map_p;
 
-  // Insert 20 entries into the map (no growth trigger)
+  // Insert 20 entries into the map (triggers growth)
   PAGE_DIVIDE("Insert entries") {
     for (int i = 0; i < 20; ++i) {
       CREATE_KV_PAIR(key, i, val, i);
@@ -219,6 +221,202 @@ void UnorderedMapOpTest() {
   }
 }
 
+template<typename Key, typename Val>
+void UnorderedMapGrowthTest(bool incremental) {
+  Allocator *alloc = alloc_g;
+  auto map_p = hipc::make_uptr<unordered_map<Key, Val>>(
+    alloc, 5, hshm::RealNumber(4, 5), hshm::RealNumber(2, 1), incremental);
+  auto &map = *map_p;
+  int count = 1000;
+
+  // Insert entries, checking every entry stays findable during growth
+  PAGE_DIVIDE("Insert entries") {
+    bool saw_rehash = false;
+    for (int i = 0; i < count; ++i) {
+      CREATE_KV_PAIR(key, i, val, i);
+      map.emplace(key, val);
+      saw_rehash |= map.is_rehashing();
+      for (int j = 0; j <= i; j += 97) {
+        CREATE_KV_PAIR(key2, j, val2, j);
+        REQUIRE(map[key2] == val2);
+      }
+    }
+    REQUIRE(saw_rehash == incremental);
+    REQUIRE(map.size() == (size_t)count);
+    REQUIRE(map.get_num_buckets() * 4 / 5 >= (size_t)count / 2);
+  }
+
+  // Iterate over the map
+  PAGE_DIVIDE("Forward iterate") {
+    std::vector<int> keys;
+    for (auto &entry : map) {
+      GET_INT_FROM_KEY(entry.GetKey());
+      keys.emplace_back(key_ret);
+    }
+    std::sort(keys.begin(), keys.end());
+    REQUIRE(keys.size() == (size_t)count);
+    for (int i = 0; i < count; ++i) {
+      REQUIRE(keys[i] == i);
+    }
+  }
+
+  // Erase half of the entries
+  PAGE_DIVIDE("Erase entries") {
+    for (int i = 0; i < count; i += 2) {
+      CREATE_KV_PAIR(key, i, val, i);
+      map.erase(key);
+    }
+    REQUIRE(map.size() == (size_t)count / 2);
+    for (int i = 0; i < count; ++i) {
+      CREATE_KV_PAIR(key, i, val, i);
+      REQUIRE(map.find(key).is_end() == (i % 2 == 0));
+    }
+  }
+
+  // Explicitly rehash the map
+  PAGE_DIVIDE("Rehash") {
+    map.rehash(4 * map.get_num_buckets());
+    REQUIRE(!map.is_rehashing());
+    for (int i = 1; i < count; i += 2) {
+      CREATE_KV_PAIR(key, i, val, i);
+      REQUIRE(map[key] == val);
+    }
+  }
+}
+
+TEST_CASE("UnorderedMapGrowth") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  UnorderedMapGrowthTest<int, int>(false);
+  UnorderedMapGrowthTest<string, string>(false);
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
+TEST_CASE("UnorderedMapIncrementalGrowth") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  UnorderedMapGrowthTest<int, int>(true);
+  UnorderedMapGrowthTest<string, string>(true);
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
+template<typename Key, typename Val>
+void UnorderedMapConcurrentTest(int nthreads, int count_per_thread) {
+  Allocator *alloc = alloc_g;
+  auto map_p = hipc::make_uptr<hipc::concurrent_unordered_map<Key, Val>>(
+    alloc, 16, 8);
+  auto &map = *map_p;
+  int count = nthreads * count_per_thread;
+  std::atomic<int> num_wrong(0);
+
+  // Each thread inserts its own keys and re-reads keys of all threads
+  omp_set_dynamic(0);
+#pragma omp parallel shared(map) num_threads(nthreads)
+  {
+    int rank = omp_get_thread_num();
+    for (int i = 0; i < count_per_thread; ++i) {
+      int k = i * nthreads + rank;
+      CREATE_KV_PAIR(key, k, val, k);
+      map.emplace(key, val);
+      CREATE_KV_PAIR(key2, i, val2, i);
+      Val found;
+      if (map.find(key2, found) && !(found == val2)) {
+        num_wrong.fetch_add(1);
+      }
+    }
+#pragma omp barrier
+    for (int i = rank; i < count; i += nthreads * 2) {
+      CREATE_KV_PAIR(key, i, val, i);
+      map.erase(key);
+    }
+  }
+
+  // Verify the final contents of the map
+  REQUIRE(num_wrong == 0);
+  REQUIRE(map.size() == (size_t)count / 2);
+  REQUIRE(map.get_num_buckets() % map.get_num_stripes() == 0);
+  REQUIRE(map.get_num_buckets() > 16);
+  for (int i = 0; i < count; ++i) {
+    CREATE_KV_PAIR(key, i, val, i);
+    Val found;
+    bool erased = (i % (nthreads * 2)) < nthreads;
+    REQUIRE(map.find(key, found) == !erased);
+    if (!erased) {
+      REQUIRE(found == val);
+    }
+  }
+}
+
+TEST_CASE("UnorderedMapConcurrentIntInt") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  UnorderedMapConcurrentTest<int, int>(8, 2048);
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
+TEST_CASE("UnorderedMapBatch") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  {
+    auto map_p = hipc::make_uptr<unordered_map<int, int>>(alloc, 5);
+    auto &map = *map_p;
+    int count = 1000;
+    std::vector<int> keys(count), vals(count);
+    for (int i = 0; i < count; ++i) {
+      keys[i] = i;
+      vals[i] = 2 * i;
+    }
+    map.emplace_batch(keys.data(), vals.data(), count);
+    REQUIRE(map.size() == (size_t)count);
+
+    // Find present and missing keys in one batch
+    std::vector<int> find_keys;
+    for (int i = 0; i < 2 * count; i += 3) {
+      find_keys.emplace_back(i);
+    }
+    std::vector<unordered_map<int, int>::iterator_t> out(find_keys.size());
+    map.find_batch(find_keys.data(), find_keys.size(), out.data());
+    for (size_t i = 0; i < find_keys.size(); ++i) {
+      int key = find_keys[i];
+      REQUIRE(out[i].is_end() == (key >= count));
+      if (key < count) {
+        REQUIRE((*out[i]).GetKey() == key);
+        REQUIRE((*out[i]).GetVal() == 2 * key);
+      }
+    }
+  }
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
+/** A hash which maps every key to the same value */
+struct ConstantHash {
+  size_t operator()(int key) const { return 7; }
+};
+
+TEST_CASE("UnorderedMapHashCollisions") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  {
+    auto map_p = hipc::make_uptr<unordered_map<int, int, ConstantHash>>(
+      alloc, 5);
+    auto &map = *map_p;
+    for (int i = 0; i < 64; ++i) {
+      map.emplace(i, i);
+    }
+    REQUIRE(map.size() == 64);
+    for (int i = 0; i < 64; ++i) {
+      REQUIRE(map[i] == i);
+    }
+    for (int i = 0; i < 64; i += 2) {
+      map.erase(i);
+    }
+    for (int i = 0; i < 64; ++i) {
+      REQUIRE(map.find(i).is_end() == (i % 2 == 0));
+    }
+  }
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
 TEST_CASE("UnorderedMapOfIntInt") {
   Allocator *alloc = alloc_g;
   REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
@@ -0,0 +1,116 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "basic_test.h"
+#include "test_init.h"
+#include "list.h"
+#include "hermes_shm/data_structures/ipc/unrolled_list.h"
+#include "hermes_shm/data_structures/ipc/string.h"
+
+using hshm::ipc::unrolled_list;
+
+template<typename T>
+void UnrolledListTest() {
+  Allocator *alloc = alloc_g;
+  auto lp = hipc::make_uptr<unrolled_list<T>>(alloc);
+  ListTestSuite<T, unrolled_list<T>> test(*lp, alloc);
+
+  test.EmplaceTest(100);
+  test.ForwardIteratorTest();
+  test.ConstForwardIteratorTest();
+  test.CopyConstructorTest();
+  test.CopyAssignmentTest();
+  test.MoveConstructorTest();
+  test.MoveAssignmentTest();
+  test.EmplaceFrontTest();
+  test.ModifyEntryCopyIntoTest();
+  test.ModifyEntryMoveIntoTest();
+  test.EraseTest();
+}
+
+/** Push and pop at both ends, then erase in the middle of nodes */
+template<typename T>
+void UnrolledListDequeTest(size_t count) {
+  Allocator *alloc = alloc_g;
+  auto lp = hipc::make_uptr<unrolled_list<T>>(alloc);
+  unrolled_list<T> &obj = *lp;
+
+  // Build [0, 2 * count) from the middle outwards
+  for (size_t i = 0; i < count; ++i) {
+    CREATE_SET_VAR_TO_INT_OR_STRING(T, back, count + i);
+    CREATE_SET_VAR_TO_INT_OR_STRING(T, front, count - i - 1);
+    obj.emplace_back(back);
+    obj.emplace_front(front);
+  }
+  REQUIRE(obj.size() == 2 * count);
+  size_t fcur = 0;
+  for (auto &num : obj) {
+    CREATE_SET_VAR_TO_INT_OR_STRING(T, fcur_conv, fcur);
+    REQUIRE(num == fcur_conv);
+    ++fcur;
+  }
+  REQUIRE(fcur == 2 * count);
+
+  // Skip to arbitrary positions
+  for (size_t i = 0; i < 2 * count; i += 7) {
+    CREATE_SET_VAR_TO_INT_OR_STRING(T, var, i);
+    REQUIRE(*(obj.begin() + i) == var);
+  }
+  REQUIRE((obj.begin() + 2 * count).is_end());
+
+  // Erase every odd element
+  for (auto iter = obj.begin() + 1; !iter.is_end(); ) {
+    iter = obj.erase(iter);
+    iter += 1;
+  }
+  REQUIRE(obj.size() == count);
+  fcur = 0;
+  for (auto &num : obj) {
+    CREATE_SET_VAR_TO_INT_OR_STRING(T, fcur_conv, fcur);
+    REQUIRE(num == fcur_conv);
+    fcur += 2;
+  }
+
+  // Drain from both ends
+  for (size_t i = 0; i < count / 2; ++i) {
+    obj.pop_front();
+    obj.pop_back();
+  }
+  REQUIRE(obj.size() == count % 2);
+  obj.pop_front();
+  REQUIRE(obj.size() == 0);
+  REQUIRE(obj.begin().is_end());
+}
+
+TEST_CASE("UnrolledListOfInt") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  UnrolledListTest<int>();
+  UnrolledListDequeTest<int>(500);
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
+TEST_CASE("UnrolledListOfString") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  UnrolledListTest<hipc::string>();
+  UnrolledListDequeTest<hipc::string>(201);
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
+TEST_CASE("UnrolledListOfStdString") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  UnrolledListTest<std::string>();
+  UnrolledListDequeTest<std::string>(201);
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
@@ -17,6 +17,9 @@
 #include "hermes_shm/data_structures/ipc/string.h"
 #include "vector.h"
 
+#include <iterator>
+#include <sstream>
+
 using hshm::ipc::vector;
 using hshm::ipc::list;
 using hshm::ipc::string;
@@ -125,3 +128,114 @@ TEST_CASE("VectorOfListOfString") {
   VectorOfListOfStringTest();
   REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
 }
+
+TEST_CASE("VectorRelocatableTrait") {
+  REQUIRE(hipc::is_trivially_relocatable_v<int>);
+  REQUIRE(hipc::is_trivially_relocatable_v<hipc::string>);
+  REQUIRE(hipc::is_trivially_relocatable_v<vector<hipc::string>>);
+  REQUIRE(hipc::is_trivially_relocatable_v<
+          hipc::pair<int, hipc::string>>);
+  REQUIRE_FALSE(hipc::is_trivially_relocatable_v<std::string>);
+  REQUIRE_FALSE(hipc::is_trivially_relocatable_v<
+                hipc::pair<int, std::string>>);
+}
+
+TEST_CASE("VectorNonRelocatableShift") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  {
+    // Strings longer than the SSO buffer point to their own heap data,
+    // so growing and shifting must move-construct them
+    auto make_str = [](size_t i) {
+      return std::string(64, 'a' + (i % 26)) + std::to_string(i);
+    };
+    std::vector<std::string> expect;
+    auto vec = hipc::make_uptr<vector<std::string>>(alloc);
+    for (size_t i = 0; i < 100; ++i) {
+      vec->emplace_back(make_str(i));
+      expect.emplace_back(make_str(i));
+    }
+    for (size_t i = 0; i < 20; ++i) {
+      size_t pos = (i * 7) % expect.size();
+      vec->emplace(vec->begin() + pos, make_str(1000 + i));
+      expect.insert(expect.begin() + pos, make_str(1000 + i));
+    }
+    for (size_t i = 0; i < 30; ++i) {
+      size_t pos = (i * 11) % expect.size();
+      vec->erase(vec->begin() + pos);
+      expect.erase(expect.begin() + pos);
+    }
+    REQUIRE(vec->size() == expect.size());
+    for (size_t i = 0; i < expect.size(); ++i) {
+      REQUIRE((*vec)[i] == expect[i]);
+    }
+  }
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
+TEST_CASE("VectorBulkInsert") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  {
+    std::vector<int> src{0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    auto vec = hipc::make_uptr<vector<int>>(alloc);
+    vec->append(src.data(), 5);
+    vec->insert(vec->end(), src.begin() + 7, src.end());
+    vec->insert(vec->begin() + 5, src.data() + 5, src.data() + 7);
+    REQUIRE(vec->size() == 10);
+    for (int i = 0; i < 10; ++i) {
+      REQUIRE((*vec)[i] == i);
+    }
+    vec->assign(src.data() + 3, 2);
+    REQUIRE(vec->size() == 2);
+    REQUIRE((*vec)[0] == 3);
+    REQUIRE((*vec)[1] == 4);
+  }
+  {
+    std::vector<std::string> src{"a", "b", "c", "d"};
+    auto vec = hipc::make_uptr<vector<hipc::string>>(alloc);
+    vec->assign(src.begin() + 2, src.end());
+    vec->insert(vec->begin(), src.begin(), src.begin() + 2);
+    REQUIRE(vec->size() == 4);
+    for (size_t i = 0; i < src.size(); ++i) {
+      REQUIRE((*vec)[i].str() == src[i]);
+    }
+  }
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
+
+TEST_CASE("VectorBulkInsertMixedSources") {
+  Allocator *alloc = alloc_g;
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+  {
+    // A pointer range of another type converts element by element
+    short src[] = {1, 2, 3, 4};
+    auto vec = hipc::make_uptr<vector<int>>(alloc);
+    vec->insert(vec->end(), src, src + 4);
+    REQUIRE(vec->size() == 4);
+    for (int i = 0; i < 4; ++i) {
+      REQUIRE((*vec)[i] == i + 1);
+    }
+
+    // A range from another hipc::vector
+    auto other = hipc::make_uptr<vector<int>>(alloc);
+    other->insert(other->begin(), vec->begin(), vec->end());
+    other->insert(other->begin() + 2, vec->begin(), vec->end());
+    REQUIRE(other->size() == 8);
+    std::vector<int> expect{1, 2, 1, 2, 3, 4, 3, 4};
+    for (size_t i = 0; i < expect.size(); ++i) {
+      REQUIRE((*other)[i] == expect[i]);
+    }
+
+    // A single-pass input range
+    std::istringstream in("7 8 9");
+    vec->insert(vec->begin() + 1, std::istream_iterator<int>(in),
+                std::istream_iterator<int>());
+    std::vector<int> expect2{1, 7, 8, 9, 2, 3, 4};
+    REQUIRE(vec->size() == expect2.size());
+    for (size_t i = 0; i < expect2.size(); ++i) {
+      REQUIRE((*vec)[i] == expect2[i]);
+    }
+  }
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == 0);
+}
@@ -85,6 +85,89 @@ TEST_CASE("SerializeHipcVec") {
   }
 }
 
+TEST_CASE("SerializeHipcVecLarge") {
+  std::stringstream ss;
+  std::vector<int> y(3000);
+  for (size_t i = 0; i < y.size(); ++i) {
+    y[i] = (int)i;
+  }
+  {
+    auto x = hipc::make_uptr<hipc::vector<int>>();
+    x->reserve(y.size());
+    for (int i : y) {
+      x->emplace_back(i);
+    }
+    cereal::BinaryOutputArchive ar(ss);
+    ar << x;
+  }
+  {
+    hipc::uptr<hipc::vector<int>> x;
+    cereal::BinaryInputArchive ar(ss);
+    ar >> x;
+    REQUIRE(x->vec() == y);
+  }
+}
+
+TEST_CASE("SerializeHipcVecCharLarge") {
+  std::stringstream ss;
+  std::vector<char> y(10000);
+  for (size_t i = 0; i < y.size(); ++i) {
+    y[i] = (char)(i % 251);
+  }
+  {
+    auto x = hipc::make_uptr<hipc::vector<char>>();
+    x->reserve(y.size());
+    for (char c : y) {
+      x->emplace_back(c);
+    }
+    cereal::BinaryOutputArchive ar(ss);
+    ar << x;
+  }
+  {
+    hipc::uptr<hipc::vector<char>> x;
+    cereal::BinaryInputArchive ar(ss);
+    ar >> x;
+    REQUIRE(x->vec() == y);
+  }
+}
+
+struct SerialPoint {
+  int x_, y_;
+
+  template<typename Ar>
+  void serialize(Ar &ar) {
+    ar(x_, y_);
+  }
+
+  bool operator==(const SerialPoint &other) const {
+    return x_ == other.x_ && y_ == other.y_;
+  }
+};
+
+TEST_CASE("SerializeHipcVecPodLarge") {
+  // Spans several chunks of the staging buffer, the last one partial
+  std::stringstream ss;
+  std::vector<SerialPoint> y(1500);
+  for (size_t i = 0; i < y.size(); ++i) {
+    y[i] = SerialPoint{(int)i, -(int)i};
+  }
+  {
+    auto x = hipc::make_uptr<hipc::vector<SerialPoint>>();
+    x->reserve(y.size());
+    for (const SerialPoint &p : y) {
+      x->emplace_back(p);
+    }
+    cereal::BinaryOutputArchive ar(ss);
+    ar << x;
+  }
+  {
+    hipc::uptr<hipc::vector<SerialPoint>> x;
+    cereal::BinaryInputArchive ar(ss);
+    ar >> x;
+    REQUIRE(x->vec() == y);
+  }
+}
+
 TEST_CASE("SerializeHipcVecString") {
   std::stringstream ss;
   {
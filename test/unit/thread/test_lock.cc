@@ -17,6 +17,7 @@
 
 using hshm::Mutex;
 using hshm::RwLock;
+using hshm::Futex;
 
 void MutexTest() {
   size_t nthreads = 8;
@@ -75,6 +76,29 @@ void RwLockTest(int producers, int consumers, size_t loop_count) {
   }
 }
 
+void FutexTest(size_t nthreads, size_t loop_count) {
+  Futex futex;
+  std::atomic<size_t> count = 0;
+
+  // A waiter gives up once the timeout passes
+  REQUIRE(!futex.WaitFor([]() { return false; }, 1000));
+
+  // Waiters sleep until a notifier advances the count to their turn
+  omp_set_dynamic(0);
+#pragma omp parallel shared(futex, count) num_threads(nthreads)
+  {  // NOLINT
+    size_t tid = omp_get_thread_num();
+    for (size_t i = tid; i < loop_count * nthreads; i += nthreads) {
+      REQUIRE(futex.WaitFor([&count, i]() {
+        return count.load() == i;
+      }, HSHM_WAIT_FOREVER, 0));
+      count.fetch_add(1);
+      futex.Wake();
+    }
+  }
+  REQUIRE(count == loop_count * nthreads);
+}
+
 TEST_CASE("Mutex") {
   MutexTest();
 }
@@ -84,3 +108,8 @@ TEST_CASE("RwLock") {
   RwLockTest(7, 1, 1000000);
   RwLockTest(4, 4, 1000000);
 }
+
+TEST_CASE("Futex") {
+  FutexTest(1, 1000);
+  FutexTest(4, 1000);
+}
@@ -17,6 +17,8 @@
 #include "basic_test.h"
 #include "hermes_shm/util/singleton.h"
 #include "hermes_shm/util/type_switch.h"
+#include "hermes_shm/types/sharded_counter.h"
+#include <omp.h>
 #include <unistd.h>
 
 TEST_CASE("TypeSwitch") {
@@ -168,3 +170,20 @@ TEST_CASE("Singleton") {
     REQUIRE(cls[i]->a_ == 100);
   }
 }
+
+TEST_CASE("ShardedCounter") {
+  hshm::ipc::sharded_counter<size_t> counter;
+  REQUIRE(counter.load() == 0);
+  size_t nthreads = 8, count = 10000;
+  omp_set_dynamic(0);
+#pragma omp parallel shared(counter) num_threads(nthreads)
+  {
+    for (size_t i = 0; i < count; ++i) {
+      counter += 2;
+      --counter;
+    }
+  }
+  REQUIRE(counter.load() == nthreads * count);
+  counter = 5;
+  REQUIRE(counter.load() == 5);
+}